@@ -0,0 +1,355 @@
+/*
+ * Benchmark de escalado del criptoanálisis de Vigenère.
+ *
+ * Genera cifrados sintéticos repitiendo el corpus (files/quijote.txt) hasta
+ * cada tamaño pedido (10K - 10G) y cifrándolo con claves aleatorias de las
+ * longitudes pedidas. El cifrado va por trozos con VigenereCtx, que es lo que
+ * usa vigenere() por dentro: el resultado es el mismo que de una sola vez y no
+ * hace falta tener el texto entero en memoria.
+ *
+ * Cada modo de análisis corre en un proceso hijo (fork), así que el pico de
+ * RSS que devuelve wait4 es solo suyo. Por cada (tamaño, clave, modo) se
+ * anotan el tiempo, el pico de RSS y si se acertaron la longitud y la clave.
+ * Los resultados se escriben en JSON (un resultado por línea) y en CSV.
+ *
+ * Uso: bench_analisis -corpus fichero [-sizes 10K,1M,...] [-keys 5,9,14] [-seed s]
+ *                     [-tmp dir] [-o resultados.json] [-csv resultados.csv]
+ */
+#include "criptoAnalisisVigenere.h"
+#include "kasiskiExterno.h"
+#include "vigenere.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define KB 1024ULL
+#define MIN_SIZE (10 * KB)
+#define MAX_SIZE (10 * KB * KB * KB)
+#define GEN_BLOQUE (1 << 20)          // bytes cifrados de cada vez
+#define MAX_CLAVE MAX_K_CAND          // las claves más largas no las busca ningún modo
+#define KEXT_MEM ((size_t)64 << 20)  // límite de memoria del Kasiski externo
+
+typedef enum { M_CARGA, M_KASISKI, M_IC, M_STREAM, M_MUESTREO, M_KASISKI_EXT, N_MODOS } Modo;
+
+static const char *NOMBRES[N_MODOS] = {"carga", "kasiski", "ic", "stream", "muestreo", "kasiski_externo"};
+
+typedef struct {
+    const char *modo;
+    unsigned long long bytes;
+    int klen;
+    double secs;
+    long rss_kb;   // pico de RSS del hijo
+    int n;         // longitud estimada (-1: el modo no estima)
+    int long_ok;   // -1: no aplica
+    int clave_ok;  // -1: no aplica
+} Resultado;
+
+static Resultado *results = NULL;
+static int n_results = 0, cap_results = 0;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Lee el corpus completo */
+static char *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror("Error abriendo corpus"); return NULL; }
+    fseek(f, 0, SEEK_END);
+    long sz = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = malloc(sz > 0 ? (size_t)sz : 1);
+    if (!buf || sz <= 0 || fread(buf, 1, (size_t)sz, f) != (size_t)sz) {
+        fprintf(stderr, "Error leyendo corpus\n");
+        free(buf); fclose(f);
+        return NULL;
+    }
+    fclose(f);
+    *len = (size_t)sz;
+    return buf;
+}
+
+/* "10K", "16M", "2G" o bytes a secas; 0 si no se entiende */
+static unsigned long long parse_size(const char *s) {
+    char *end;
+    unsigned long long v = strtoull(s, &end, 10);
+    switch (*end) {
+    case 'k': case 'K': v *= KB; end++; break;
+    case 'm': case 'M': v *= KB * KB; end++; break;
+    case 'g': case 'G': v *= KB * KB * KB; end++; break;
+    }
+    return *end ? 0 : v;
+}
+
+static void size_str(unsigned long long b, char *out, size_t n) {
+    if (b >= KB * KB * KB && b % (KB * KB * KB) == 0) snprintf(out, n, "%lluG", b / (KB * KB * KB));
+    else if (b >= KB * KB && b % (KB * KB) == 0) snprintf(out, n, "%lluM", b / (KB * KB));
+    else if (b >= KB && b % KB == 0) snprintf(out, n, "%lluK", b / KB);
+    else snprintf(out, n, "%llu", b);
+}
+
+/* xorshift64*: claves reproducibles con la misma semilla */
+static uint64_t rnd(uint64_t *s) {
+    *s ^= *s >> 12;
+    *s ^= *s << 25;
+    *s ^= *s >> 27;
+    return *s * 0x2545F4914F6CDD1DULL;
+}
+
+// Clave aleatoria de exactamente len letras que no sea periódica (p. ej. ABAB),
+// porque el ataque la reduciría a su periodo y la daría por fallada
+static void random_key(uint64_t *s, int len, char *key) {
+    for (;;) {
+        for (int i = 0; i < len; ++i) key[i] = (char)('A' + rnd(s) % 26);
+        key[len] = '\0';
+        int periodica = 0;
+        for (int p = 1; p < len && !periodica; ++p) {
+            if (len % p) continue;
+            periodica = 1;
+            for (int i = p; i < len && periodica; ++i) periodica = key[i] == key[i - p];
+        }
+        if (!periodica) return;
+    }
+}
+
+/* Escribe en ruta el corpus repetido hasta bytes, cifrado con la clave */
+static int generate(const char *corpus, size_t clen, unsigned long long bytes, const char *key, const char *ruta) {
+    FILE *f = fopen(ruta, "wb");
+    char *buf = malloc(GEN_BLOQUE);
+    VigenereCtx ctx;
+    if (!f || !buf || vigenere_ctx_init(&ctx, key, 1) < 0) {
+        perror("Error generando el cifrado");
+        if (f) fclose(f);
+        free(buf);
+        return -1;
+    }
+    size_t off = 0;
+    int ok = 1;
+    for (unsigned long long done = 0; ok && done < bytes;) {
+        size_t n = bytes - done < GEN_BLOQUE ? (size_t)(bytes - done) : GEN_BLOQUE;
+        for (size_t k = 0; k < n;) {
+            size_t c = n - k < clen - off ? n - k : clen - off;
+            memcpy(buf + k, corpus + off, c);
+            k += c;
+            off = (off + c) % clen;
+        }
+        vigenere_ctx_aplicar(&ctx, buf, n);
+        ok = fwrite(buf, 1, n, f) == n;
+        done += n;
+    }
+    vigenere_ctx_free(&ctx);
+    free(buf);
+    if (fclose(f) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+/* Corre un modo sobre el cifrado; devuelve la longitud estimada (-1 si no estima) */
+static int run_mode(Modo m, const char *ruta, char *key) {
+    char *text = NULL;
+    int len = 0, n = -1;
+    FILE *in;
+    key[0] = '\0';
+    if (m == M_CARGA || m == M_KASISKI || m == M_IC) {
+        text = malloc(MAX_TEXT);
+        if (!text) return -1;
+        len = load_text(ruta, text);
+    }
+    switch (m) {
+    case M_CARGA:
+        break;
+    case M_KASISKI:
+        n = kasiski(text, len);
+        break;
+    case M_IC:
+        vigenere_ic_attack(text, len, MAX_K_CAND, "es", key);
+        break;
+    case M_STREAM:
+        if ((in = fopen(ruta, "rb"))) {
+            vigenere_ic_stream(in, MAX_K_CAND, "es", STREAM_MARGIN, key);
+            fclose(in);
+        }
+        break;
+    case M_MUESTREO:
+        vigenere_sample_attack(ruta, SAMPLE_WINDOWS, SAMPLE_WINDOW_BYTES, MAX_K_CAND, "es", 0, key);
+        break;
+    case M_KASISKI_EXT:
+        if ((in = fopen(ruta, "rb"))) {
+            n = kasiski_externo(in, KEXT_MEM, 0);
+            fclose(in);
+        }
+        break;
+    default:
+        break;
+    }
+    if (key[0]) n = (int)strlen(key);
+    free(text);
+    return n;
+}
+
+static Resultado *add_result(void) {
+    if (n_results == cap_results) {
+        int cap = cap_results ? 2 * cap_results : 64;
+        Resultado *r = realloc(results, (size_t)cap * sizeof(Resultado));
+        if (!r) return NULL;
+        results = r;
+        cap_results = cap;
+    }
+    return &results[n_results++];
+}
+
+/* Mide un modo en un proceso hijo: tiempo (medido por el hijo) y pico de RSS */
+static void bench_mode(Modo m, const char *ruta, unsigned long long bytes, const char *key) {
+    int fd[2];
+    if (pipe(fd) < 0) { perror("pipe"); return; }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) { perror("fork"); close(fd[0]); close(fd[1]); return; }
+    if (pid == 0) {
+        // Hijo: la salida del análisis no interesa, solo el resultado
+        close(fd[0]);
+        int nul = open("/dev/null", O_WRONLY);
+        if (nul >= 0) { dup2(nul, STDOUT_FILENO); dup2(nul, STDERR_FILENO); }
+        char rec[MAX_CLAVE + 1];
+        double t0 = now();
+        int n = run_mode(m, ruta, rec);
+        double t = now() - t0;
+        dprintf(fd[1], "%.9f %d %s\n", t, n, rec[0] ? rec : "-");
+        _exit(0);
+    }
+
+    close(fd[1]);
+    char line[256] = "";
+    ssize_t got, tot = 0;
+    while (tot < (ssize_t)sizeof(line) - 1 && (got = read(fd[0], line + tot, sizeof(line) - 1 - tot)) > 0) tot += got;
+    line[tot > 0 ? tot : 0] = '\0';
+    close(fd[0]);
+    int st;
+    struct rusage ru;
+    memset(&ru, 0, sizeof(ru));
+    wait4(pid, &st, 0, &ru);
+
+    Resultado *r = add_result();
+    if (!r) return;
+    char rec[MAX_CLAVE + 1] = "-";
+    r->modo = NOMBRES[m];
+    r->bytes = bytes;
+    r->klen = (int)strlen(key);
+    r->rss_kb = ru.ru_maxrss;
+    r->secs = 0.0;
+    r->n = -1;
+    if (!WIFEXITED(st) || sscanf(line, "%lf %d %30s", &r->secs, &r->n, rec) != 3)
+        fprintf(stderr, "Aviso: el modo %s no terminó bien\n", NOMBRES[m]);
+    r->long_ok = m == M_CARGA ? -1 : r->n == r->klen;
+    r->clave_ok = (m == M_IC || m == M_STREAM || m == M_MUESTREO) ? strcmp(rec, key) == 0 : -1;
+
+    char sz[16];
+    size_str(bytes, sz, sizeof(sz));
+    printf("  %-16s %6s  k=%-2d %10.4f s  %9ld KB  n=%-3d %-4s %s\n", r->modo, sz, r->klen, r->secs, r->rss_kb,
+           r->n, r->long_ok < 0 ? "-" : r->long_ok ? "ok" : "MAL",
+           r->clave_ok < 0 ? "" : r->clave_ok ? rec : "clave MAL");
+}
+
+static int write_json(const char *path, const char *corpus) {
+    FILE *f = fopen(path, "w");
+    if (!f) { perror("Error abriendo salida JSON"); return -1; }
+    fprintf(f, "{\n  \"corpus\": \"%s\",\n  \"results\": [\n", corpus);
+    for (int i = 0; i < n_results; ++i) {
+        const Resultado *r = &results[i];
+        fprintf(f, "    {\"modo\": \"%s\", \"bytes\": %llu, \"klen\": %d, \"secs\": %.6f, \"rss_kb\": %ld, "
+                   "\"n\": %d, \"long_ok\": %d, \"clave_ok\": %d}%s\n",
+                r->modo, r->bytes, r->klen, r->secs, r->rss_kb, r->n, r->long_ok, r->clave_ok,
+                i + 1 < n_results ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return 0;
+}
+
+static int write_csv(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) { perror("Error abriendo salida CSV"); return -1; }
+    fprintf(f, "modo,bytes,klen,secs,rss_kb,n,long_ok,clave_ok\n");
+    for (int i = 0; i < n_results; ++i) {
+        const Resultado *r = &results[i];
+        fprintf(f, "%s,%llu,%d,%.6f,%ld,%d,%d,%d\n", r->modo, r->bytes, r->klen, r->secs, r->rss_kb, r->n,
+                r->long_ok, r->clave_ok);
+    }
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *corpus_path = NULL, *out_path = NULL, *csv_path = NULL, *tmp = getenv("TMPDIR");
+    char sizes_arg[256] = "10K,1M", keys_arg[128] = "5,9,14";
+    uint64_t seed = 9391239;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-corpus") == 0 && i + 1 < argc) corpus_path = argv[++i];
+        else if (strcmp(argv[i], "-sizes") == 0 && i + 1 < argc) snprintf(sizes_arg, sizeof(sizes_arg), "%s", argv[++i]);
+        else if (strcmp(argv[i], "-keys") == 0 && i + 1 < argc) snprintf(keys_arg, sizeof(keys_arg), "%s", argv[++i]);
+        else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-tmp") == 0 && i + 1 < argc) tmp = argv[++i];
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) out_path = argv[++i];
+        else if (strcmp(argv[i], "-csv") == 0 && i + 1 < argc) csv_path = argv[++i];
+        else {
+            fprintf(stderr, "Uso: %s -corpus fichero [-sizes 10K,1M,...] [-keys 5,9,14] [-seed s] [-tmp dir] "
+                            "[-o resultados.json] [-csv resultados.csv]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!corpus_path) {
+        fprintf(stderr, "Debes indicar el corpus con -corpus\n");
+        return EXIT_FAILURE;
+    }
+    if (seed == 0) seed = 1; // xorshift se queda en 0 para siempre
+
+    size_t clen;
+    char *corpus = read_file(corpus_path, &clen);
+    if (!corpus) return EXIT_FAILURE;
+
+    int klens[32], nk = 0;
+    for (char *tok = strtok(keys_arg, ","); tok && nk < 32; tok = strtok(NULL, ",")) {
+        int k = atoi(tok);
+        if (k < 1 || k > MAX_CLAVE) fprintf(stderr, "Longitud de clave fuera de rango (1-%d): %s\n", MAX_CLAVE, tok);
+        else klens[nk++] = k;
+    }
+
+    char ruta[4096];
+    snprintf(ruta, sizeof(ruta), "%s/bench_analisis_%ld.enc", tmp && *tmp ? tmp : "/tmp", (long)getpid());
+
+    printf("=== Benchmark de criptoanálisis (corpus %s, %zu bytes) ===\n", corpus_path, clen);
+    for (char *tok = strtok(sizes_arg, ","); tok; tok = strtok(NULL, ",")) {
+        unsigned long long bytes = parse_size(tok);
+        if (bytes < MIN_SIZE || bytes > MAX_SIZE) {
+            fprintf(stderr, "Tamaño fuera de rango (10K-10G): %s\n", tok);
+            continue;
+        }
+        for (int k = 0; k < nk; ++k) {
+            char key[MAX_CLAVE + 1];
+            random_key(&seed, klens[k], key);
+            double t0 = now();
+            if (generate(corpus, clen, bytes, key, ruta) < 0) {
+                unlink(ruta);
+                continue;
+            }
+            printf("[%s, clave %s: generado en %.2f s]\n", tok, key, now() - t0);
+            for (int m = 0; m < N_MODOS; ++m) bench_mode((Modo)m, ruta, bytes, key);
+            unlink(ruta);
+        }
+    }
+    free(corpus);
+
+    int ret = EXIT_SUCCESS;
+    if (out_path && write_json(out_path, corpus_path) < 0) ret = EXIT_FAILURE;
+    if (csv_path && write_csv(csv_path) < 0) ret = EXIT_FAILURE;
+    free(results);
+    return ret;
+}
@@ -0,0 +1,278 @@
+/*
+ * Benchmark de rendimiento de los kernels de libcripto.
+ *
+ * Replica el corpus (files/quijote.txt) en memoria hasta cada tamaño pedido
+ * (1 MB - 1 GB) y mide MB/s y ns/letra de cada kernel. Entrada y salida van
+ * por fmemopen/open_memstream, así que se mide el cifrado y no el disco.
+ * Los resultados se escriben en JSON (un resultado por línea) y, si se da
+ * una línea base, se imprime la aceleración respecto a ella.
+ *
+ * Uso: bench -corpus fichero -sizes 1,16,... [-o results.json] [-baseline base.json]
+ */
+#include "afin.h"
+#include "afin_modificado.h"
+#include "euclides.h"
+#include "vigenere.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <gmp.h>
+
+#define MB (1024UL * 1024UL)
+#define MAX_SIZE_MB 1024
+#define MAX_RESULTS 128
+#define EUC_PAIRS 100000   // pares (a, b) para extended_euclides
+#define EUC_BITS 128       // tamaño de los operandos
+
+typedef struct {
+    char kernel[32];
+    int size_mb;
+    double mb_s;       // MB de entrada por segundo
+    double ns_letter;  // ns por letra procesada
+    double ns_op;      // ns por operación (kernels sin texto: euclides)
+} BenchResult;
+
+static BenchResult results[MAX_RESULTS];
+static int n_results = 0;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void add_result(const char *kernel, int size_mb, double secs, size_t bytes, size_t letters) {
+    if (n_results == MAX_RESULTS) return;
+    BenchResult *r = &results[n_results++];
+    snprintf(r->kernel, sizeof(r->kernel), "%s", kernel);
+    r->size_mb = size_mb;
+    r->mb_s = secs > 0 ? ((double)bytes / MB) / secs : 0.0;
+    r->ns_letter = letters ? secs * 1e9 / (double)letters : 0.0;
+    r->ns_op = 0.0;
+    printf("  %-26s %5d MB  %10.2f MB/s  %10.2f ns/letra\n", kernel, size_mb, r->mb_s, r->ns_letter);
+}
+
+/* Lee el corpus completo */
+static char *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror("Error abriendo corpus"); return NULL; }
+    fseek(f, 0, SEEK_END);
+    long sz = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = malloc(sz > 0 ? (size_t)sz : 1);
+    if (!buf || fread(buf, 1, (size_t)sz, f) != (size_t)sz) {
+        fprintf(stderr, "Error leyendo corpus\n");
+        free(buf); fclose(f);
+        return NULL;
+    }
+    fclose(f);
+    *len = (size_t)sz;
+    return buf;
+}
+
+/* Replica el corpus hasta exactamente size bytes (terminado en '\0') */
+static char *replicate(const char *corpus, size_t clen, size_t size) {
+    char *buf = malloc(size + 1);
+    if (!buf) return NULL;
+    for (size_t off = 0; off < size; off += clen) {
+        size_t n = (size - off < clen) ? size - off : clen;
+        memcpy(buf + off, corpus, n);
+    }
+    buf[size] = '\0';
+    return buf;
+}
+
+typedef void (*FileKernel)(FILE *, FILE *, const mpz_t, const mpz_t, const mpz_t);
+
+/* Ejecuta un kernel FILE* -> FILE* sobre un buffer; devuelve la salida en *out */
+static double run_file_kernel(FileKernel fn, const char *in_buf, size_t in_len,
+                              const mpz_t a, const mpz_t b, const mpz_t m,
+                              char **out, size_t *out_len) {
+    FILE *in = fmemopen((void *)in_buf, in_len, "r");
+    FILE *o = open_memstream(out, out_len);
+    if (!in || !o) {
+        perror("fmemopen");
+        exit(EXIT_FAILURE);
+    }
+    double t0 = now();
+    fn(in, o, a, b, m);
+    fflush(o);
+    double t = now() - t0;
+    fclose(in);
+    fclose(o);
+    return t;
+}
+
+static void bench_size(const char *corpus, size_t clen, int size_mb) {
+    size_t size = (size_t)size_mb * MB;
+    char *plain = replicate(corpus, clen, size);
+    if (!plain) { fprintf(stderr, "Error: sin memoria para %d MB\n", size_mb); return; }
+
+    mpz_t a, b, m, a_blk, b_blk, M;
+    mpz_inits(a, b, m, a_blk, b_blk, M, NULL);
+    mpz_set_ui(a, 5);
+    mpz_set_ui(b, 8);
+    mpz_set_ui(m, 26);
+    mpz_set_str(a_blk, "36986419", 10);
+    mpz_set_str(b_blk, "2776385085840833906571070249467114581", 10);
+    compute_modulus(BLOCK_SIZE, M);
+
+    char *enc; size_t enc_len; char *dec; size_t dec_len; double t;
+
+    // Afín clásico
+    t = run_file_kernel(encriptar_afin, plain, size, a, b, m, &enc, &enc_len);
+    add_result("encriptar_afin", size_mb, t, size, enc_len);
+    t = run_file_kernel(decriptar_afin, enc, enc_len, a, b, m, &dec, &dec_len);
+    add_result("decriptar_afin", size_mb, t, enc_len, dec_len);
+    free(enc); free(dec);
+
+    // Afín por bloques
+    t = run_file_kernel(encriptar_afin_bloques, plain, size, a_blk, b_blk, M, &enc, &enc_len);
+    add_result("encriptar_afin_bloques", size_mb, t, size, enc_len);
+    t = run_file_kernel(decriptar_afin_bloques, enc, enc_len, a_blk, b_blk, M, &dec, &dec_len);
+    add_result("decriptar_afin_bloques", size_mb, t, enc_len, dec_len);
+    free(enc); free(dec);
+
+    // Afín con los otros alfabetos (m = 27 con Ñ, m = 256 bytes)
+    mpz_set_ui(m, 27);
+    t = run_file_kernel(encriptar_afin, plain, size, a, b, m, &enc, &enc_len);
+    add_result("encriptar_afin_es27", size_mb, t, size, enc_len);
+    free(enc);
+    mpz_set_ui(m, 256);
+    t = run_file_kernel(encriptar_afin, plain, size, a, b, m, &enc, &enc_len);
+    add_result("encriptar_afin_bytes", size_mb, t, size, enc_len);
+    free(enc);
+
+    // Vigenère (en memoria, sobre una copia)
+    size_t letters = 0;
+    for (size_t i = 0; i < size; ++i) {
+        char c = plain[i];
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) letters++;
+    }
+    double t0 = now();
+    vigenere(plain, "CLAVE", 1);
+    t = now() - t0;
+    add_result("vigenere", size_mb, t, size, letters);
+
+    mpz_clears(a, b, m, a_blk, b_blk, M, NULL);
+    free(plain);
+}
+
+static void bench_euclides(void) {
+    gmp_randstate_t rs;
+    gmp_randinit_default(rs);
+    gmp_randseed_ui(rs, 9391239);
+
+    mpz_t *xa = malloc(EUC_PAIRS * sizeof(mpz_t));
+    mpz_t *xb = malloc(EUC_PAIRS * sizeof(mpz_t));
+    if (!xa || !xb) { free(xa); free(xb); return; }
+    for (int i = 0; i < EUC_PAIRS; ++i) {
+        mpz_init(xa[i]); mpz_urandomb(xa[i], rs, EUC_BITS);
+        mpz_init(xb[i]); mpz_urandomb(xb[i], rs, EUC_BITS);
+    }
+
+    double t0 = now();
+    for (int i = 0; i < EUC_PAIRS; ++i) {
+        ExtendedEuclidesResult r = extended_euclides(xa[i], xb[i]);
+        mpz_clears(r.mcd, r.s, r.t, NULL);
+    }
+    double t = now() - t0;
+
+    BenchResult *r = &results[n_results++];
+    snprintf(r->kernel, sizeof(r->kernel), "extended_euclides");
+    r->size_mb = 0;
+    r->mb_s = 0.0;
+    r->ns_letter = 0.0;
+    r->ns_op = t * 1e9 / EUC_PAIRS;
+    printf("  %-26s %d pares de %d bits  %10.2f ns/par\n", r->kernel, EUC_PAIRS, EUC_BITS, r->ns_op);
+
+    for (int i = 0; i < EUC_PAIRS; ++i) mpz_clears(xa[i], xb[i], NULL);
+    free(xa); free(xb);
+    gmp_randclear(rs);
+}
+
+static int write_json(const char *path, const char *corpus) {
+    FILE *f = fopen(path, "w");
+    if (!f) { perror("Error abriendo salida JSON"); return -1; }
+    fprintf(f, "{\n  \"corpus\": \"%s\",\n  \"results\": [\n", corpus);
+    for (int i = 0; i < n_results; ++i) {
+        const BenchResult *r = &results[i];
+        fprintf(f, "    {\"kernel\": \"%s\", \"size_mb\": %d, \"mb_s\": %.3f, \"ns_letter\": %.3f, \"ns_op\": %.3f}%s\n",
+                r->kernel, r->size_mb, r->mb_s, r->ns_letter, r->ns_op, i + 1 < n_results ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return 0;
+}
+
+/* Compara con una línea base escrita por write_json */
+static void compare_baseline(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        printf("\nSin línea base (%s): nada que comparar\n", path);
+        return;
+    }
+    printf("\nComparación con %s:\n", path);
+    printf("  %-26s %5s  %12s  %12s  %8s\n", "kernel", "MB", "actual", "base", "speedup");
+
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        BenchResult base;
+        const char *p = strstr(line, "{\"kernel\"");
+        if (!p || sscanf(p, "{\"kernel\": \"%31[^\"]\", \"size_mb\": %d, \"mb_s\": %lf, \"ns_letter\": %lf, \"ns_op\": %lf}",
+                         base.kernel, &base.size_mb, &base.mb_s, &base.ns_letter, &base.ns_op) != 5)
+            continue;
+        for (int i = 0; i < n_results; ++i) {
+            const BenchResult *r = &results[i];
+            if (strcmp(r->kernel, base.kernel) != 0 || r->size_mb != base.size_mb) continue;
+            if (r->ns_op > 0 && base.ns_op > 0)
+                printf("  %-26s %5s  %9.2f ns  %9.2f ns  %7.2fx\n", r->kernel, "-",
+                       r->ns_op, base.ns_op, base.ns_op / r->ns_op);
+            else if (base.mb_s > 0)
+                printf("  %-26s %5d  %7.2f MB/s  %7.2f MB/s  %7.2fx\n", r->kernel, r->size_mb,
+                       r->mb_s, base.mb_s, r->mb_s / base.mb_s);
+        }
+    }
+    fclose(f);
+}
+
+int main(int argc, char *argv[]) {
+    const char *corpus_path = NULL, *out_path = NULL, *base_path = NULL;
+    char sizes_arg[256] = "1";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-corpus") == 0 && i + 1 < argc) corpus_path = argv[++i];
+        else if (strcmp(argv[i], "-sizes") == 0 && i + 1 < argc) snprintf(sizes_arg, sizeof(sizes_arg), "%s", argv[++i]);
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) out_path = argv[++i];
+        else if (strcmp(argv[i], "-baseline") == 0 && i + 1 < argc) base_path = argv[++i];
+        else {
+            fprintf(stderr, "Uso: %s -corpus fichero [-sizes 1,16,...] [-o results.json] [-baseline base.json]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!corpus_path) {
+        fprintf(stderr, "Debes indicar el corpus con -corpus\n");
+        return EXIT_FAILURE;
+    }
+
+    size_t clen;
+    char *corpus = read_file(corpus_path, &clen);
+    if (!corpus) return EXIT_FAILURE;
+
+    printf("=== Benchmark libcripto (corpus %s, %zu bytes) ===\n", corpus_path, clen);
+    for (char *tok = strtok(sizes_arg, ","); tok; tok = strtok(NULL, ",")) {
+        int mb = atoi(tok);
+        if (mb < 1 || mb > MAX_SIZE_MB) {
+            fprintf(stderr, "Tamaño fuera de rango (1-%d MB): %s\n", MAX_SIZE_MB, tok);
+            continue;
+        }
+        bench_size(corpus, clen, mb);
+    }
+    bench_euclides();
+    free(corpus);
+
+    if (out_path && write_json(out_path, corpus_path) < 0) return EXIT_FAILURE;
+    if (base_path) compare_baseline(base_path);
+    return EXIT_SUCCESS;
+}
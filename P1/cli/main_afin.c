@@ -0,0 +1,106 @@
+#include "afin.h"
+#include "alfabeto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Main function to test the encryption and decryption functions.
+ * @param argc Argument count.
+ * @param argv Argument vector.
+ * @return Exit status.
+ * -C: encrypt
+ * -D: decrypt
+ * -m: modulo (26, 27 o 256: elige el alfabeto)
+ * -alf: alfabeto por nombre (latin26, es27, bytes), en lugar de -m
+ * -a: multiplicative key
+ * -b: additive key
+ * -i: input file (default: stdin)
+ * -o: output file (default: stdout)
+ */
+int main(int argc, char *argv[]) {
+    if (argc < 8) {  
+        fprintf(stderr, "Uso: %s -C|-D -m <modulo>|-alf <alfabeto> -a <clave_mult> -b <clave_add> [-i <input>] [-o <output>]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int int_m = 0, int_a = 0, int_b = 0;
+    int mode = -1;
+    const char *input_path = NULL;
+    const char *output_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-C") == 0) {
+            mode = CIPHER_AFIN;
+        } else if (strcmp(argv[i], "-D") == 0) {
+            mode = DECIPHER_AFIN;
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            int_m = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-alf") == 0 && i + 1 < argc) {
+            const Alfabeto *alf = alfabeto_por_nombre(argv[++i]);
+            if (!alf) {
+                fprintf(stderr, "Alfabeto desconocido: %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+            int_m = alf->m;
+        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            int_a = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            int_b = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            input_path = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else {
+            fprintf(stderr, "Argumento no reconocido: %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Inicializar GMP
+    mpz_t m, a, b;
+    mpz_inits(m, a, b, NULL);
+
+    // Asignar valores de los int a mpz_t
+    mpz_set_ui(m, int_m);
+    mpz_set_ui(a, int_a);
+    mpz_set_ui(b, int_b);
+
+    // Abrir ficheros
+    FILE *in = stdin;
+    FILE *out = stdout;
+    if (input_path) {
+        in = fopen(input_path, "r");
+        if (!in) {
+            perror("Error abriendo input");
+            return EXIT_FAILURE;
+        }
+    }
+    if (output_path) {
+        out = fopen(output_path, "w");
+        if (!out) {
+            perror("Error abriendo output");
+            if (in != stdin) fclose(in);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Ejecutar cifrado/descifrado
+    if (mode == CIPHER_AFIN) {
+        encriptar_afin(in, out, a, b, m);
+    } else if (mode == DECIPHER_AFIN) {
+        decriptar_afin(in, out, a, b, m);
+    } else {
+        fprintf(stderr, "Debes especificar -C (cifrar) o -D (descifrar).\n");
+        return EXIT_FAILURE;
+    }
+
+    // Cerrar ficheros
+    if (in != stdin) fclose(in);
+    if (out != stdout) fclose(out);
+
+    // Liberar GMP
+    mpz_clears(m, a, b, NULL);
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
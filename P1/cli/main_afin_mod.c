@@ -0,0 +1,103 @@
+#include "afin_modificado.h"
+#include "afin.h"
+#include "alfabeto.h"
+#include "gmpPool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gmp.h>
+
+/* ---------- Programa principal ---------- */
+
+int main(int argc, char *argv[]) {
+    if (argc < 8) {
+        fprintf(stderr, "Uso: %s -C|-D [-m 26|27|256 | -alf alfabeto] -a <clave_mult> -b <clave_add> [-i in] [-o out]\n"
+                        "        [-index f] [-offset byte -length bytes] [-aio auto|uring|hilos [-direct] [-bufs N] [-bufsize KB]]\n"
+                        "        [-gmp] [-pool]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int mode = -1;
+    const char *input_path = NULL, *output_path = NULL, *index_path = NULL;
+    unsigned long long offset = 0, length = (unsigned long long)-1; // sin -length: hasta el final
+    int rango = 0;
+    char *a_str = NULL, *b_str = NULL;
+    const Alfabeto *alf = alfabeto_por_m(26);
+    EsOpciones es = { ES_AUTO, 0, 0, 0 };
+    int aio = 0, pool = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-C")) mode = 0;
+        else if (!strcmp(argv[i], "-D")) mode = 1;
+        else if (!strcmp(argv[i], "-m") && i + 1 < argc) alf = alfabeto_por_m(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "-alf") && i + 1 < argc) alf = alfabeto_por_nombre(argv[++i]);
+        else if (!strcmp(argv[i], "-a") && i + 1 < argc) a_str = argv[++i];
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc) b_str = argv[++i];
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc) input_path = argv[++i];
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) output_path = argv[++i];
+        else if (!strcmp(argv[i], "-index") && i + 1 < argc) index_path = argv[++i];
+        else if (!strcmp(argv[i], "-offset") && i + 1 < argc) { offset = strtoull(argv[++i], NULL, 10); rango = 1; }
+        else if (!strcmp(argv[i], "-length") && i + 1 < argc) { length = strtoull(argv[++i], NULL, 10); rango = 1; }
+        else if (!strcmp(argv[i], "-aio") && i + 1 < argc) {
+            const char *m = argv[++i];
+            aio = 1;
+            es.motor = !strcmp(m, "uring") ? ES_URING : !strcmp(m, "hilos") ? ES_HILOS : ES_AUTO;
+        }
+        else if (!strcmp(argv[i], "-direct")) es.directo = 1;
+        else if (!strcmp(argv[i], "-bufs") && i + 1 < argc) es.nbufs = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-bufsize") && i + 1 < argc) es.tam_buf = (size_t)atoi(argv[++i]) * 1024;
+        else if (!strcmp(argv[i], "-gmp")) afin_mod_sin_fusion();
+        else if (!strcmp(argv[i], "-pool")) pool = 1;
+    }
+    // Antes de cualquier mpz_t
+    if (pool) gmp_pool_instalar();
+
+    if (!alf) {
+        fprintf(stderr, "Alfabeto no válido (m = 26, 27 o 256; latin26, es27 o bytes).\n");
+        return EXIT_FAILURE;
+    }
+    if (rango && (mode != 1 || !input_path)) {
+        fprintf(stderr, "-offset/-length solo al descifrar un fichero (-D -i cifrado).\n");
+        return EXIT_FAILURE;
+    }
+    if (rango && aio) {
+        fprintf(stderr, "-aio no se combina con -offset/-length.\n");
+        return EXIT_FAILURE;
+    }
+
+    FILE *in = input_path ? fopen(input_path, "r") : stdin;
+    FILE *out = output_path ? fopen(output_path, "w") : stdout;
+    if (!in || !out) { perror("fopen"); return EXIT_FAILURE; }
+
+    mpz_t a, b;
+    mpz_inits(a, b, NULL);
+    mpz_set_str(a, a_str, 10);
+    mpz_set_str(b, b_str, 10);
+
+    int ret = EXIT_SUCCESS;
+    if (aio && (mode == 0 || mode == 1))
+        ret = afin_bloques_es(in, out, alf, a, b, mode == 0 ? CIPHER_AFIN : DECIPHER_AFIN, index_path, &es) < 0
+                  ? EXIT_FAILURE
+                  : EXIT_SUCCESS;
+    else if (mode == 0)
+        ret = encriptar_afin_bloques_indice(in, out, alf, a, b, index_path) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    else if (mode == 1 && rango)
+        ret = decriptar_afin_bloques_rango(in, out, alf, a, b, index_path, offset, length) < 0 ? EXIT_FAILURE
+                                                                                                : EXIT_SUCCESS;
+    else if (mode == 1)
+        decriptar_afin_bloques_alf(in, out, alf, a, b);
+    else
+        fprintf(stderr, "Debes indicar -C o -D.\n");
+
+    mpz_clears(a, b, NULL);
+    if (pool) {
+        GmpPoolEstad st;
+        gmp_pool_estad(&st);
+        fprintf(stderr, "GMP: %llu peticiones, %llu malloc, %llu reutilizados\n", (unsigned long long)st.peticiones,
+                (unsigned long long)st.mallocs, (unsigned long long)st.reutilizados);
+        gmp_pool_liberar();
+    }
+    if (in != stdin) fclose(in);
+    if (out != stdout) fclose(out);
+    return ret;
+}
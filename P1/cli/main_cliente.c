@@ -0,0 +1,143 @@
+#include "afin.h"
+#include "alfabeto.h"
+#include "pipeline.h"
+#include "servicio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static void uso(const char *prog) {
+    fprintf(stderr, "Uso: %s {afin|afin_mod|vigenere} -C|-D [-m 26|27|256 | -alf alfabeto]\n"
+                    "        {-k clave | -a <clave_mult> -b <clave_add>} [-i in] [-o out]\n"
+                    "        [-socket ruta] [-repeat N]\n", prog);
+    fprintf(stderr, "  mismas opciones que los ejecutables de cada cifrado, pero lo cifra el\n"
+                    "  servicio (cripto serve); -repeat manda N veces el mensaje y mide la latencia\n");
+}
+
+/* Lee toda la entrada (el servicio es para mensajes pequeños) */
+static char *leer_entrada(FILE *in, size_t *len) {
+    size_t cap = 4096, n = 0, got;
+    char *buf = malloc(cap);
+    while (buf && (got = fread(buf + n, 1, cap - n, in)) > 0) {
+        n += got;
+        if (n == cap) {
+            char *p = cap < SERV_MAX_DATOS ? realloc(buf, cap *= 2) : NULL;
+            if (!p) {
+                fprintf(stderr, "Error: el mensaje supera %u bytes\n", SERV_MAX_DATOS);
+                free(buf);
+                return NULL;
+            }
+            buf = p;
+        }
+    }
+    *len = n;
+    return buf;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        uso(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ServPeticion p;
+    memset(&p, 0, sizeof(p));
+    p.magic = SERV_MAGIC;
+    if (strcmp(argv[1], "vigenere") == 0) p.cifrado = PIPE_VIGENERE;
+    else if (strcmp(argv[1], "afin") == 0) p.cifrado = PIPE_AFIN;
+    else if (strcmp(argv[1], "afin_mod") == 0) p.cifrado = PIPE_AFIN_MOD;
+    else {
+        fprintf(stderr, "Cifrado desconocido: %s\n", argv[1]);
+        uso(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int mode = -1, repeat = 1;
+    const char *input_path = NULL, *output_path = NULL, *ruta = NULL, *key = NULL, *a_str = NULL, *b_str = NULL;
+    const Alfabeto *alf = alfabeto_por_m(26);
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-C") == 0) mode = CIPHER_AFIN;
+        else if (strcmp(argv[i], "-D") == 0) mode = DECIPHER_AFIN;
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) alf = alfabeto_por_m(atoi(argv[++i]));
+        else if (strcmp(argv[i], "-alf") == 0 && i + 1 < argc) alf = alfabeto_por_nombre(argv[++i]);
+        else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) key = argv[++i];
+        else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) a_str = argv[++i];
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) b_str = argv[++i];
+        else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) input_path = argv[++i];
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) output_path = argv[++i];
+        else if (strcmp(argv[i], "-socket") == 0 && i + 1 < argc) ruta = argv[++i];
+        else if (strcmp(argv[i], "-repeat") == 0 && i + 1 < argc) repeat = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "Argumento no reconocido: %s\n", argv[i]);
+            uso(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // La clave viaja en texto, como en las etapas de cripto pipe
+    char clave[SERV_MAX_CLAVE + 1];
+    if (p.cifrado == PIPE_VIGENERE && key)
+        snprintf(clave, sizeof(clave), "%s", key);
+    else if (p.cifrado != PIPE_VIGENERE && a_str && b_str)
+        snprintf(clave, sizeof(clave), "%s,%s", a_str, b_str);
+    else
+        mode = -1;
+    if (mode == -1 || !alf || repeat < 1) {
+        uso(argv[0]);
+        return EXIT_FAILURE;
+    }
+    p.modo = (uint8_t)mode;
+    p.alf = (uint8_t)alf->id;
+    p.clave_len = (uint32_t)strlen(clave);
+
+    FILE *in = input_path ? fopen(input_path, "rb") : stdin;
+    if (!in) { perror("Error abriendo input"); return EXIT_FAILURE; }
+    size_t len;
+    char *datos = leer_entrada(in, &len);
+    if (in != stdin) fclose(in);
+    if (!datos) return EXIT_FAILURE;
+    p.datos_len = (uint32_t)len;
+
+    int fd = servicio_conectar(ruta);
+    if (fd < 0) {
+        perror(ruta ? ruta : SERV_SOCKET);
+        free(datos);
+        return EXIT_FAILURE;
+    }
+
+    unsigned char *resp = NULL;
+    size_t cap = 0, resp_len = 0;
+    int estado = 0;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int r = 0; r < repeat && estado == SERV_OK; ++r)
+        estado = servicio_pedir(fd, &p, clave, datos, &resp, &cap, &resp_len);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    close(fd);
+    free(datos);
+
+    int ret = EXIT_FAILURE;
+    if (estado < 0) {
+        fprintf(stderr, "Error: se perdió la conexión con el servicio\n");
+    } else if (estado != SERV_OK) {
+        fprintf(stderr, "Error del servicio: %s\n", estado == SERV_ERR_CLAVE ? "clave no válida"
+                                                  : estado == SERV_ERR_MEMORIA ? "sin memoria"
+                                                                               : "petición no válida");
+    } else {
+        FILE *out = output_path ? fopen(output_path, "wb") : stdout;
+        if (!out) {
+            perror("Error abriendo output");
+        } else {
+            if (fwrite(resp, 1, resp_len, out) == resp_len) ret = EXIT_SUCCESS;
+            if (out != stdout) fclose(out);
+        }
+        if (repeat > 1) {
+            double us = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / 1e3 / repeat;
+            fprintf(stderr, "%d peticiones de %zu bytes: %.2f us por mensaje\n", repeat, len, us);
+        }
+    }
+    free(resp);
+    return ret;
+}
@@ -0,0 +1,265 @@
+#include "afin.h"
+#include "alfabeto.h"
+#include "criptoAnalisisVigenere.h"
+#include "pipeline.h"
+#include "servicio.h"
+#include "triaje.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <gmp.h>
+
+static void uso(const char *prog) {
+    fprintf(stderr, "Uso: %s pipe -C|-D -s etapa [-s etapa ...] [-alf alfabeto] [-i in] [-o out]\n", prog);
+    fprintf(stderr, "     %s serve [-socket ruta] [-threads n]\n", prog);
+    fprintf(stderr, "     %s triage [-threads n] [-lang es|en] [-dispatch] [-crib texto] [-list f|-] ficheros...\n", prog);
+    fprintf(stderr, "  etapas: vigenere:CLAVE | afin:a,b | afin_mod:a,b\n");
+    fprintf(stderr, "  alfabetos: latin26 (por defecto) | es27 | bytes\n");
+    fprintf(stderr, "  con -D se deshacen las mismas etapas en orden inverso\n");
+    fprintf(stderr, "  serve: servicio residente en un socket Unix (%s por defecto), ver cliente\n", SERV_SOCKET);
+    fprintf(stderr, "  triage: clasifica cada fichero (afin, vigenere, afin_mod...) y con -dispatch lo ataca\n");
+}
+
+/* Interpreta "tipo:parametros"; a y b quedan inicializados aunque falle */
+static int parse_etapa(char *arg, PipeEtapaSpec *s) {
+    mpz_inits(s->a, s->b, NULL);
+    s->clave = NULL;
+    char *p = strchr(arg, ':');
+    if (!p) return -1;
+    *p++ = '\0';
+
+    if (strcmp(arg, "vigenere") == 0) {
+        s->tipo = PIPE_VIGENERE;
+        s->clave = p;
+        return *p ? 0 : -1;
+    }
+    if (strcmp(arg, "afin") == 0) s->tipo = PIPE_AFIN;
+    else if (strcmp(arg, "afin_mod") == 0) s->tipo = PIPE_AFIN_MOD;
+    else return -1;
+
+    char *coma = strchr(p, ',');
+    if (!coma) return -1;
+    *coma++ = '\0';
+    if (mpz_set_str(s->a, p, 10) < 0 || mpz_set_str(s->b, coma, 10) < 0) return -1;
+    return 0;
+}
+
+static int cmd_pipe(int argc, char *argv[]) {
+    PipeEtapaSpec etapas[PIPE_MAX_ETAPAS];
+    int n = 0, mode = -1, ret = EXIT_FAILURE;
+    const char *input_path = NULL, *output_path = NULL;
+    const Alfabeto *alf = alfabeto_por_nombre("latin26");
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-C") == 0) {
+            mode = CIPHER_AFIN;
+        } else if (strcmp(argv[i], "-D") == 0) {
+            mode = DECIPHER_AFIN;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            if (n == PIPE_MAX_ETAPAS) {
+                fprintf(stderr, "Demasiadas etapas (máximo %d)\n", PIPE_MAX_ETAPAS);
+                goto fin;
+            }
+            if (parse_etapa(argv[++i], &etapas[n]) < 0) {
+                fprintf(stderr, "Etapa no válida: %s\n", argv[i]);
+                mpz_clears(etapas[n].a, etapas[n].b, NULL);
+                goto fin;
+            }
+            n++;
+        } else if (strcmp(argv[i], "-alf") == 0 && i + 1 < argc) {
+            if (!(alf = alfabeto_por_nombre(argv[++i]))) {
+                fprintf(stderr, "Alfabeto desconocido: %s\n", argv[i]);
+                goto fin;
+            }
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            input_path = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else {
+            fprintf(stderr, "Argumento no reconocido: %s\n", argv[i]);
+            uso(argv[0]);
+            goto fin;
+        }
+    }
+    if (mode == -1 || n == 0) {
+        uso(argv[0]);
+        goto fin;
+    }
+
+    FILE *in = stdin, *out = stdout;
+    if (input_path && !(in = fopen(input_path, "r"))) {
+        perror("Error abriendo input");
+        goto fin;
+    }
+    if (output_path && !(out = fopen(output_path, "w"))) {
+        perror("Error abriendo output");
+        if (in != stdin) fclose(in);
+        goto fin;
+    }
+
+    if (pipeline_ejecutar(in, out, alf, etapas, n, mode) == 0) ret = EXIT_SUCCESS;
+
+    if (in != stdin) fclose(in);
+    if (out != stdout) fclose(out);
+fin:
+    for (int i = 0; i < n; i++) mpz_clears(etapas[i].a, etapas[i].b, NULL);
+    return ret;
+}
+
+static int cmd_serve(int argc, char *argv[]) {
+    const char *ruta = SERV_SOCKET;
+    int hilos = 0;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-socket") == 0 && i + 1 < argc) {
+            ruta = argv[++i];
+        } else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+            hilos = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Argumento no reconocido: %s\n", argv[i]);
+            uso(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    return servicio_ejecutar(ruta, hilos) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* Añade a la lista las rutas de un fichero (una por línea; "-" es stdin) */
+static int leer_lista(const char *path, char ***rutas, int *n, int *cap) {
+    FILE *f = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    char linea[4096];
+    while (fgets(linea, sizeof(linea), f)) {
+        linea[strcspn(linea, "\r\n")] = '\0';
+        if (!linea[0]) continue;
+        if (*n == *cap) {
+            int nuevo = *cap ? 2 * *cap : 1024;
+            char **r = realloc(*rutas, (size_t)nuevo * sizeof(char *));
+            if (!r) break;
+            *rutas = r;
+            *cap = nuevo;
+        }
+        (*rutas)[(*n)++] = strdup(linea);
+    }
+    if (f != stdin) fclose(f);
+    return 0;
+}
+
+/* Ataque que corresponde a la clasificación */
+static void despachar(const char *ruta, const Triaje *t, const char *lang, const char *crib) {
+    const Alfabeto *alf = t->alf == ALF_ES27 ? alfabeto_por_nombre("es27")
+                        : t->alf == ALF_BYTES ? alfabeto_por_nombre("bytes") : alfabeto_por_nombre("latin26");
+    printf("\n=== %s: %s ===\n", ruta, triaje_nombre(t->tipo));
+    if (t->tipo == TRIAJE_VIGENERE && t->alf == ALF_LATIN26) {
+        char *text = malloc(MAX_TEXT), clave[MAX_K_CAND + 1];
+        if (!text) return;
+        int len = load_text(ruta, text);
+        // Con el periodo del triaje no hace falta volver a recorrer todos los n
+        if (t->periodo > 0) vigenere_ic_attack_rango(text, len, t->periodo, t->periodo, lang, clave);
+        else vigenere_ic_attack(text, len, MAX_K_CAND, lang, clave);
+        free(text);
+    } else if (t->tipo == TRIAJE_AFIN && t->alf != ALF_BYTES) {
+        int a = 1, b = 0;
+        double chi2 = afin_mono_ataque(t->hist, alf->m, lang, &a, &b);
+        printf(">>> Clave estimada: a = %d, b = %d (χ² por letra %.3f)\n", a, b, chi2);
+        printf("    afin -D -alf %s -a %d -b %d -i %s\n", alf->nombre, a, b, ruta);
+    } else if (t->tipo == TRIAJE_BLOQUES) {
+        printf("Afín por bloques: hace falta texto claro conocido\n");
+        printf("    criptoAnalisisAfin -crib %s -alf %s -i %s\n", crib ? crib : "<texto>", alf->nombre, ruta);
+    } else if (t->tipo == TRIAJE_VIGENERE || t->tipo == TRIAJE_AFIN) {
+        printf("Sin analizador automático para el alfabeto %s\n", alf->nombre);
+    } else {
+        printf("Nada que atacar\n");
+    }
+}
+
+static int cmd_triage(int argc, char *argv[]) {
+    const char *lang = "es", *crib = NULL;
+    int hilos = 0, dispatch = 0, n = 0, cap = 0, ret = EXIT_FAILURE;
+    char **rutas = NULL;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+            hilos = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-lang") == 0 && i + 1 < argc) {
+            lang = argv[++i];
+        } else if (strcmp(argv[i], "-dispatch") == 0) {
+            dispatch = 1;
+        } else if (strcmp(argv[i], "-crib") == 0 && i + 1 < argc) {
+            crib = argv[++i];
+        } else if (strcmp(argv[i], "-list") == 0 && i + 1 < argc) {
+            if (leer_lista(argv[++i], &rutas, &n, &cap) < 0) goto fin;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Argumento no reconocido: %s\n", argv[i]);
+            uso(argv[0]);
+            goto fin;
+        } else {
+            if (n == cap) {
+                cap = cap ? 2 * cap : 1024;
+                char **r = realloc(rutas, (size_t)cap * sizeof(char *));
+                if (!r) goto fin;
+                rutas = r;
+            }
+            rutas[n++] = strdup(argv[i]);
+        }
+    }
+    if (n == 0) {
+        uso(argv[0]);
+        goto fin;
+    }
+
+    Triaje *res = calloc((size_t)n, sizeof(Triaje));
+    if (!res) goto fin;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    triaje_ficheros(rutas, n, lang, hilos, res);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+    static const char *ALF[] = { "latin26", "es27", "bytes" };
+    printf("%-32s %-11s %-7s %7s %9s %7s %7s %7s %7s %7s\n", "fichero", "tipo", "alf", "periodo", "simbolos",
+           "IC", "ICper", "ICblq", "chi2", "formato");
+    int errores = 0;
+    for (int i = 0; i < n; ++i) {
+        const Triaje *t = &res[i];
+        if (t->tipo == TRIAJE_ERROR) {
+            printf("%-32s %-11s\n", rutas[i], triaje_nombre(t->tipo));
+            errores++;
+            continue;
+        }
+        char periodo[16] = "-";
+        if (t->tipo == TRIAJE_VIGENERE)
+            snprintf(periodo, sizeof(periodo), t->periodo ? "%d" : ">%d", t->periodo ? t->periodo : TRIAJE_MAX_N);
+        printf("%-32s %-11s %-7s %7s %9llu %7.4f %7.4f %7.4f %7.3f %7.3f\n", rutas[i], triaje_nombre(t->tipo),
+               ALF[t->alf], periodo, (unsigned long long)t->simbolos, t->ic, t->ic_periodo, t->ic_bloque, t->chi2,
+               t->formato);
+    }
+    fprintf(stderr, "%d ficheros en %.3f s (%.0f ficheros/s)%s\n", n, secs, secs > 0 ? n / secs : 0.0,
+            errores ? ", con errores de lectura" : "");
+    if (dispatch)
+        for (int i = 0; i < n; ++i)
+            if (res[i].tipo != TRIAJE_ERROR && res[i].tipo != TRIAJE_CORTO && res[i].tipo != TRIAJE_CLARO)
+                despachar(rutas[i], &res[i], lang, crib);
+    free(res);
+    ret = errores ? EXIT_FAILURE : EXIT_SUCCESS;
+fin:
+    for (int i = 0; i < n; ++i) free(rutas[i]);
+    free(rutas);
+    return ret;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        uso(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (strcmp(argv[1], "pipe") == 0) return cmd_pipe(argc, argv);
+    if (strcmp(argv[1], "serve") == 0) return cmd_serve(argc, argv);
+    if (strcmp(argv[1], "triage") == 0) return cmd_triage(argc, argv);
+
+    fprintf(stderr, "Orden desconocida: %s\n", argv[1]);
+    uso(argv[0]);
+    return EXIT_FAILURE;
+}
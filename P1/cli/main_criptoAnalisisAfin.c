@@ -0,0 +1,104 @@
+#include "criptoAnalisisAfin.h"
+#include "afin_modificado.h"
+#include "alfabeto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <gmp.h>
+
+#define LECTURA 65536   // bytes por lectura
+#define CRIB_MAX 4096   // bytes de -cribf que se usan como crib
+
+/* Lee un fichero entero (o sus max primeros bytes) como índices del alfabeto */
+static unsigned char *leer_indices(const char *path, const Alfabeto *alf, size_t max, size_t *n) {
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror("Error abriendo fichero"); return NULL; }
+    AlfLector lr;
+    alf_lector_init(&lr, alf);
+    unsigned char raw[LECTURA];
+    size_t cap = LECTURA + 1, len = 0, got, total = 0;
+    unsigned char *idx = malloc(cap);
+    while (idx && total < max && (got = fread(raw, 1, sizeof(raw), f)) > 0) {
+        if (got > max - total) got = max - total;
+        total += got;
+        if (len + got + 1 > cap) {
+            while (len + got + 1 > cap) cap *= 2;
+            unsigned char *nuevo = realloc(idx, cap);
+            if (!nuevo) { free(idx); idx = NULL; break; }
+            idx = nuevo;
+        }
+        len += alf_leer(&lr, raw, got, idx + len);
+    }
+    if (idx) len += alf_leer_fin(&lr, idx + len);
+    fclose(f);
+    *n = len;
+    return idx;
+}
+
+int main(int argc, char *argv[]) {
+    const char *filein = NULL, *crib = NULL, *cribf = NULL;
+    const Alfabeto *alf = alfabeto_por_nombre("latin26");
+    long offset = -1;
+    int hilos = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-crib") == 0 && i + 1 < argc) crib = argv[++i];
+        else if (strcmp(argv[i], "-cribf") == 0 && i + 1 < argc) cribf = argv[++i];
+        else if (strcmp(argv[i], "-offset") == 0 && i + 1 < argc) offset = atol(argv[++i]);
+        else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) hilos = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-alf") == 0 && i + 1 < argc) alf = alfabeto_por_nombre(argv[++i]);
+        else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) filein = argv[++i];
+        else {
+            fprintf(stderr, "Argumento no reconocido: %s\n", argv[i]);
+            filein = NULL;
+            break;
+        }
+    }
+    if (!filein || (!crib && !cribf) || !alf) {
+        fprintf(stderr, "Uso: %s {-crib texto | -cribf fichero} [-offset n] [-alf alfabeto] [-threads t] -i cifrado\n", argv[0]);
+        fprintf(stderr, "  sin -offset se prueban todas las posiciones del crib\n");
+        return EXIT_FAILURE;
+    }
+
+    size_t ncrib = 0, ncif = 0;
+    unsigned char *xcrib;
+    if (cribf) {
+        xcrib = leer_indices(cribf, alf, CRIB_MAX, &ncrib);
+    } else {
+        xcrib = malloc(strlen(crib) + 1);
+        if (xcrib) ncrib = alf_indices_clave(alf, crib, xcrib);
+    }
+    unsigned char *xcif = leer_indices(filein, alf, (size_t)-1, &ncif);
+    if (!xcrib || !xcif) {
+        free(xcrib); free(xcif);
+        return EXIT_FAILURE;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    ClaveAfinMod claves[KPA_MAX_CLAVES];
+    int n = afin_mod_kpa(alf, xcrib, ncrib, offset, xcif, ncif, hilos, claves, KPA_MAX_CLAVES);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) * 1e-6;
+
+    int ret = EXIT_SUCCESS;
+    if (n < 0) {
+        fprintf(stderr, "Crib demasiado corto: hacen falta %d letras con -offset y %d sin él (hay %zu)\n",
+                2 * BLOCK_SIZE + BLOCK_SIZE - 1, 4 * BLOCK_SIZE - 1, ncrib);
+        ret = EXIT_FAILURE;
+    } else if (n == 0) {
+        printf("Ninguna clave es compatible con el crib (%.2f ms)\n", ms);
+        ret = EXIT_FAILURE;
+    } else {
+        printf("%d clave(s) compatible(s) con el crib (%.2f ms):\n", n, ms);
+        for (int i = 0; i < n; ++i) {
+            gmp_printf("  a = %Zd\n  b = %Zd\n  crib en la letra %ld\n", claves[i].a, claves[i].b, claves[i].offset);
+            clave_afin_mod_clear(&claves[i]);
+        }
+        if (n > 1) printf("Varias claves encajan: un crib más largo las separa\n");
+    }
+    free(xcrib);
+    free(xcif);
+    return ret;
+}
@@ -0,0 +1,366 @@
+#include "criptoAnalisisVigenere.h"
+#include "cacheAnalisis.h"
+#include "kasiskiExterno.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Lee un fichero de claves (una por línea)
+static char **leer_claves(const char *path, int *n)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        perror("Error abriendo claves");
+        return NULL;
+    }
+    int cap = 1024;
+    char **claves = malloc(cap * sizeof(char *));
+    char linea[256];
+    *n = 0;
+    while (claves && fgets(linea, sizeof(linea), f))
+    {
+        linea[strcspn(linea, "\r\n")] = '\0';
+        if (!linea[0])
+            continue;
+        if (*n == cap)
+        {
+            char **nuevo = realloc(claves, 2 * cap * sizeof(char *));
+            if (!nuevo)
+                break;
+            claves = nuevo;
+            cap *= 2;
+        }
+        claves[(*n)++] = strdup(linea);
+    }
+    fclose(f);
+    return claves;
+}
+
+// Proyecta el fichero entero en memoria (NULL si está vacío o hay error)
+static const unsigned char *proyectar(const char *path, size_t *n)
+{
+    *n = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        perror("Error abriendo fichero");
+        return NULL;
+    }
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED)
+            perror("mmap");
+        else
+        {
+            madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+            *n = (size_t)st.st_size;
+        }
+    }
+    close(fd);
+    return map == MAP_FAILED ? NULL : map;
+}
+
+// -decrypt-out: descifra el original con la clave recuperada (proyectándolo si
+// el análisis no lo había hecho ya)
+static int descifrar_salida(const char *filein, const unsigned char *map, size_t n, const char *clave,
+                            const char *path)
+{
+    if (!clave[0])
+    {
+        fprintf(stderr, "No se recuperó ninguna clave: no se descifra nada\n");
+        return EXIT_FAILURE;
+    }
+    const unsigned char *propio = NULL;
+    if (!map)
+        map = propio = proyectar(filein, &n);
+    FILE *out = fopen(path, "wb");
+    if (!out)
+        perror("Error abriendo salida");
+    int r = out && (n == 0 || map) ? vigenere_descifrar_original(map, n, clave, out) : -1;
+    if (out && fclose(out) != 0)
+        r = -1;
+    if (propio)
+        munmap((void *)propio, n);
+    if (r < 0)
+    {
+        fprintf(stderr, "Error descifrando en %s\n", path);
+        return EXIT_FAILURE;
+    }
+    fprintf(stderr, "Descifrado con %s en %s\n", clave, path);
+    return 0;
+}
+
+// Modos -kasiski e -ic desde la caché (todo el fichero, sin truncar a MAX_TEXT)
+static int con_cache(const char *filein, const char *dir, int mode, int max_k, const char *lang,
+                     const Modelo *mod, char *clave)
+{
+    CacheAnalisis *c = cache_abrir(filein, dir);
+    if (!c)
+        return EXIT_FAILURE;
+    fprintf(stderr, "Caché %s: %016llx (%llu letras)\n", c->acierto ? "encontrada" : "creada",
+            (unsigned long long)c->cab->hash, (unsigned long long)c->cab->letras);
+
+    if (mode == 1)
+        kasiski_tabla(c->texto, (int)c->cab->kas_letras, c->ini, c->pos);
+    else if (mod)
+        vigenere_ic_idiomas(c->texto, (long long)c->cab->letras, c->hist, CACHE_MAX_N, max_k, mod, clave);
+    else
+        vigenere_ic_attack_hist(c->hist, CACHE_MAX_N, max_k, lang, clave);
+    cache_cerrar(c);
+    return 0;
+}
+
+// Modo -trial: prueba masiva de claves (diccionario o top-N por columna)
+static int trial(const char *filein, const char *keys, int top, int n, int prefix, int hilos, const char *lang)
+{
+    char *text = malloc(MAX_TEXT);
+    int len = load_text(filein, text);
+    TrialResultado res[TRIAL_TOP];
+    long long nodos = 0;
+    int nclaves = 0, r;
+    char **claves = NULL;
+    struct timespec t0, t1;
+
+    if (keys)
+        claves = leer_claves(keys, &nclaves);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (keys)
+    {
+        r = claves ? vigenere_trial_claves(text, len, prefix, claves, nclaves, lang, hilos, res, &nodos) : -1;
+    }
+    else
+    {
+        r = vigenere_trial_top(text, len, prefix, n, top, lang, hilos, res, &nodos);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+    if (r < 0)
+        fprintf(stderr, "Error en la prueba de claves\n");
+    else
+    {
+        printf("=== Prueba masiva de claves (prefijo %d letras) ===\n", prefix < len ? prefix : len);
+        if (keys)
+            printf("%d claves en %.3f s (%.2f M claves/s)\n", nclaves, secs, secs > 0 ? nclaves / secs / 1e6 : 0.0);
+        else
+            printf("top %d por columna: %lld sumas de columna en %.3f s (%.2f M/s)\n", top, nodos, secs,
+                   secs > 0 ? nodos / secs / 1e6 : 0.0);
+        for (int i = 0; i < r; ++i)
+            printf("  %d. %-20s chi2 = %.1f\n", i + 1, res[i].clave, res[i].chi2);
+    }
+
+    for (int i = 0; i < nclaves; ++i)
+        free(claves[i]);
+    free(claves);
+    free(text);
+    return r < 0 ? EXIT_FAILURE : 0;
+}
+
+// Modo -crib: arrastra el texto probable por todas las letras del fichero (sin
+// el límite de MAX_TEXT, así que el fichero se proyecta entero)
+static int arrastre(const char *filein, const char *crib, int max_k, const char *lang, int hilos,
+                    const char *decrypt_out)
+{
+    size_t map_n;
+    const unsigned char *map = proyectar(filein, &map_n);
+    if (!map)
+        return EXIT_FAILURE;
+    char *text = NULL, clave[MAX_K_CAND + 1] = "";
+    long long len = load_text_todo(map, map_n, &text);
+    int r = len < 0 ? -1 : vigenere_crib(text, len, crib, max_k, lang, hilos, clave);
+    free(text);
+    if (r < 0)
+        fprintf(stderr, "Error en el arrastre del crib\n");
+    r = r < 0 ? EXIT_FAILURE : 0;
+    if (r == 0 && decrypt_out)
+        r = descifrar_salida(filein, map, map_n, clave, decrypt_out);
+    munmap((void *)map, map_n);
+    return r;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Uso: %s {-kasiski [-mem-limit MB] | -ic N [-model f] | -all [N] [-threads T] | -stream [-margin x] | -sample [-windows W] [-wsize KB] [-verify] | -trial {-keys f | -top N [-n L]} [-prefix P] [-threads T] | -crib texto [-threads T]} [-lang es|en] [-cache [dir]] [-decrypt-out f] [-i filein]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    char *filein = NULL, *keys = NULL, *lang = "es", *cache = NULL, *model = NULL, *decrypt_out = NULL, *crib = NULL;
+    int top = 0, n = 0, prefix = TRIAL_PREFIX, hilos = 0, max_k = MAX_K_CAND, usar_cache = 0;
+    int mode = 0; // 1=kasiski, 2=ic, 3=stream, 4=sample, 5=trial, 6=all, 7=crib
+    double margin = STREAM_MARGIN;
+    int windows = SAMPLE_WINDOWS, verify = 0;
+    size_t win_bytes = SAMPLE_WINDOW_BYTES, mem_limit = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-kasiski") == 0)
+            mode = 1;
+        else if (strcmp(argv[i], "-mem-limit") == 0 && i + 1 < argc)
+            mem_limit = (size_t)strtoull(argv[++i], NULL, 10) << 20;
+        else if (strcmp(argv[i], "-ic") == 0)
+        {
+            mode = 2;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                max_k = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-all") == 0)
+        {
+            mode = 6;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                max_k = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-stream") == 0)
+            mode = 3;
+        else if (strcmp(argv[i], "-margin") == 0 && i + 1 < argc)
+            margin = atof(argv[++i]);
+        else if (strcmp(argv[i], "-sample") == 0)
+            mode = 4;
+        else if (strcmp(argv[i], "-windows") == 0 && i + 1 < argc)
+            windows = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-wsize") == 0 && i + 1 < argc)
+            win_bytes = (size_t)atoi(argv[++i]) * 1024;
+        else if (strcmp(argv[i], "-verify") == 0)
+            verify = 1;
+        else if (strcmp(argv[i], "-trial") == 0)
+            mode = 5;
+        else if (strcmp(argv[i], "-crib") == 0 && i + 1 < argc)
+        {
+            mode = 7;
+            crib = argv[++i];
+        }
+        else if (strcmp(argv[i], "-keys") == 0 && i + 1 < argc)
+            keys = argv[++i];
+        else if (strcmp(argv[i], "-top") == 0 && i + 1 < argc)
+            top = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            n = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-prefix") == 0 && i + 1 < argc)
+            prefix = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+            hilos = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-lang") == 0 && i + 1 < argc)
+            lang = argv[++i];
+        else if (strcmp(argv[i], "-model") == 0 && i + 1 < argc)
+            model = argv[++i];
+        else if (strcmp(argv[i], "-cache") == 0)
+        {
+            usar_cache = 1;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                cache = argv[++i];
+        }
+        else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+            filein = argv[++i];
+        else if (strcmp(argv[i], "-decrypt-out") == 0 && i + 1 < argc)
+            decrypt_out = argv[++i];
+    }
+
+    // El modo streaming y Kasiski externo aceptan la entrada estándar; el resto necesita fichero
+    // -decrypt-out necesita un modo que recupere la clave y el fichero original
+    // y -model solo lo usa -ic
+    int externo = mode == 1 && mem_limit > 0;
+    int sin_clave = mode == 1 || mode == 5;
+    if (mode == 0 || (!filein && mode != 3 && !externo) || (mode == 5 && !keys && top <= 0) ||
+        (decrypt_out && (sin_clave || !filein)) || (model && mode != 2))
+    {
+        fprintf(stderr, "Parámetros incorrectos. Uso: %s {-kasiski [-mem-limit MB] | -ic N [-model f] | -all [N] [-threads T] | -stream [-margin x] | -sample [-windows W] [-wsize KB] [-verify] | -trial {-keys f | -top N [-n L]} [-prefix P] [-threads T] | -crib texto [-threads T]} [-lang es|en] [-cache [dir]] [-decrypt-out f] [-i filein]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (mode == 5)
+        return trial(filein, keys, top, n, prefix, hilos, lang);
+    if (mode == 7)
+        return arrastre(filein, crib, max_k, lang, hilos, decrypt_out);
+    if (max_k < 1 || max_k > CACHE_MAX_N)
+        max_k = MAX_K_CAND;
+
+    // Modelos de idioma: se proyectan con mmap, sin leer nada más
+    Modelo *mod = NULL;
+    if (model && !(mod = modelo_abrir(model)))
+        return EXIT_FAILURE;
+    char clave[CACHE_MAX_N + 1] = "";
+    if (usar_cache && (mode == 1 || mode == 2))
+    {
+        int r = con_cache(filein, cache, mode, max_k, lang, mod, clave);
+        modelo_cerrar(mod);
+        if (r == 0 && decrypt_out)
+            r = descifrar_salida(filein, NULL, 0, clave, decrypt_out);
+        return r;
+    }
+
+    if (externo)
+    {
+        FILE *in = filein ? fopen(filein, "rb") : stdin;
+        if (!in)
+        {
+            perror("Error abriendo fichero");
+            return EXIT_FAILURE;
+        }
+        int r = kasiski_externo(in, mem_limit, hilos);
+        if (in != stdin)
+            fclose(in);
+        return r < 0 ? EXIT_FAILURE : 0;
+    }
+
+    if (mode == 3)
+    {
+        FILE *in = stdin;
+        if (filein)
+        {
+            in = fopen(filein, "r");
+            if (!in)
+            {
+                perror("Error abriendo fichero");
+                return EXIT_FAILURE;
+            }
+        }
+        vigenere_ic_stream(in, MAX_K_CAND, lang, margin, clave);
+        if (in != stdin)
+            fclose(in);
+        return decrypt_out ? descifrar_salida(filein, NULL, 0, clave, decrypt_out) : 0;
+    }
+
+    if (mode == 4)
+    {
+        vigenere_sample_attack(filein, windows, win_bytes, MAX_K_CAND, lang, verify, clave);
+        return decrypt_out ? descifrar_salida(filein, NULL, 0, clave, decrypt_out) : 0;
+    }
+
+    // Con -decrypt-out el original se proyecta una vez: de él salen las letras
+    // del análisis y luego el descifrado
+    const unsigned char *map = NULL;
+    size_t map_n = 0;
+    char *text = malloc(MAX_TEXT);
+    int len;
+    if (decrypt_out && (map = proyectar(filein, &map_n)))
+        len = load_text_mem(map, map_n, text);
+    else
+        len = load_text(filein, text);
+    if (mode == 1)
+        kasiski(text, len);
+    else if (mode == 2 && mod)
+        vigenere_ic_idiomas(text, len, NULL, 0, max_k, mod, clave);
+    else if (mode == 2)
+        vigenere_ic_attack(text, len, max_k, lang, clave);
+    else if (mode == 6)
+        vigenere_analisis_completo(text, len, max_k, lang, hilos, clave);
+
+    free(text);
+    modelo_cerrar(mod);
+    int r = 0;
+    if (decrypt_out)
+        r = descifrar_salida(filein, map, map_n, clave, decrypt_out);
+    if (map)
+        munmap((void *)map, map_n);
+    return r;
+}
@@ -0,0 +1,61 @@
+#include "euclides.h"
+#include "euclidesLotes.h"
+#include <gmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ---------- Programa principal ---------- */
+
+static void uso(const char *prog) {
+    fprintf(stderr, "Uso: %s [-gcd | -ext | -cf] [-threads n] [-bin] [-obin] [-i in] [-o out]\n", prog);
+    fprintf(stderr, "  un par (a, b) por línea (\"a b\") o, con -bin, en binario (ver euclidesLotes.h)\n");
+    fprintf(stderr, "  -gcd: mcd | -ext: mcd s t con a·s + b·t = mcd (por defecto) | -cf: mcd y cocientes\n");
+}
+
+int main(int argc, char *argv[]) {
+    EucOpciones op = { EUC_EXT, 0, 0, 0 };
+    const char *input_path = NULL, *output_path = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-gcd")) op.modo = EUC_MCD;
+        else if (!strcmp(argv[i], "-ext")) op.modo = EUC_EXT;
+        else if (!strcmp(argv[i], "-cf")) op.modo = EUC_CF;
+        else if (!strcmp(argv[i], "-threads") && i + 1 < argc) op.hilos = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-bin")) op.bin_in = 1;
+        else if (!strcmp(argv[i], "-obin")) op.bin_out = 1;
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc) input_path = argv[++i];
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) output_path = argv[++i];
+        else {
+            uso(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    FILE *in = input_path ? fopen(input_path, "rb") : stdin;
+    if (!in) {
+        perror("Error abriendo entrada");
+        return EXIT_FAILURE;
+    }
+    FILE *out = output_path ? fopen(output_path, "wb") : stdout;
+    if (!out) {
+        perror("Error abriendo salida");
+        if (in != stdin) fclose(in);
+        return EXIT_FAILURE;
+    }
+
+    struct timespec t0, t1;
+    EucEstad st;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int r = euclides_lotes(in, out, &op, &st);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+    if (in != stdin) fclose(in);
+    if (out != stdout && fclose(out) != 0) r = -1;
+    if (r < 0) fprintf(stderr, "Error procesando los pares\n");
+    fprintf(stderr, "%lld pares en %.3f s (%.2f M pares/s), %lld por 64 bits, %lld erróneos\n", st.pares, secs,
+            secs > 0 ? st.pares / secs / 1e6 : 0.0, st.rapidos, st.errores);
+    return r < 0 ? EXIT_FAILURE : 0;
+}
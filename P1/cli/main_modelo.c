@@ -0,0 +1,60 @@
+#include "modelo.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Entrena modelos de idioma: modelo -o salida.mod -l es corpus... [-l en corpus...] */
+int main(int argc, char *argv[]) {
+    const char *fileout = NULL;
+    const char *nombres[MODELO_MAX_IDIOMAS];
+    char **ficheros[MODELO_MAX_IDIOMAS];
+    int nficheros[MODELO_MAX_IDIOMAS] = {0};
+    int n = 0, hilos = 0, ok = 1;
+
+    for (int i = 1; i < argc && ok; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) fileout = argv[++i];
+        else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) hilos = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc && n < MODELO_MAX_IDIOMAS) {
+            nombres[n] = argv[++i];
+            ficheros[n] = &argv[i + 1];
+            while (i + 1 < argc && argv[i + 1][0] != '-') { nficheros[n]++; i++; }
+            n++;
+        } else {
+            fprintf(stderr, "Argumento no reconocido: %s\n", argv[i]);
+            ok = 0;
+        }
+    }
+    for (int l = 0; l < n; ++l)
+        if (nficheros[l] == 0) ok = 0;
+    if (!ok || !fileout || n == 0) {
+        fprintf(stderr, "Uso: %s -o modelo.mod -l idioma corpus... [-l idioma corpus...] [-threads t]\n", argv[0]);
+        fprintf(stderr, "  como mucho %d idiomas\n", MODELO_MAX_IDIOMAS);
+        return EXIT_FAILURE;
+    }
+
+    ModeloIdioma *idiomas = aligned_alloc(64, n * sizeof(ModeloIdioma));
+    if (!idiomas) { fprintf(stderr, "Error: sin memoria.\n"); return EXIT_FAILURE; }
+
+    for (int l = 0; l < n; ++l) {
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (modelo_entrenar(&idiomas[l], nombres[l], ficheros[l], nficheros[l], hilos) < 0) {
+            fprintf(stderr, "Error entrenando el idioma %s\n", nombres[l]);
+            free(idiomas);
+            return EXIT_FAILURE;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) * 1e-6;
+        printf("%s: %llu letras, IC=%.5f (%.1f ms)\n", idiomas[l].nombre,
+               (unsigned long long)idiomas[l].letras, idiomas[l].ic, ms);
+    }
+
+    int ret = modelo_guardar(fileout, idiomas, n) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (ret == EXIT_SUCCESS)
+        printf("[OK] Modelo con %d idioma(s) en %s\n", n, fileout);
+    else
+        fprintf(stderr, "Error escribiendo %s\n", fileout);
+    free(idiomas);
+    return ret;
+}
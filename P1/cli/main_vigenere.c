@@ -0,0 +1,211 @@
+#include "vigenere.h"
+#include "normalizar.h"
+#include "indice.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define VIG_CHUNK 65536
+
+static unsigned char raw[VIG_CHUNK], idx[VIG_CHUNK + 1];
+static char salida[ALF_MAX_SIMBOLO * (VIG_CHUNK + 1)];
+
+/* Letras que avanzan la clave en latin26 (A-Z y a-z) */
+static uint64_t contar_letras(const unsigned char *t, size_t n) {
+    uint64_t letras = 0;
+    for (size_t i = 0; i < n; ++i) letras += TABLA_ASCII[t[i]] != 0;
+    return letras;
+}
+
+/* Alfabetos distintos de latin26: índices de punta a punta, solo salen
+ * los símbolos del alfabeto */
+static int vigenere_alf(FILE *in, FILE *out, const Alfabeto *alf, const char *key, int encrypt,
+                        IndiceEscritor *ix) {
+    VigenereCtx ctx;
+    if (vigenere_ctx_init_alf(&ctx, alf, key, encrypt) < 0) {
+        fprintf(stderr, "La clave no tiene símbolos del alfabeto %s\n", alf->nombre);
+        return -1;
+    }
+    AlfLector lr;
+    alf_lector_init(&lr, alf);
+    uint64_t bytes = 0, letras = 0;
+    size_t got;
+    do {
+        got = fread(raw, 1, sizeof(raw), in);
+        size_t n = got ? alf_leer(&lr, raw, got, idx) : alf_leer_fin(&lr, idx);
+        vigenere_ctx_indices(&ctx, idx, n);
+        size_t nsal = alf_escribir(alf, idx, n, salida);
+        fwrite(salida, 1, nsal, out);
+        bytes += nsal;
+        letras += n;
+        indice_anotar(ix, bytes, letras);
+    } while (got > 0);
+    vigenere_ctx_free(&ctx);
+    return indice_cerrar(ix, bytes, letras);
+}
+
+/*
+ * Descifra solo los bytes [offset, offset + length) del cifrado: salta al
+ * punto de control anterior del índice (o al principio), cuenta las letras
+ * hasta offset para colocar la fase de la clave y descifra el rango.
+ * alf NULL: latin26 sobre texto mezclado.
+ */
+static int vigenere_rango(FILE *in, FILE *out, const Alfabeto *alf, const char *key,
+                          const char *ruta_indice, uint64_t offset, uint64_t length) {
+    struct stat st;
+    if (fstat(fileno(in), &st) < 0 || !S_ISREG(st.st_mode)) {
+        fprintf(stderr, "El descifrado por rangos necesita un fichero regular\n");
+        return -1;
+    }
+    uint64_t bytes = (uint64_t)st.st_size;
+    if (offset > bytes) offset = bytes;
+    if (length > bytes - offset) length = bytes - offset;
+    uint64_t fin = offset + length;
+
+    VigenereCtx ctx;
+    if ((alf ? vigenere_ctx_init_alf(&ctx, alf, key, 0) : vigenere_ctx_init(&ctx, key, 0)) < 0) {
+        fprintf(stderr, "Clave vacía\n");
+        return -1;
+    }
+    PuntoControl p;
+    indice_buscar(ruta_indice, bytes, offset, &p);
+    if (fseeko(in, (off_t)p.byte, SEEK_SET) < 0) { perror("fseek"); vigenere_ctx_free(&ctx); return -1; }
+
+    AlfLector lr;
+    if (alf) alf_lector_init(&lr, alf);
+    uint64_t pos = p.byte, letras = p.letras;
+    size_t got;
+
+    // 1) Solo contar letras hasta offset
+    while (pos < offset) {
+        size_t want = offset - pos < VIG_CHUNK ? (size_t)(offset - pos) : VIG_CHUNK;
+        if (!(got = fread(raw, 1, want, in))) break;
+        pos += got;
+        letras += alf ? alf_leer(&lr, raw, got, idx) : contar_letras(raw, got);
+    }
+    vigenere_ctx_saltar(&ctx, letras);
+
+    // 2) Descifrar el rango
+    while (pos < fin) {
+        size_t want = fin - pos < VIG_CHUNK ? (size_t)(fin - pos) : VIG_CHUNK;
+        if (!(got = fread(raw, 1, want, in))) break;
+        pos += got;
+        if (alf) {
+            size_t n = alf_leer(&lr, raw, got, idx);
+            vigenere_ctx_indices(&ctx, idx, n);
+            fwrite(salida, 1, alf_escribir(alf, idx, n, salida), out);
+        } else {
+            vigenere_ctx_aplicar(&ctx, (char *)raw, got);
+            fwrite(raw, 1, got, out);
+        }
+    }
+    if (alf) {
+        size_t n = alf_leer_fin(&lr, idx);
+        vigenere_ctx_indices(&ctx, idx, n);
+        fwrite(salida, 1, alf_escribir(alf, idx, n, salida), out);
+    }
+    vigenere_ctx_free(&ctx);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int encrypt = -1;
+    char *key = NULL, *fin = NULL, *fout = NULL, *findex = NULL;
+    unsigned long long offset = 0, length = (unsigned long long)-1; // sin -length: hasta el final
+    int rango = 0;
+    const Alfabeto *alf = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-C") == 0) {
+            encrypt = 1;
+        } else if (strcmp(argv[i], "-D") == 0) {
+            encrypt = 0;
+        } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            key = argv[++i];
+        } else if (strcmp(argv[i], "-alf") == 0 && i + 1 < argc) {
+            if (!(alf = alfabeto_por_nombre(argv[++i]))) {
+                fprintf(stderr, "Alfabeto desconocido: %s (latin26 | es27 | bytes)\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            fin = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            fout = argv[++i];
+        } else if (strcmp(argv[i], "-index") == 0 && i + 1 < argc) {
+            findex = argv[++i];
+        } else if (strcmp(argv[i], "-offset") == 0 && i + 1 < argc) {
+            offset = strtoull(argv[++i], NULL, 10);
+            rango = 1;
+        } else if (strcmp(argv[i], "-length") == 0 && i + 1 < argc) {
+            length = strtoull(argv[++i], NULL, 10);
+            rango = 1;
+        } else {
+            fprintf(stderr, "Uso: %s {-C|-D} -k clave [-alf latin26|es27|bytes] -i filein -o fileout\n"
+                            "        [-index f] [-offset byte -length bytes]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (encrypt == -1 || key == NULL) {
+        fprintf(stderr, "Debes indicar {-C|-D} y la clave con -k\n");
+        return EXIT_FAILURE;
+    }
+    if (rango && (encrypt || !fin)) {
+        fprintf(stderr, "-offset/-length solo al descifrar un fichero (-D -i cifrado)\n");
+        return EXIT_FAILURE;
+    }
+
+    FILE *in = stdin, *out = stdout;
+    if (fin) {
+        in = fopen(fin, "r");
+        if (!in) { perror("Error abriendo input"); return EXIT_FAILURE; }
+    }
+    if (fout) {
+        out = fopen(fout, "w");
+        if (!out) { perror("Error abriendo output"); return EXIT_FAILURE; }
+    }
+
+    if (alf && alf->id == ALF_LATIN26) alf = NULL;
+    if (rango) {
+        int r = vigenere_rango(in, out, alf, key, findex, offset, length);
+        fclose(in);
+        if (out != stdout) fclose(out);
+        return r < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    // Al cifrar, -index escribe los puntos de control del cifrado
+    IndiceEscritor ix;
+    if (indice_crear(&ix, encrypt ? findex : NULL) < 0) return EXIT_FAILURE;
+
+    if (alf) {
+        int r = vigenere_alf(in, out, alf, key, encrypt, &ix);
+        if (in != stdin) fclose(in);
+        if (out != stdout) fclose(out);
+        return r < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    // La fase de la clave se conserva entre bloques
+    VigenereCtx ctx;
+    if (vigenere_ctx_init(&ctx, key, encrypt) < 0) {
+        fprintf(stderr, "Clave vacía\n");
+        return EXIT_FAILURE;
+    }
+    uint64_t bytes = 0, letras = 0;
+    size_t got;
+    while ((got = fread(raw, 1, sizeof(raw), in)) > 0) {
+        vigenere_ctx_aplicar(&ctx, (char *)raw, got);
+        fwrite(raw, 1, got, out);
+        if (findex) {
+            bytes += got;
+            letras += contar_letras(raw, got);
+            indice_anotar(&ix, bytes, letras);
+        }
+    }
+    vigenere_ctx_free(&ctx);
+    if (indice_cerrar(&ix, bytes, letras) < 0) fprintf(stderr, "Error escribiendo el índice\n");
+
+    if (in != stdin) fclose(in);
+    if (out != stdout) fclose(out);
+    return 0;
+}
@@ -1,3 +1,6 @@
+#ifndef AFIN_H
+#define AFIN_H
+
 #include <stdio.h>
 #include <gmp.h>
 
@@ -5,4 +8,15 @@
 #define DECIPHER_AFIN 0
 
 void encriptar_afin(FILE *in, FILE *out, const mpz_t a, const mpz_t b, const mpz_t m);
-void decriptar_afin(FILE *in, FILE *out, const mpz_t a, const mpz_t b, const mpz_t m);
\ No newline at end of file
+void decriptar_afin(FILE *in, FILE *out, const mpz_t a, const mpz_t b, const mpz_t m);
+
+/* Tabla de sustitución precalculada (índice -> índice, m <= 256) */
+typedef struct {
+    int m;
+    unsigned char tabla[256];
+} AfinCtx;
+
+int afin_ctx_init(AfinCtx *ctx, const mpz_t a, const mpz_t b, const mpz_t m, int modo);
+void afin_ctx_aplicar(const AfinCtx *ctx, unsigned char *idx, size_t n);
+
+#endif
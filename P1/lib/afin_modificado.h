@@ -1,8 +1,69 @@
+#ifndef AFIN_MODIFICADO_H
+#define AFIN_MODIFICADO_H
+
+#include "alfabeto.h"
+#include "indice.h"
+#include "ioAsincrona.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <gmp.h>
 
-#define CIPHER_AFIN 1
-#define DECIPHER_AFIN 0
+#define BLOCK_SIZE 26
+
+/* Conversiones base-26 (letras A-Z) */
+void block_to_mpz(const char *block, int L, mpz_t x);
+void mpz_to_block(const mpz_t x_in, int L, char *block_out);
+void compute_modulus(int L, mpz_t M);
+
+/* Conversiones en base m sobre índices de un alfabeto */
+void indices_to_mpz(const Alfabeto *alf, const unsigned char *idx, int L, mpz_t x);
+void mpz_to_indices(const Alfabeto *alf, const mpz_t x, int L, unsigned char *idx);
+void compute_modulus_alf(const Alfabeto *alf, int L, mpz_t M);
+
+/* Cifrar / descifrar por bloques de BLOCK_SIZE letras: y = a*x + b mod 26^BLOCK_SIZE */
+void encriptar_afin_bloques(FILE *in, FILE *out, const mpz_t a, const mpz_t b, const mpz_t M);
+void decriptar_afin_bloques(FILE *in, FILE *out, const mpz_t a, const mpz_t b, const mpz_t M);
+
+/* Igual, con bloques de BLOCK_SIZE símbolos del alfabeto: mod m^BLOCK_SIZE */
+void encriptar_afin_bloques_alf(FILE *in, FILE *out, const Alfabeto *alf, const mpz_t a, const mpz_t b);
+void decriptar_afin_bloques_alf(FILE *in, FILE *out, const Alfabeto *alf, const mpz_t a, const mpz_t b);
+
+/* Cifra y escribe el índice de puntos de control en ruta_indice (ver indice.h) */
+int encriptar_afin_bloques_indice(FILE *in, FILE *out, const Alfabeto *alf, const mpz_t a, const mpz_t b,
+                                  const char *ruta_indice);
+/* Cifra (modo CIPHER_AFIN, con índice si ruta_indice) o descifra con E/S
+ * asíncrona según es (ver ioAsincrona.h; NULL: fread/fwrite). Devuelve 0 o -1 */
+int afin_bloques_es(FILE *in, FILE *out, const Alfabeto *alf, const mpz_t a, const mpz_t b, int modo,
+                    const char *ruta_indice, const EsOpciones *es);
+/* Descifra solo los bytes [offset, offset + length) del cifrado (fichero regular),
+ * saltando al punto de control anterior si hay índice (ruta_indice NULL: sin él) */
+int decriptar_afin_bloques_rango(FILE *in, FILE *out, const Alfabeto *alf, const mpz_t a, const mpz_t b,
+                                 const char *ruta_indice, uint64_t offset, uint64_t length);
+
+/* Conversión bloque de índices <-> entero, especializada por alfabeto */
+typedef void (*BloqueAMpz)(const unsigned char *idx, int L, mpz_t x);
+typedef void (*MpzABloque)(const mpz_t x, int L, unsigned char *idx, mpz_t tmp);
+
+/* Bloque cifrado en su sitio con las tablas fusionadas de la clave */
+typedef void (*FusionBloque)(const void *tablas, unsigned char *idx);
+
+/* Estado para cifrar buffers de índices bloque a bloque (en su sitio) */
+typedef struct {
+    const Alfabeto *alf;
+    BloqueAMpz a_mpz;
+    MpzABloque a_bloque;
+    mpz_t a, b, M;  /* clave ya preparada: para descifrar a = a^-1 mod M */
+    mpz_t x, y;     /* temporales reutilizados */
+    int modo;       /* CIPHER_AFIN / DECIPHER_AFIN (afin.h) */
+    void *tablas;   /* tablas por posición y dígito (NULL: camino con GMP) */
+    FusionBloque fusion;
+} AfinModCtx;
+
+int afin_mod_ctx_init(AfinModCtx *ctx, const Alfabeto *alf, const mpz_t a, const mpz_t b, int modo);
+void afin_mod_ctx_bloques(AfinModCtx *ctx, unsigned char *idx, size_t nbloques);
+void afin_mod_ctx_free(AfinModCtx *ctx);
+/* Desactiva las tablas fusionadas en los contextos que se creen después: todo
+ * bloque va por GMP (para medir o comprobar ese camino) */
+void afin_mod_sin_fusion(void);
 
-void encriptar_afin_modificado(FILE *in, FILE *out, const mpz_t a, const mpz_t b, const mpz_t m);
-void decriptar_afin_modificado(FILE *in, FILE *out, const mpz_t a, const mpz_t b, const mpz_t m);
\ No newline at end of file
+#endif
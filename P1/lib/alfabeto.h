@@ -0,0 +1,61 @@
+#ifndef ALFABETO_H
+#define ALFABETO_H
+
+#include "normalizar.h"
+#include <stddef.h>
+
+/* Alfabetos disponibles */
+#define ALF_LATIN26 0 /* A-Z, m = 26 */
+#define ALF_ES27    1 /* A-N, Ñ, O-Z, m = 27 (la Ñ es el índice 14) */
+#define ALF_BYTES   2 /* bytes sin normalizar, m = 256 */
+
+#define ALF_MAX_SIMBOLO 2 /* bytes de salida por símbolo como mucho (Ñ en UTF-8) */
+
+/**
+ * @brief Descriptor de un alfabeto.
+ *
+ * Los cifrados trabajan con índices 0..m-1; el alfabeto se elige una vez al
+ * arrancar y decide cómo se pasa de bytes a índices (lectura) y de índices a
+ * bytes (escritura). Las tablas son constantes, así que no hay nada que
+ * preparar ni liberar.
+ */
+typedef struct {
+    int id;
+    const char *nombre;
+    int m;
+} Alfabeto;
+
+const Alfabeto *alfabeto_por_nombre(const char *nombre);
+const Alfabeto *alfabeto_por_m(int m);
+
+/* Lectura por bloques de texto -> índices (con su normalizador) */
+typedef struct {
+    const Alfabeto *alf;
+    Normalizador nz;
+} AlfLector;
+
+void alf_lector_init(AlfLector *lr, const Alfabeto *alf);
+
+/**
+ * @brief Convierte un bloque de bytes en índices del alfabeto.
+ *
+ * Lo que no pertenece al alfabeto se descarta. idx debe tener al menos n
+ * bytes. Devuelve el número de índices escritos.
+ */
+size_t alf_leer(AlfLector *lr, const unsigned char *in, size_t n, unsigned char *idx);
+
+/* Índices pendientes al final de la entrada (como mucho uno) */
+size_t alf_leer_fin(AlfLector *lr, unsigned char *idx);
+
+/**
+ * @brief Convierte índices en bytes de salida.
+ *
+ * out debe tener al menos ALF_MAX_SIMBOLO * n bytes. Devuelve los bytes
+ * escritos.
+ */
+size_t alf_escribir(const Alfabeto *alf, const unsigned char *idx, size_t n, char *out);
+
+/* Índices de una clave escrita en el alfabeto; devuelve cuántos (idx >= strlen) */
+size_t alf_indices_clave(const Alfabeto *alf, const char *clave, unsigned char *idx);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef CACHEANALISIS_H
+#define CACHEANALISIS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Caché en disco del análisis de un cifrado, indexada por un hash del contenido.
+ *
+ * Guarda lo que no depende del idioma ni del modo: el texto compacto (solo
+ * A-Z), los histogramas por columnas para n = 1..CACHE_MAX_N (ver HIST_N_OFF)
+ * y la tabla de cubetas de trigramas de Kasiski. En un acierto el fichero se
+ * proyecta con mmap y no se vuelve a normalizar ni a contar nada.
+ *
+ * Formato (versión CACHE_VERSION), todo en el orden de bytes de la máquina:
+ *   CacheCab | texto | histogramas (uint64) | ini (uint32) | pos (uint32)
+ * cada sección alineada a 64 bytes.
+ */
+
+#define CACHE_MAGIC   "CRIPTOC"
+#define CACHE_VERSION 1
+#define CACHE_MAX_N   30         // mayor n con histogramas guardados (MAX_K_CAND)
+#define CACHE_DIR     ".cripto_cache"
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t max_n;
+    uint64_t hash;       // hash del fichero original
+    uint64_t bytes;      // tamaño del fichero original
+    uint64_t letras;     // longitud del texto compacto
+    uint64_t kas_letras; // letras cubiertas por la tabla de Kasiski (<= INT_MAX)
+    uint64_t off_texto, off_hist, off_ini, off_pos;
+} CacheCab;
+
+typedef struct {
+    void *map;
+    size_t tam;
+    const CacheCab *cab;
+    const char *texto;
+    const uint64_t *hist; // HIST_N_OFF(CACHE_MAX_N + 1) contadores
+    const uint32_t *ini;  // KASISKI_CUBETAS + 1
+    const uint32_t *pos;  // kas_letras - 2
+    int acierto;          // 1 si ya estaba en disco
+} CacheAnalisis;
+
+/* Hash de 64 bits del contenido (4 carriles de multiplicación-rotación) */
+uint64_t cache_hash(const void *p, size_t n);
+
+/**
+ * @brief Abre (o crea) la caché del fichero en el directorio dir
+ * (CACHE_DIR si es NULL). Devuelve NULL si hay algún error.
+ */
+CacheAnalisis *cache_abrir(const char *fichero, const char *dir);
+
+void cache_cerrar(CacheAnalisis *c);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef CRIPTOANALISISAFIN_H
+#define CRIPTOANALISISAFIN_H
+
+#include "alfabeto.h"
+#include <stddef.h>
+#include <gmp.h>
+
+#define KPA_MAX_CLAVES 16  // claves que se devuelven como mucho
+#define KPA_MAX_CAND 64    // candidatos a enumerar si el sistema no da una sola a
+
+/* Clave de afin_modificado recuperada a partir de un crib */
+typedef struct {
+    mpz_t a, b;
+    long offset; /* letra del texto claro donde empieza el crib */
+} ClaveAfinMod;
+
+/**
+ * @brief Ataque con texto claro conocido al afín por bloques.
+ *
+ * Convierte en bloques el crib (índices del alfabeto) y resuelve
+ * y = a*x + b (mod m^BLOCK_SIZE) con las diferencias entre bloques, que
+ * eliminan b. Si una diferencia no es invertible se trabaja con el mcd y
+ * los siguientes bloques del crib acotan la solución.
+ *
+ * @param offset Letra del texto claro donde empieza el crib, o -1 si no se
+ *               conoce: entonces se prueban todas las alineaciones en
+ *               paralelo (hacen falta 3 bloques completos en cada una).
+ * @param hilos  Hilos para el barrido (<= 0: uno por CPU).
+ * @return Número de claves encontradas (como mucho max_claves), o -1 si el
+ *         crib es demasiado corto.
+ */
+int afin_mod_kpa(const Alfabeto *alf, const unsigned char *crib, size_t ncrib, long offset,
+                 const unsigned char *cifrado, size_t ncifrado, int hilos,
+                 ClaveAfinMod *claves, int max_claves);
+
+void clave_afin_mod_clear(ClaveAfinMod *c);
+
+#endif
@@ -1,16 +1,111 @@
 #ifndef CRIPTOANALISISVIGNERE_H
 #define CRIPTOANALISISVIGNERE_H
 
+#include <stdio.h>
+#include <stdint.h>
+#include "modelo.h"
+
+#define MAX_TEXT 1000000 // Tamaño del buffer de texto de load_text
+#define MAX_K_CAND 30    // Número máximo de candidatos a longitud de clave (2..40)
+
+#define STREAM_MARGIN 0.25         // margen de confianza por defecto del modo streaming
+#define SAMPLE_WINDOWS 8           // ventanas por defecto del modo muestreo
+#define SAMPLE_WINDOW_BYTES 65536  // bytes por ventana por defecto
+
+#define TRIAL_PREFIX 4096  // letras del cifrado con las que se puntúa cada clave
+#define TRIAL_TOP 5        // mejores claves que devuelve la prueba masiva
+#define TRIAL_MAX_KEY 64   // longitud máxima de una clave candidata
+
+#define CRIB_MAX 64         // letras del texto probable que se usan
+#define CRIB_MIN_COMPROB 3  // comprobaciones mínimas (letras del crib - periodo) por desplazamiento
+#define CRIB_TOP 10         // claves candidatas que se listan
+
+#define KASISKI_CUBETAS (26 * 26 * 26) // trigramas distintos
+#define KASISKI_MIN_DIST 20            // distancia mínima entre repeticiones
+
+// Tablas de histogramas por columnas para n = 1..max_n, una detrás de otra:
+// las n columnas de longitud n empiezan en HIST_N_OFF(n) (26 contadores cada una)
+#define HIST_N_OFF(n) ((size_t)26 * (size_t)(n) * ((size_t)(n) - 1) / 2)
+
+// Clave candidata y su χ² frente al idioma (menor es mejor)
+typedef struct {
+    char clave[TRIAL_MAX_KEY + 1];
+    double chi2;
+} TrialResultado;
+
 // Función para limpiar el texto (solo A-Z)
 int load_text(const char *filename, char *buffer);
 
+// load_text sobre un fichero ya proyectado (p, n bytes)
+int load_text_mem(const unsigned char *p, size_t n, char *buffer);
+// Todas las letras de un fichero proyectado, sin el límite de MAX_TEXT; el
+// buffer se deja en *out (lo libera quien llama). Devuelve su número o -1.
+long long load_text_todo(const unsigned char *p, size_t n, char **out);
+// Descifra el original (p, n bytes) con la clave recuperada y lo escribe en out,
+// conservando signos y formato. Devuelve 0 o -1 si la clave o la escritura fallan.
+int vigenere_descifrar_original(const unsigned char *p, size_t n, const char *key, FILE *out);
+
 /*Calcula el maximo común divisor de 2 números*/
 int mcd(int a, int b);
 
-// Test de Kasiski: busca repeticiones de trigramas y distancias
-void kasiski(const char *text, int len);
+// Test de Kasiski: busca repeticiones de trigramas y distancias.
+// Devuelve la longitud de clave más votada (0 si no hay ninguna)
+int kasiski(const char *text, int len);
+// Tabla de cubetas de trigramas (ini: KASISKI_CUBETAS + 1, pos: len - 2 entradas)
+void kasiski_cubetas(const char *text, int len, uint32_t *ini, uint32_t *pos);
+// Kasiski sobre una tabla de cubetas ya construida
+int kasiski_tabla(const char *text, int len, const uint32_t *ini, const uint32_t *pos);
+// Imprime votos y estimación: cuenta y mcds traen, por trigrama, las veces que
+// aparece y el MCD de sus distancias útiles (pueden ser NULL si len es corto)
+int kasiski_informe(uint64_t len, const uint64_t *cuenta, const uint64_t *mcds);
+// Lo mismo con los votos por longitud ya contados (MAX_K_CAND + 1 entradas)
+int kasiski_informe_votos(uint64_t len, const uint64_t *cuenta, const uint64_t *mcds, const int *votos);
+
+// Probabilidades de las letras del idioma ("es" o "en"); devuelve su IC (ΣP²)
+double load_language_probs(const char *lang, double P[26]);
+
+// Ataque por IC + M(k): estima la longitud y deja la clave en out_key
+void vigenere_ic_attack(const char *text, int len, int max_k, const char *lang, char *out_key);
+// Lo mismo probando solo n en [min_k, max_k] (p. ej. con el periodo del triaje)
+void vigenere_ic_attack_rango(const char *text, int len, int min_k, int max_k, const char *lang, char *out_key);
+// Lo mismo a partir de las tablas de histogramas por columnas (ver HIST_N_OFF)
+void vigenere_ic_attack_hist(const uint64_t *hist, int max_n, int max_k, const char *lang, char *out_key);
+// Ataque por IC contra todos los idiomas del modelo: estima longitud y clave con
+// cada uno, puntúa el descifrado con sus cuadrigramas y se queda con el mejor.
+// hist son las tablas por columnas (o NULL para calcularlas del texto).
+// Devuelve el índice del idioma elegido (-1 si el modelo está vacío).
+int vigenere_ic_idiomas(const char *text, long long len, const uint64_t *hist, int max_n, int max_k,
+                        const Modelo *mod, char *out_key);
+
+// Kasiski e IC sobre una sola carga del texto, en paralelo (hilos <= 0: uno por
+// procesador), y decisión conjunta de la longitud con los dos. Imprime los dos
+// informes y la clasificación; deja la clave en out_key y devuelve su longitud.
+int vigenere_analisis_completo(const char *text, int len, int max_k, const char *lang, int hilos,
+                               char *out_key);
+
+// Arrastre de un texto probable: deduce el segmento de clave que daría el crib
+// en cada letra del cifrado (restas de bytes vectorizadas, desplazamientos
+// repartidos entre hilos), marca los que salen periódicos con algún periodo
+// <= max_k, los ordena por el χ² del descifrado y los contrasta con el ataque
+// por IC. Deja la mejor clave en out_key y devuelve las claves distintas
+// marcadas (-1 si el crib es demasiado corto o no hay memoria).
+int vigenere_crib(const char *text, long long len, const char *crib, int max_k, const char *lang, int hilos,
+                  char *out_key);
+
+// Ataque por IC en streaming: lee por bloques y para al estabilizarse la clave
+void vigenere_ic_stream(FILE *in, int max_k, const char *lang, double margin, char *out_key);
+
+// Estimación por muestreo: analiza solo unas ventanas repartidas por el fichero
+void vigenere_sample_attack(const char *filename, int windows, size_t win_bytes, int max_k,
+                            const char *lang, int verify, char *out_key);
 
-// Índice de coincidencia para longitud n
-void ic(const char *text, int len, int n);
+// Prueba masiva: puntúa cada clave con el χ² del prefijo descifrado, en paralelo y
+// abandonando las que ya no pueden mejorar. Devuelven cuántas claves dejan en res
+// (TRIAL_TOP como mucho) y en nodos las sumas de columna hechas.
+int vigenere_trial_claves(const char *text, int len, int prefix, char **claves, int nclaves,
+                          const char *lang, int hilos, TrialResultado *res, long long *nodos);
+// Top-N: combina las top mejores subclaves por M(k) de cada columna (n <= 0: n por IC)
+int vigenere_trial_top(const char *text, int len, int prefix, int n, int top,
+                       const char *lang, int hilos, TrialResultado *res, long long *nodos);
 
-#endif
\ No newline at end of file
+#endif
@@ -1,4 +1,11 @@
+#ifndef EUCLIDES_H
+#define EUCLIDES_H
+
 #include <gmp.h>
+#include <stdint.h>
+
+/* Cocientes como mucho de euclides con a, b < 2^63 (a < b añade un 0 al principio) */
+#define EUCLIDES_U64_PASOS 96
 
 /* Resultado del algoritmo de Euclides */
 /**
@@ -23,4 +30,34 @@ typedef struct _ExtendedEuclidesResult {
 } ExtendedEuclidesResult;
 
 EuclidesResult euclides(const mpz_t a, const mpz_t b);
-ExtendedEuclidesResult extended_euclides(const mpz_t a, const mpz_t b);
\ No newline at end of file
+ExtendedEuclidesResult extended_euclides(const mpz_t a, const mpz_t b);
+
+/**
+ * @brief Temporales de euclides para llamadas repetidas.
+ *
+ * euclides() y extended_euclides() reservan e inicializan sus restos y
+ * coeficientes en cada llamada; con millones de pares eso es casi todo el
+ * coste. Un EuclidesTrabajo se inicializa una vez (uno por hilo) y las
+ * variantes _w de abajo calculan lo mismo sin reservar nada más.
+ */
+typedef struct {
+    mpz_t r0, r1, r2, s0, s1, s2, t0, t1, t2, q;
+} EuclidesTrabajo;
+
+void euclides_trabajo_init(EuclidesTrabajo *w);
+void euclides_trabajo_clear(EuclidesTrabajo *w);
+
+/* Cociente n-ésimo (empezando en 0) que va saliendo de euclides_w */
+typedef void (*EuclidesCociente)(const mpz_t q, int n, void *ctx);
+
+/* Como euclides(): deja el último resto no nulo en mcd, pasa cada cociente a
+ * fn (si no es NULL) y devuelve cuántos hubo */
+int euclides_w(EuclidesTrabajo *w, mpz_t mcd, const mpz_t a, const mpz_t b, EuclidesCociente fn, void *ctx);
+/* Como extended_euclides(): mcd = a·s + b·t */
+void extended_euclides_w(EuclidesTrabajo *w, mpz_t mcd, mpz_t s, mpz_t t, const mpz_t a, const mpz_t b);
+
+/* Caminos rápidos sin GMP para 0 <= a, b < 2^63 (mismos resultados) */
+int euclides_u64(uint64_t a, uint64_t b, uint64_t *mcd, uint64_t q[EUCLIDES_U64_PASOS]);
+uint64_t extended_euclides_u64(uint64_t a, uint64_t b, int64_t *s, int64_t *t);
+
+#endif
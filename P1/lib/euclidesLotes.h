@@ -0,0 +1,59 @@
+#ifndef EUCLIDESLOTES_H
+#define EUCLIDESLOTES_H
+
+#include <stdio.h>
+
+/*
+ * Euclides por lotes: millones de pares (a, b) de un fichero o de la entrada
+ * estándar, con los resultados en el mismo orden.
+ *
+ * El hilo principal solo lee y escribe: corta la entrada en lotes de unos
+ * EUC_LOTE bytes (por líneas o por registros completos) y los deja en una cola
+ * circular; los hilos de cálculo interpretan, calculan y dan formato a lotes
+ * enteros, cada uno con sus mpz_t y su EuclidesTrabajo inicializados una sola
+ * vez. Los pares que caben en 63 bits van por los caminos sin GMP.
+ *
+ * Formato de texto: una línea por par, "a b" (o "a,b") en decimal; se saltan
+ * las líneas vacías y las que empiezan por '#'. La salida es una línea por
+ * par: "mcd", "mcd s t" o "mcd q1 q2 ... qn" según el modo, o "error".
+ *
+ * Formato binario: cada número es una cabecera de 16 bits little-endian (bits
+ * 0-14: bytes de la magnitud, como mucho EUC_BIN_MAX; bit 15: signo) seguida
+ * de la magnitud en big-endian; un par son dos números seguidos. La salida usa
+ * la misma codificación: mcd; mcd s t; o mcd, el número de cocientes en 32
+ * bits little-endian y los cocientes. Un par erróneo se escribe como la
+ * cabecera EUC_BIN_ERROR sola, que nunca es la de un número: en la entrada
+ * ocupa solo sus 2 bytes y hace erróneo el par.
+ */
+
+#define EUC_LOTE (1 << 20)      // bytes de entrada por lote
+#define EUC_LOTES_POR_HILO 2    // lotes en vuelo por hilo de cálculo
+#define EUC_BIN_SIGNO 0x8000u
+#define EUC_BIN_LARGO 0x7FFFu   // bits de la cabecera con los bytes de la magnitud
+#define EUC_BIN_MAX 0x7FFEu     // bytes máximos de una magnitud
+#define EUC_BIN_ERROR 0xFFFFu   // signo con 0x7FFF bytes: reservada
+
+typedef enum {
+    EUC_MCD, // solo el mcd
+    EUC_EXT, // mcd y coeficientes de Bézout
+    EUC_CF   // mcd y cocientes (fracción continua de a/b)
+} EucModo;
+
+typedef struct {
+    EucModo modo;
+    int hilos;    // hilos de cálculo (<= 0: uno por procesador)
+    int bin_in;   // entrada en binario
+    int bin_out;  // salida en binario
+} EucOpciones;
+
+typedef struct {
+    long long pares;   // pares procesados (con los erróneos)
+    long long rapidos; // pares por el camino de 64 bits
+    long long errores; // pares que no se pudieron leer
+} EucEstad;
+
+/* Procesa toda la entrada; devuelve 0 o -1 si falla la lectura, la escritura
+ * o la memoria */
+int euclides_lotes(FILE *in, FILE *out, const EucOpciones *op, EucEstad *st);
+
+#endif
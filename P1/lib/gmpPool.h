@@ -0,0 +1,40 @@
+#ifndef GMPPOOL_H
+#define GMPPOOL_H
+
+#include <stdint.h>
+
+/*
+ * Asignador por clases de tamaño para GMP (mp_set_memory_functions).
+ *
+ * Cada mpz_init, cada crecimiento de limbs y cada temporal grande de GMP es un
+ * malloc/realloc/free. Con el pool, los bloques de hasta GMP_POOL_MAX bytes se
+ * redondean a potencias de 2 y se sirven de listas libres por clase; las
+ * listas son de cada hilo (sin cerrojos), así que con varios hilos cada uno
+ * tiene su pool. Las listas vacías se rellenan partiendo losas de
+ * GMP_POOL_LOSA bytes. GMP pasa el tamaño al liberar y al redimensionar, así
+ * que los bloques no llevan cabecera.
+ *
+ * Los contadores dicen cuántas peticiones hizo GMP y cuántas llegaron a
+ * malloc: con el pool puesto, un bucle en régimen no debería sumar ninguna.
+ */
+
+#define GMP_POOL_MIN 16               // clase más pequeña (bytes)
+#define GMP_POOL_CLASES 12            // 16 B .. 32 KiB
+#define GMP_POOL_MAX (GMP_POOL_MIN << (GMP_POOL_CLASES - 1))
+#define GMP_POOL_LOSA (1 << 16)       // bytes por losa
+
+typedef struct {
+    uint64_t peticiones;   // llamadas de GMP: reservar, redimensionar y liberar
+    uint64_t mallocs;      // llamadas a malloc/realloc del sistema (losas y bloques grandes)
+    uint64_t reutilizados; // bloques servidos de una lista libre
+} GmpPoolEstad;
+
+/* Instala el pool. Hay que llamarla antes de crear ningún mpz_t: lo que GMP
+ * haya reservado antes no se puede liberar por el pool */
+void gmp_pool_instalar(void);
+int gmp_pool_activo(void);
+void gmp_pool_estad(GmpPoolEstad *st);
+/* Devuelve las losas al sistema; solo al final, con todos los mpz_t liberados */
+void gmp_pool_liberar(void);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef HISTOGRAMA_H
+#define HISTOGRAMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Histogramas de letras para el criptoanálisis.
+ *
+ * Trabajan sobre texto compacto (solo 'A'..'Z', como el que deja load_text);
+ * cualquier otro byte se cuenta en una casilla de descarte y no avanza nada.
+ * Para no encadenar incrementos sobre el mismo contador (la E y la A se
+ * repiten mucho) se cuenta en varios sub-histogramas intercalados que se
+ * suman al final.
+ */
+
+/* Histograma de text; devuelve el número de letras */
+size_t hist_letras(const char *text, size_t len, uint32_t hist[26]);
+
+/* Histograma de la columna text[inicio], text[inicio + paso], ...; devuelve sus letras */
+size_t hist_columna(const char *text, size_t len, size_t inicio, size_t paso, uint32_t hist[26]);
+
+/* Las n columnas en una sola pasada: text[i] cae en la columna (fase + i) % n */
+void hist_columnas(const char *text, size_t len, int n, int fase, uint32_t (*hist)[26]);
+
+/* Pesos enteros de una distribución de probabilidad (P * 2^16) */
+void pesos26(const double P[26], uint32_t w[26]);
+
+/* Correlación para los 26 desplazamientos: out[k] = Σ_j w[j] * f[(j + k) % 26] */
+void correlacion26(const uint64_t f[26], const uint32_t w[26], uint64_t out[26]);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef INDICE_H
+#define INDICE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Índice de acceso aleatorio a un cifrado: puntos de control dispersos
+ * (byte del cifrado, letras del alfabeto antes de ese byte) que se escriben
+ * al cifrar. Con ellos se puede descifrar un trozo del medio sin recorrer
+ * todo lo anterior: basta con saltar al punto anterior y contar desde ahí.
+ *
+ * Formato (versión INDICE_VERSION): IndiceCab seguida de PuntoControl en
+ * orden creciente; el primero siempre es (0, 0).
+ */
+
+#define INDICE_MAGIC   "CRIPTOI"
+#define INDICE_VERSION 1
+#define INDICE_PASO    (1 << 20) // bytes de cifrado entre puntos de control (como mínimo)
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t paso;
+    uint64_t bytes;  // tamaño del cifrado (se rellena al cerrar)
+    uint64_t letras; // letras del cifrado
+} IndiceCab;
+
+typedef struct {
+    uint64_t byte;
+    uint64_t letras;
+} PuntoControl;
+
+typedef struct {
+    FILE *f;
+    IndiceCab cab;
+    uint64_t siguiente; // byte a partir del cual toca el próximo punto
+} IndiceEscritor;
+
+/* Crea el índice (ruta NULL: ix queda inactivo y anotar no hace nada) */
+int indice_crear(IndiceEscritor *ix, const char *ruta);
+
+/* Anota que tras `byte` bytes de cifrado van `letras` letras (solo si toca) */
+void indice_anotar(IndiceEscritor *ix, uint64_t byte, uint64_t letras);
+
+/* Escribe los totales y cierra; 0 si todo va bien */
+int indice_cerrar(IndiceEscritor *ix, uint64_t bytes, uint64_t letras);
+
+/**
+ * @brief Busca el último punto de control en o antes de `offset`.
+ *
+ * Comprueba que el índice corresponde a un cifrado de `bytes` bytes; si
+ * ruta es NULL, no existe o no encaja, devuelve -1 y deja p = (0, 0).
+ */
+int indice_buscar(const char *ruta, uint64_t bytes, uint64_t offset, PuntoControl *p);
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef INSTR_H
+#define INSTR_H
+
+/*
+ * Instrumentación de los caminos calientes.
+ *
+ * Solo existe si se compila con -DCRIPTO_INSTR (make INSTR=1); si no, todas
+ * las macros se quedan en nada y no cuestan ni una instrucción. Con ella
+ * activa se cuentan bytes, letras y descartes por categoría, bloques,
+ * relleno y reservas de memoria de GMP, y se acumulan ciclos (rdtsc) y
+ * nanosegundos por etapa. El volcado va a stderr al salir o al recibir
+ * SIGUSR1.
+ */
+
+typedef enum {
+    INSTR_BYTES_LEIDOS,
+    INSTR_LETRAS_ASCII,     /* letras A-Z / a-z conservadas */
+    INSTR_LETRAS_UTF8,      /* letras acentuadas / ñ en UTF-8 conservadas */
+    INSTR_DESCARTE_ASCII,   /* bytes ASCII que no son letra */
+    INSTR_DESCARTE_UTF8,    /* secuencias 0xC3 xx sin letra equivalente */
+    INSTR_DESCARTE_OTRO,    /* resto de bytes >= 0x80 */
+    INSTR_BLOQUES,          /* bloques de afin_modificado */
+    INSTR_RELLENO,          /* letras de relleno del último bloque */
+    INSTR_GMP_RESERVAS,     /* llamadas a malloc/realloc hechas por GMP */
+    INSTR_N_CONTADORES
+} InstrContador;
+
+typedef enum {
+    ETAPA_LECTURA,
+    ETAPA_NORMALIZAR,
+    ETAPA_AFIN,
+    ETAPA_BLOQUES,
+    ETAPA_VIGENERE,
+    ETAPA_COLUMNAS,
+    ETAPA_KASISKI,
+    ETAPA_ESCRITURA,
+    INSTR_N_ETAPAS
+} InstrEtapa;
+
+#ifdef CRIPTO_INSTR
+
+#include <time.h>
+
+typedef struct {
+    unsigned long long ciclos;
+    unsigned long long t0_ns;
+} InstrMarca;
+
+extern unsigned long long instr_contadores[INSTR_N_CONTADORES];
+
+InstrMarca instr_marca(void);
+void instr_etapa(InstrEtapa e, InstrMarca desde, unsigned long long letras);
+void instr_volcar(void);
+
+#define INSTR_SUMAR(c, n) \
+    __atomic_fetch_add(&instr_contadores[c], (unsigned long long)(n), __ATOMIC_RELAXED)
+#define INSTR_INICIO(m) InstrMarca m = instr_marca()
+#define INSTR_FIN(e, m, letras) instr_etapa((e), (m), (unsigned long long)(letras))
+
+#else
+
+#define INSTR_SUMAR(c, n) ((void)0)
+#define INSTR_INICIO(m) ((void)0)
+#define INSTR_FIN(e, m, letras) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef IOASINCRONA_H
+#define IOASINCRONA_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/*
+ * Entrada/salida asíncrona por trozos grandes para los caminos de cifrado.
+ *
+ * Con fread/fwrite el cálculo y el disco se turnan: mientras se cifran los
+ * bloques no se lee nada y mientras se lee no se cifra. Aquí hay ES_BUFS
+ * búferes de lectura y otros tantos de escritura y varios están siempre en
+ * vuelo: el lector pide por adelantado los trozos siguientes y el escritor
+ * manda cada trozo cifrado sin esperar a que se escriba.
+ *
+ * Dos motores con el mismo comportamiento:
+ *  - io_uring (llamadas directas al sistema, sin liburing): varias lecturas y
+ *    escrituras posicionales en vuelo a la vez.
+ *  - un hilo de E/S por sentido con pread/pwrite, si io_uring no está
+ *    disponible o se pide expresamente.
+ *
+ * En ficheros regulares se trabaja por desplazamiento (pread/pwrite); en
+ * tuberías y terminales se mantiene el orden con una operación en vuelo.
+ * Con `directo` la entrada se lee con O_DIRECT (no ensucia la caché de
+ * páginas); si el sistema de ficheros no lo admite se avisa y se sigue sin él.
+ */
+
+#define ES_BUFS 4                   // búferes por sentido
+#define ES_TAM_BUF ((size_t)1 << 20) // bytes por búfer (múltiplo de ES_ALINEAR)
+#define ES_ALINEAR 4096              // alineación para O_DIRECT
+
+typedef enum {
+    ES_AUTO,  // io_uring si se puede, hilos si no
+    ES_URING,
+    ES_HILOS
+} EsMotor;
+
+typedef struct {
+    EsMotor motor;
+    int nbufs;      // <= 0: ES_BUFS
+    size_t tam_buf; // 0: ES_TAM_BUF (se redondea a ES_ALINEAR)
+    int directo;    // O_DIRECT en la entrada
+} EsOpciones;
+
+typedef struct EsLector EsLector;
+typedef struct EsEscritor EsEscritor;
+
+/* Lee fd desde su posición actual; NULL si faltan memoria o el hilo de E/S
+ * (la causa se explica en stderr) */
+EsLector *es_lector_abrir(int fd, const EsOpciones *op);
+/**
+ * @brief Siguiente trozo de la entrada, en orden.
+ * *datos queda prestado hasta la próxima llamada. Devuelve los bytes del
+ * trozo, 0 al final o -1 si falla la lectura.
+ */
+ssize_t es_lector_siguiente(EsLector *l, const unsigned char **datos);
+size_t es_lector_tam(const EsLector *l); // tamaño máximo de un trozo
+void es_lector_cerrar(EsLector *l);
+
+/* Escribe en fd desde su posición actual con búferes de tam bytes; NULL
+ * como es_lector_abrir */
+EsEscritor *es_escritor_abrir(int fd, const EsOpciones *op, size_t tam);
+/* Búfer libre donde preparar el siguiente trozo (espera si están todos en vuelo) */
+unsigned char *es_escritor_buffer(EsEscritor *e);
+/* Manda los n primeros bytes del búfer que dio es_escritor_buffer */
+void es_escritor_enviar(EsEscritor *e, size_t n);
+/* Espera a que se escriba todo y libera; devuelve 0 o -1 si algo falló */
+int es_escritor_cerrar(EsEscritor *e);
+
+/* Nombre del motor que se está usando ("io_uring" o "hilos") */
+const char *es_lector_motor(const EsLector *l);
+
+#endif
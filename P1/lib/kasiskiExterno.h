@@ -0,0 +1,42 @@
+#ifndef KASISKIEXTERNO_H
+#define KASISKIEXTERNO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Test de Kasiski en memoria externa, para cifrados que no caben en RAM.
+ *
+ * Una pasada lee la entrada por bloques, la normaliza y reparte cada trigrama
+ * (clave, posición) en KEXT_PARTICIONES ficheros temporales según el rango de
+ * su clave. Cada partición se procesa luego por separado, en paralelo: como
+ * sus registros se escribieron en orden de posición, el MCD de las distancias
+ * se acumula de una sola lectura, sin ordenar nada. El texto se parte en
+ * ventanas de MAX_TEXT letras y cada trigrama vota en cada ventana como en
+ * kasiski() sobre ese trozo (el MCD sobre un texto enorme tiende a 1 o 2); los
+ * votos se suman. Si el texto cabe en una ventana, el informe es el mismo que
+ * el de kasiski().
+ *
+ * La memoria está acotada por mem_limit: la mitad para los búferes de
+ * escritura de las particiones y la otra mitad para los de lectura de los
+ * hilos. Los temporales van a $TMPDIR (o /tmp) y se borran al abrirse.
+ */
+
+#define KEXT_PARTICIONES 64
+#define KEXT_MEM_MIN (1u << 20)            // 1 MiB
+#define KEXT_MEM_DEFECTO ((size_t)256 << 20) // 256 MiB
+
+// Registro de una partición: clave del trigrama en los 15 bits altos y
+// posición (en letras) en los 49 bajos
+#define KEXT_BITS_POS 49
+#define KEXT_MASCARA_POS (((uint64_t)1 << KEXT_BITS_POS) - 1)
+
+/**
+ * @brief Kasiski sobre toda la entrada sin cargarla en memoria.
+ * hilos <= 0 usa tantos como procesadores. Devuelve la longitud de clave más
+ * votada (0 si no hay ninguna) o -1 si hay error.
+ */
+int kasiski_externo(FILE *in, size_t mem_limit, int hilos);
+
+#endif
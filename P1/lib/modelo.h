@@ -0,0 +1,66 @@
+#ifndef MODELO_H
+#define MODELO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Modelos de idioma en binario: unigramas, bigramas y cuadrigramas (A-Z)
+ * en log-probabilidad, entrenados a partir de corpus y proyectados con mmap
+ * sin ningún análisis al arrancar.
+ *
+ * Formato (versión MODELO_VERSION), en el orden de bytes de la máquina:
+ *   ModeloCab | ModeloIdioma[nidiomas]
+ * cada estructura alineada a 64 bytes.
+ */
+
+#define MODELO_MAGIC   "CRIPTOM"
+#define MODELO_VERSION 1
+#define MODELO_MAX_IDIOMAS 16
+#define MODELO_CUAD (26 * 26 * 26 * 26)
+
+typedef struct {
+    _Alignas(64) char magic[8];
+    uint32_t version;
+    uint32_t nidiomas;
+    uint64_t tam_idioma; // sizeof(ModeloIdioma) del que escribió el fichero
+} ModeloCab;
+
+typedef struct {
+    _Alignas(64) char nombre[16];
+    uint64_t letras;          // letras del corpus
+    double p1[26];            // probabilidades de las letras (para IC y M(k))
+    double ic;                // Σ p1²
+    float uni[26];            // log p(a)
+    float bi[26 * 26];        // log p(ab)
+    _Alignas(64) float cuad[MODELO_CUAD]; // log p(abcd); índice ((a*26+b)*26+c)*26+d
+} ModeloIdioma;
+
+typedef struct {
+    void *map;
+    size_t tam;
+    int n;
+    const ModeloIdioma *idiomas;
+} Modelo;
+
+/**
+ * @brief Entrena un idioma con los corpus dados (normalizados con NORM_ES),
+ * contando en paralelo en `hilos` hilos (<= 0: uno por CPU).
+ * @return 0 si todo va bien, -1 si algún fichero no se puede leer.
+ */
+int modelo_entrenar(ModeloIdioma *m, const char *nombre, char *const *ficheros, int nficheros, int hilos);
+
+/* Escribe los idiomas en un fichero de modelo; 0 si todo va bien */
+int modelo_guardar(const char *ruta, const ModeloIdioma *idiomas, int n);
+
+/* Proyecta un fichero de modelo; NULL si no existe o no es válido */
+Modelo *modelo_abrir(const char *ruta);
+void modelo_cerrar(Modelo *m);
+
+/* Idioma por nombre (NULL si no está) */
+const ModeloIdioma *modelo_buscar(const Modelo *m, const char *nombre);
+
+/* Log-verosimilitud media por cuadrigrama de un texto compacto (A-Z) */
+double modelo_puntuar(const ModeloIdioma *m, const char *text, size_t len);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef NORMALIZAR_H
+#define NORMALIZAR_H
+
+#include <stddef.h>
+
+/* Modos de normalización */
+#define NORM_ASCII 0 /* solo A-Z / a-z (las letras que cifra vigenere) */
+#define NORM_ES    1 /* además vocales con tilde/diéresis y ñ en UTF-8 -> A-Z */
+#define NORM_ES27  2 /* como NORM_ES, pero ñ/Ñ (NFC o NFD) -> NORM_ENYE */
+
+/* Byte con el que NORM_ES27 representa la Ñ (Ñ en Latin-1) */
+#define NORM_ENYE 0xD1
+
+/**
+ * @brief Estado de la normalización por bloques.
+ *
+ * Una secuencia UTF-8 de dos bytes puede quedar partida entre dos bloques;
+ * el autómata guarda en `estado` si el bloque anterior terminó en 0xC3.
+ * En NORM_ES27 una N final se retiene hasta ver si la sigue una tilde
+ * combinante (N + 0xCC 0x83 en NFD).
+ */
+typedef struct {
+    int modo;
+    int estado;
+} Normalizador;
+
+/* Tabla byte -> letra mayúscula ('A'..'Z') o 0 si no es letra ASCII */
+extern const unsigned char TABLA_ASCII[256];
+
+void normalizador_init(Normalizador *nz, int modo);
+
+/**
+ * @brief Normaliza un bloque de bytes y escribe solo las letras A-Z en out
+ * (y NORM_ENYE en modo NORM_ES27).
+ *
+ * out debe tener al menos n bytes. Devuelve el número de letras escritas.
+ */
+size_t normalizar_bloque(Normalizador *nz, const unsigned char *in, size_t n, char *out);
+
+/**
+ * @brief Cierra la normalización al final de la entrada.
+ *
+ * Escribe en out la letra retenida (como mucho una) y devuelve cuántas
+ * escribió. Solo hace falta en modo NORM_ES27.
+ */
+size_t normalizar_fin(Normalizador *nz, char *out);
+
+#endif
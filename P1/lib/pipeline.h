@@ -0,0 +1,37 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "alfabeto.h"
+#include <stdio.h>
+#include <gmp.h>
+
+/* Tipos de etapa */
+#define PIPE_VIGENERE 0
+#define PIPE_AFIN     1
+#define PIPE_AFIN_MOD 2
+
+#define PIPE_MAX_ETAPAS 16
+
+/* Descripción de una etapa tal y como llega de la línea de órdenes */
+typedef struct {
+    int tipo;
+    const char *clave; /* PIPE_VIGENERE */
+    mpz_t a, b;        /* PIPE_AFIN y PIPE_AFIN_MOD (módulo según el alfabeto) */
+} PipeEtapaSpec;
+
+/**
+ * @brief Encadena normalización y etapas de cifrado en un solo proceso.
+ *
+ * Cada etapa corre en su propio hilo; entre hilos solo circulan punteros a
+ * buffers de tamaño fijo a través de anillos SPSC sin bloqueos, y cada etapa
+ * transforma el buffer en su sitio. Los buffers llevan índices del alfabeto
+ * alf: el lector los obtiene del texto y el escritor los vuelve a convertir
+ * en texto. Con DECIPHER_AFIN se aplican las
+ * inversas en orden inverso, de modo que la misma lista de etapas deshace
+ * lo que hizo con CIPHER_AFIN.
+ *
+ * @return 0 si todo fue bien, -1 si alguna clave no es válida.
+ */
+int pipeline_ejecutar(FILE *in, FILE *out, const Alfabeto *alf, PipeEtapaSpec *etapas, int n, int modo);
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef SERVICIO_H
+#define SERVICIO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Servicio de cifrado residente sobre un socket Unix.
+ *
+ * Para muchos mensajes pequeños lo que cuesta no es cifrar sino arrancar un
+ * proceso, leer los argumentos y validar la clave. El servicio se queda
+ * escuchando y atiende peticiones enmarcadas:
+ *
+ *   ServPeticion | clave (clave_len bytes) | datos (datos_len bytes)
+ *
+ * y contesta con ServRespuesta | datos. Por una misma conexión pueden ir
+ * tantas peticiones como se quiera, una detrás de otra.
+ *
+ * La clave va en texto, como en las etapas de `cripto pipe`: "CLAVE" para
+ * vigenere y "a,b" para afin y afin_mod. Cada hilo guarda los contextos ya
+ * validados (tablas, inversos, tablas fusionadas) en una caché propia
+ * indexada por un hash de (cifrado, modo, alfabeto, clave), junto con sus
+ * búferes de trabajo: en un acierto no se reserva memoria ni se toca GMP.
+ *
+ * El resultado es el mismo que con los ejecutables de siempre: vigenere con
+ * latin26 respeta lo que no es letra, el resto trabaja con índices del
+ * alfabeto y afin_mod rellena (o ignora al descifrar) el último bloque.
+ */
+
+#define SERV_SOCKET "/tmp/criptod.sock"
+#define SERV_MAGIC 0x54505243u      // "CRPT" en little endian
+#define SERV_MAX_CLAVE 4096
+#define SERV_MAX_DATOS (16u << 20)   // el servicio es para mensajes, no para ficheros grandes
+#define SERV_CACHE 256               // contextos por hilo (correspondencia directa por hash)
+
+/* Estados de respuesta */
+#define SERV_OK 0
+#define SERV_ERR_FORMATO 1 // cabecera, cifrado o alfabeto no válidos
+#define SERV_ERR_CLAVE 2   // la clave no es válida para ese cifrado y alfabeto
+#define SERV_ERR_MEMORIA 3
+
+typedef struct {
+    uint32_t magic;
+    uint8_t cifrado;   // PIPE_VIGENERE, PIPE_AFIN o PIPE_AFIN_MOD (pipeline.h)
+    uint8_t modo;      // CIPHER_AFIN o DECIPHER_AFIN (afin.h)
+    uint8_t alf;       // ALF_LATIN26, ALF_ES27 o ALF_BYTES (alfabeto.h)
+    uint8_t reservado;
+    uint32_t clave_len;
+    uint32_t datos_len;
+} ServPeticion;
+
+typedef struct {
+    uint32_t estado;
+    uint32_t datos_len;
+} ServRespuesta;
+
+/**
+ * @brief Escucha en ruta y atiende con hilos (<= 0: uno por procesador).
+ * Vuelve al recibir SIGINT o SIGTERM: corta las conexiones abiertas, espera a
+ * los hilos y borra el socket.
+ * Devuelve 0 o -1 si no se pudo abrir el socket.
+ */
+int servicio_ejecutar(const char *ruta, int hilos);
+
+/* Cliente: conecta con el servicio; devuelve el descriptor o -1 */
+int servicio_conectar(const char *ruta);
+
+/**
+ * @brief Envía una petición y espera la respuesta.
+ * *resp se amplía con realloc según haga falta (puede reutilizarse entre
+ * llamadas). Devuelve el estado del servicio o -1 si falla la conexión.
+ */
+int servicio_pedir(int fd, const ServPeticion *p, const char *clave, const void *datos,
+                   unsigned char **resp, size_t *cap, size_t *resp_len);
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef TRIAJE_H
+#define TRIAJE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Triaje de cifrados: qué herramienta produjo cada fichero.
+ *
+ * Una sola lectura lineal (de los TRIAJE_MAX_BYTES primeros bytes) saca
+ * estadísticas baratas:
+ *  - histograma de bytes: si hay muchos que no son texto, alfabeto bytes;
+ *  - histograma de símbolos (A-Z y Ñ) e IC global;
+ *  - χ² por letra frente al idioma, sin desplazar (texto en claro o no);
+ *  - IC medio por columnas para n = 2..TRIAJE_MAX_N sobre las primeras
+ *    TRIAJE_LETRAS letras (el primer n que se acerca al idioma es el periodo);
+ *  - fracción de bytes de formato (espacios, signos, saltos de línea):
+ *    vigenere los conserva, afin y afin_mod solo escriben símbolos;
+ *  - IC de la última columna con periodo BLOCK_SIZE: afin_mod deja el dígito
+ *    bajo de cada bloque como una sustitución simple, así que esa columna
+ *    conserva el IC del idioma con el resto del bloque plano.
+ *
+ * Con eso: IC de idioma y sin formato es un afín monoalfabético; IC plano con
+ * un pico periódico (o con formato) es Vigenère; IC plano, sin formato y con
+ * la última columna de cada bloque en el IC del idioma es afin_mod. Los
+ * ficheros se reparten entre hilos.
+ */
+
+#define TRIAJE_MAX_BYTES (1u << 20) // bytes que se leen de cada fichero
+#define TRIAJE_LETRAS 16384         // letras para el IC por columnas
+#define TRIAJE_MAX_N 30             // periodos candidatos (MAX_K_CAND)
+#define TRIAJE_MIN_LETRAS 200       // por debajo no se clasifica
+#define TRIAJE_SIMBOLOS 27          // A-N, Ñ, O-Z (como es27)
+
+typedef enum {
+    TRIAJE_ERROR,
+    TRIAJE_CORTO,       // muy pocos símbolos para decidir
+    TRIAJE_CLARO,       // estadística del idioma sin cifrar
+    TRIAJE_AFIN,        // monoalfabético (afin)
+    TRIAJE_VIGENERE,    // polialfabético; periodo en Triaje.periodo
+    TRIAJE_BLOQUES,     // afin_mod
+    TRIAJE_DESCONOCIDO
+} TriajeTipo;
+
+typedef struct {
+    TriajeTipo tipo;
+    int alf;            // ALF_LATIN26, ALF_ES27 o ALF_BYTES (alfabeto.h)
+    int periodo;        // Vigenère: longitud estimada (0: mayor que TRIAJE_MAX_N)
+    int truncado;       // el fichero es mayor que TRIAJE_MAX_BYTES
+    uint64_t bytes;     // bytes leídos
+    uint64_t simbolos;  // símbolos del alfabeto (bytes con ALF_BYTES)
+    double ic;          // IC global de los símbolos
+    double ic_periodo;  // IC medio por columnas del periodo (o del mejor n)
+    double chi2;        // χ² por letra frente al idioma
+    double ic_bloque;   // IC de la última columna con periodo BLOCK_SIZE (afin_mod)
+    double formato;     // fracción de bytes de formato
+    double cobertura;   // fracción de símbolos del alfabeto que aparecen
+    uint64_t hist[TRIAJE_SIMBOLOS]; // histograma de símbolos (para el ataque al afín)
+} Triaje;
+
+/* Clasifica un fichero; devuelve 0 o -1 si no se pudo leer (t->tipo = TRIAJE_ERROR) */
+int triaje_fichero(const char *ruta, const char *lang, Triaje *t);
+
+/* Clasifica n ficheros en paralelo (hilos <= 0: uno por procesador) */
+void triaje_ficheros(char *const *rutas, int n, const char *lang, int hilos, Triaje *res);
+
+const char *triaje_nombre(TriajeTipo tipo);
+
+/**
+ * @brief Ataque de frecuencias al afín monoalfabético (m = 26 o 27).
+ * Prueba todas las claves (a, b) con el histograma del cifrado y se queda con
+ * la de menor χ² frente al idioma. Devuelve ese χ² por letra y deja en a y b
+ * la clave de cifrado (la que se pasa a afin -D).
+ */
+double afin_mono_ataque(const uint64_t *hist, int m, const char *lang, int *a, int *b);
+
+#endif
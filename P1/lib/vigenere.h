@@ -1,8 +1,39 @@
 #ifndef VIGNERE_H
 #define VIGNERE_H
 
+#include "alfabeto.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/* Núcleo x[i] = (x[i] + shift[j]) mod m sobre índices, especializado por m */
+typedef void (*VigenereNucleo)(unsigned char *x, size_t n, const unsigned char *shift, int klen, int *pos);
+
+/*
+ * Estado de un cifrado Vigenère en curso: la posición en la clave (fase)
+ * solo avanza con las letras A-Z, así que se puede cifrar un texto por
+ * trozos y el resultado es el mismo que de una sola vez.
+ */
+typedef struct {
+    unsigned char *shift; /* desplazamiento de cada letra de la clave */
+    int klen;
+    int pos;              /* posición actual en la clave */
+    const Alfabeto *alf;
+    VigenereNucleo nucleo;
+} VigenereCtx;
+
+/* Alfabeto A-Z sobre texto mezclado: lo que no es letra se copia tal cual */
+int vigenere_ctx_init(VigenereCtx *ctx, const char *key, int encrypt);
+void vigenere_ctx_aplicar(VigenereCtx *ctx, char *text, size_t len);
+
+/* Cualquier alfabeto, sobre buffers de índices (ver alfabeto.h) */
+int vigenere_ctx_init_alf(VigenereCtx *ctx, const Alfabeto *alf, const char *key, int encrypt);
+void vigenere_ctx_indices(VigenereCtx *ctx, unsigned char *idx, size_t n);
+void vigenere_ctx_free(VigenereCtx *ctx);
+
+/* Coloca la fase como si ya se hubieran procesado `letras` letras (acceso aleatorio) */
+void vigenere_ctx_saltar(VigenereCtx *ctx, uint64_t letras);
 
 /*Cifra o descifra el texto */
 void vigenere(char *text, const char *key, int encrypt);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,52 @@
+#!/bin/sh
+# Compara el tiempo de las recetas de uso rápido entre perfiles de compilación.
+# Uso: comparar_perfiles.sh perfil1 perfil2 ... -- receta1 receta2 ...
+# La aceleración se calcula respecto al primer perfil.
+
+perfiles=""
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+    perfiles="$perfiles $1"
+    shift
+done
+[ "$1" = "--" ] && shift
+if [ -z "$perfiles" ] || [ $# -eq 0 ]; then
+    echo "Uso: $0 perfil... -- receta..." >&2
+    exit 1
+fi
+
+# Tiempo en ms de una receta con un perfil (mejor de REPS ejecuciones)
+REPS=${REPS:-3}
+medir() {
+    mejor=""
+    i=0
+    while [ $i -lt "$REPS" ]; do
+        t0=$(date +%s%N)
+        make -s PROFILE="$1" "$2" > /dev/null 2>&1 || { echo "fallo"; return; }
+        t1=$(date +%s%N)
+        t=$(( (t1 - t0) / 1000000 ))
+        if [ -z "$mejor" ] || [ "$t" -lt "$mejor" ]; then mejor=$t; fi
+        i=$((i + 1))
+    done
+    echo "$mejor"
+}
+
+printf "%-28s" "receta"
+for p in $perfiles; do printf "%16s" "$p"; done
+echo
+
+for r in "$@"; do
+    printf "%-28s" "$r"
+    base=""
+    for p in $perfiles; do
+        t=$(medir "$p" "$r")
+        if [ -z "$base" ]; then
+            base=$t
+            printf "%13s ms" "$t"
+        elif [ "$t" = "fallo" ] || [ "$base" = "fallo" ] || [ "$t" -eq 0 ]; then
+            printf "%16s" "$t"
+        else
+            printf "%8s ms %4s" "$t" "$(awk "BEGIN { printf \"%.1fx\", $base / $t }")"
+        fi
+    done
+    echo
+done
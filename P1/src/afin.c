@@ -1,51 +1,59 @@
 #include "afin.h"
+#include "alfabeto.h"
 #include "euclides.h"
+#include "instr.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-/**
- * @brief Normaliza un carácter al alfabeto A–Z (m=26).
- * Convierte tildes y diéresis en su vocal base,
- * convierte ñ/Ñ en N y descarta lo que no sea A–Z.
- *
- * @param c Carácter de entrada.
- * @return Carácter normalizado en A–Z o 0 si no es válido.
- */
-char normalizar_char(FILE *in) {
-    int c = fgetc(in);
-    if (c == EOF) return EOF;
-
-    // ASCII simple
-    if (c >= 'a' && c <= 'z') return c - 'a' + 'A';
-    if (c >= 'A' && c <= 'Z') return c;
-
-    // UTF-8: caracteres multibyte (empezando por 0xC3)
-    if (c == 0xC3) {
-        int next = fgetc(in);
-        if (next == EOF) return EOF;
-        switch (next) {
-            // Vocales mayúsculas
-            case 0x80: case 0x81: case 0x82: case 0x83: case 0x84: return 'A'; // ÀÁÂÃÄ
-            case 0x88: case 0x89: case 0x8A: case 0x8B: return 'E';             // ÈÉÊË
-            case 0x8C: case 0x8D: case 0x8E: case 0x8F: return 'I';             // ÌÍÎÏ
-            case 0x92: case 0x93: case 0x94: case 0x95: case 0x96: return 'O'; // ÒÓÔÕÖ
-            case 0x99: case 0x9A: case 0x9B: case 0x9C: return 'U';             // ÙÚÛÜ
-            case 0x91: return 'N';                                              // Ñ
+#define AFIN_CHUNK 65536 // bytes leídos por bloque
 
-            // Vocales minúsculas
-            case 0xA0: case 0xA1: case 0xA2: case 0xA3: case 0xA4: return 'A'; // àáâãä
-            case 0xA8: case 0xA9: case 0xAA: case 0xAB: return 'E';             // èéêë
-            case 0xAC: case 0xAD: case 0xAE: case 0xAF: return 'I';             // ìíîï
-            case 0xB2: case 0xB3: case 0xB4: case 0xB5: case 0xB6: return 'O'; // òóôõö
-            case 0xB9: case 0xBA: case 0xBB: case 0xBC: return 'U';             // ùúûü
-            case 0xB1: return 'N';                                              // ñ
-            default: return 0;
-        }
+/* Cifra o descifra un flujo con la tabla afín del alfabeto de tamaño m */
+static void afin_flujo(FILE *in, FILE *out, const mpz_t a, const mpz_t b, const mpz_t m, int modo) {
+    if (!in || !out) {
+        fprintf(stderr, "Error: archivo de entrada o salida en NULL\n");
+        return;
+    }
+    if (!a || !b || !m) {
+        fprintf(stderr, "Error: parámetros GMP en NULL\n");
+        return;
     }
 
-    // Otros caracteres no válidos
-    return 0;
+    const Alfabeto *alf = mpz_fits_sint_p(m) ? alfabeto_por_m((int)mpz_get_si(m)) : NULL;
+    if (!alf) {
+        fprintf(stderr, "Error: m no corresponde a ningún alfabeto (26, 27 o 256)\n");
+        return;
+    }
+    // Toda la aritmética GMP se hace una vez, al construir la tabla
+    AfinCtx ctx;
+    if (afin_ctx_init(&ctx, a, b, m, modo) < 0) exit(1);
+
+    AlfLector lr;
+    alf_lector_init(&lr, alf);
+    unsigned char raw[AFIN_CHUNK];
+    unsigned char idx[AFIN_CHUNK + 1];
+    char salida[ALF_MAX_SIMBOLO * (AFIN_CHUNK + 1)];
+    size_t got;
+
+    for (;;) {
+        INSTR_INICIO(t_lec);
+        got = fread(raw, 1, sizeof(raw), in);
+        INSTR_FIN(ETAPA_LECTURA, t_lec, 0);
+        INSTR_SUMAR(INSTR_BYTES_LEIDOS, got);
+
+        INSTR_INICIO(t_norm);
+        size_t n = got ? alf_leer(&lr, raw, got, idx) : alf_leer_fin(&lr, idx);
+        INSTR_FIN(ETAPA_NORMALIZAR, t_norm, n);
+
+        INSTR_INICIO(t_afin);
+        afin_ctx_aplicar(&ctx, idx, n);
+        INSTR_FIN(ETAPA_AFIN, t_afin, n);
+
+        INSTR_INICIO(t_esc);
+        fwrite(salida, 1, alf_escribir(alf, idx, n, salida), out);
+        INSTR_FIN(ETAPA_ESCRITURA, t_esc, 0);
+        if (got == 0) break;
+    }
 }
 
 /**
@@ -53,6 +61,8 @@ char normalizar_char(FILE *in) {
  *
  * Fórmula de cifrado: E(x) = (a*x + b) mod m
  *
+ * El alfabeto lo fija m: 26 (A-Z), 27 (A-Z con Ñ) o 256 (bytes).
+ *
  * @param in  Archivo de entrada (texto plano). Puede ser stdin.
  * @param out Archivo de salida (texto cifrado). Puede ser stdout.
  * @param a   Clave multiplicativa (debe ser coprima con m).
@@ -60,46 +70,7 @@ char normalizar_char(FILE *in) {
  * @param m   Módulo (tamaño del alfabeto).
  */
 void encriptar_afin(FILE *in, FILE *out, const mpz_t a, const mpz_t b, const mpz_t m) {
-    if (!in || !out) {
-        fprintf(stderr, "Error: archivo de entrada o salida en NULL\n");
-        return;
-    }
-
-    if (!a || !b || !m) {
-        fprintf(stderr, "Error: parámetros GMP en NULL\n");
-        return;
-    }
-
-    int c;
-    mpz_t x, y;
-    mpz_inits(x, y, NULL);
-
-    EuclidesResult euc = euclides(a, m);
-
-    if (mpz_cmp_ui(euc.rn, 1) != 0) {
-        fprintf(stderr, "Error: a y M no son coprimos\n");
-        exit(1);
-    }
-
-    while ((c = normalizar_char(in)) != EOF) {
-        if (c == 0) 
-            continue;
-
-        // mapear A=0 ... Z=25
-        int idx = c - 'A';
-
-        // y = (a*x + b) mod 26
-        mpz_set_ui(x, idx);
-        mpz_mul(y, a, x);
-        mpz_add(y, y, b);
-        mpz_mod(y, y, m);   // m=26 fijo
-
-        // volver a letra
-        int out_c = (int)mpz_get_ui(y) + 'A';
-        fputc(out_c, out);
-    }
-
-    mpz_clears(x, y, NULL);
+    afin_flujo(in, out, a, b, m, CIPHER_AFIN);
 }
 
 /**
@@ -111,147 +82,61 @@ void encriptar_afin(FILE *in, FILE *out, const mpz_t a, const mpz_t b, const mpz
  * @param out Archivo de salida (texto claro). Puede ser stdout.
  * @param a   Clave multiplicativa (debe ser coprima con m).
  * @param b   Clave aditiva.
- * @param m   Módulo (tamaño del alfabeto, típicamente 26 o 256).
+ * @param m   Módulo (tamaño del alfabeto: 26, 27 o 256).
  */
 void decriptar_afin(FILE *in, FILE *out, const mpz_t a, const mpz_t b, const mpz_t m) {
-    if (!in || !out) {
-        fprintf(stderr, "Error: archivo de entrada o salida en NULL\n");
-        return;
-    }
-    if (!a || !b || !m) {
-        fprintf(stderr, "Error: parámetros GMP en NULL\n");
-        return;
-    }
+    afin_flujo(in, out, a, b, m, DECIPHER_AFIN);
+}
 
-    // 1) Inverso modular de a mod m usando Euclides extendido
+/**
+ * @brief Prepara la tabla de sustitución de un cifrado afín sobre índices.
+ *
+ * Toda la aritmética GMP se hace aquí una sola vez; después cifrar o
+ * descifrar un símbolo es un acceso a tabla.
+ *
+ * @param modo CIPHER_AFIN o DECIPHER_AFIN.
+ * @return 0 si la clave es válida, -1 si m no está en [2, 256] o a no es invertible.
+ */
+int afin_ctx_init(AfinCtx *ctx, const mpz_t a, const mpz_t b, const mpz_t m, int modo) {
+    if (mpz_cmp_ui(m, 2) < 0 || mpz_cmp_ui(m, 256) > 0) {
+        fprintf(stderr, "Error: la tabla afín admite 2 <= m <= 256\n");
+        return -1;
+    }
+    ctx->m = (int)mpz_get_ui(m);
     ExtendedEuclidesResult ext = extended_euclides(a, m);
     if (mpz_cmp_ui(ext.mcd, 1) != 0) {
         fprintf(stderr, "Error: a y m no son coprimos (mcd != 1); no existe inverso modular.\n");
         mpz_clears(ext.mcd, ext.s, ext.t, NULL);
-        return;
+        return -1;
     }
-    mpz_t ainv;               // a^{-1} mod m
-    mpz_init(ainv);
-    mpz_mod(ainv, ext.s, m);  // ainv = s mod m (ajusta a [0, m))
-
-    // 2) Descifrado byte a byte: x = ainv * ((y - b) mod m) mod m
-    int c;
-    mpz_t y, tmp, x;
-    mpz_inits(y, tmp, x, NULL);
-
-    while ((c = fgetc(in)) != EOF) {
-        if (c < 'A' || c > 'Z') continue; // ignorar todo lo que no sea letra
-
-        int idx = c - 'A';
-        mpz_set_ui(y, idx);
 
-        // tmp = (y - b) mod m
-        mpz_sub(tmp, y, b);
-        mpz_mod(tmp, tmp, m);
-
-        // x = ainv * tmp mod m
-        mpz_mul(x, ainv, tmp);
-        mpz_mod(x, x, m);
-
-        int out_c = (int)mpz_get_ui(x) + 'A';
-        fputc(out_c, out);
+    mpz_t ainv, v;
+    mpz_inits(ainv, v, NULL);
+    mpz_mod(ainv, ext.s, m);
+    for (int idx = 0; idx < ctx->m; ++idx) {
+        if (modo == CIPHER_AFIN) {
+            // y = (a*x + b) mod m
+            mpz_mul_ui(v, a, (unsigned long)idx);
+            mpz_add(v, v, b);
+        } else {
+            // x = ainv * (y - b) mod m
+            mpz_set_ui(v, (unsigned long)idx);
+            mpz_sub(v, v, b);
+            mpz_mul(v, v, ainv);
+        }
+        mpz_mod(v, v, m);
+        ctx->tabla[idx] = (unsigned char)mpz_get_ui(v);
     }
-
-    // 3) Limpieza
-    mpz_clears(y, tmp, x, NULL);
-    mpz_clear(ainv);
+    mpz_clears(ainv, v, NULL);
     mpz_clears(ext.mcd, ext.s, ext.t, NULL);
+    return 0;
 }
 
 /**
- * @brief Main function to test the encryption and decryption functions.
- * @param argc Argument count.
- * @param argv Argument vector.
- * @return Exit status.
- * -C: encrypt
- * -D: decrypt
- * -m: modulo
- * -a: multiplicative key
- * -b: additive key
- * -i: input file (default: stdin)
- * -o: output file (default: stdout)
+ * @brief Sustituye en su sitio un buffer de índices (todos < m).
  */
-int main(int argc, char *argv[]) {
-    if (argc < 8) {  
-        fprintf(stderr, "Uso: %s -C|-D -m <modulo> -a <clave_mult> -b <clave_add> [-i <input>] [-o <output>]\n", argv[0]);
-        return EXIT_FAILURE;
-    }
-
-    int int_m = 0, int_a = 0, int_b = 0;
-    int mode = -1;
-    const char *input_path = NULL;
-    const char *output_path = NULL;
-
-    for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "-C") == 0) {
-            mode = CIPHER_AFIN;
-        } else if (strcmp(argv[i], "-D") == 0) {
-            mode = DECIPHER_AFIN;
-        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
-            int_m = atoi(argv[++i]);
-        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
-            int_a = atoi(argv[++i]);
-        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
-            int_b = atoi(argv[++i]);
-        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
-            input_path = argv[++i];
-        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
-            output_path = argv[++i];
-        } else {
-            fprintf(stderr, "Argumento no reconocido: %s\n", argv[i]);
-            return EXIT_FAILURE;
-        }
-    }
-
-    // Inicializar GMP
-    mpz_t m, a, b;
-    mpz_inits(m, a, b, NULL);
-
-    // Asignar valores de los int a mpz_t
-    mpz_set_ui(m, int_m);
-    mpz_set_ui(a, int_a);
-    mpz_set_ui(b, int_b);
-
-    // Abrir ficheros
-    FILE *in = stdin;
-    FILE *out = stdout;
-    if (input_path) {
-        in = fopen(input_path, "r");
-        if (!in) {
-            perror("Error abriendo input");
-            return EXIT_FAILURE;
-        }
-    }
-    if (output_path) {
-        out = fopen(output_path, "w");
-        if (!out) {
-            perror("Error abriendo output");
-            if (in != stdin) fclose(in);
-            return EXIT_FAILURE;
-        }
-    }
-
-    // Ejecutar cifrado/descifrado
-    if (mode == CIPHER_AFIN) {
-        encriptar_afin(in, out, a, b, m);
-    } else if (mode == DECIPHER_AFIN) {
-        decriptar_afin(in, out, a, b, m);
-    } else {
-        fprintf(stderr, "Debes especificar -C (cifrar) o -D (descifrar).\n");
-        return EXIT_FAILURE;
-    }
-
-    // Cerrar ficheros
-    if (in != stdin) fclose(in);
-    if (out != stdout) fclose(out);
-
-    // Liberar GMP
-    mpz_clears(m, a, b, NULL);
-
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+void afin_ctx_aplicar(const AfinCtx *ctx, unsigned char *idx, size_t n) {
+    const unsigned char *t = ctx->tabla;
+    for (size_t i = 0; i < n; ++i)
+        idx[i] = t[idx[i]];
+}
@@ -1,160 +1,596 @@
+#include "afin_modificado.h"
+#include "afin.h"
 #include "euclides.h"
+#include "gmpPool.h"
+#include "instr.h"
+#include "ioAsincrona.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <gmp.h>
 
-#define BLOCK_SIZE 26
+#define AFIN_MOD_CHUNK 65536 // bytes leídos por bloque
+
+/* ---------- Conversiones en base m ---------- */
+
+/*
+ * Núcleos por alfabeto: se agrupan K dígitos en un unsigned long (M^K < 2^64)
+ * y GMP solo ve una multiplicación (o división) por cada grupo en vez de una
+ * por dígito. Con M constante el compilador cambia % y / por multiplicaciones.
+ */
+#define DEFINIR_BLOQUES(sufijo, M, K)                                           \
+    static void bloque_a_mpz_##sufijo(const unsigned char *d, int L, mpz_t x) { \
+        mpz_set_ui(x, 0);                                                       \
+        for (int i = 0; i < L; i += K) {                                        \
+            int k = (L - i < K) ? L - i : K;                                    \
+            unsigned long v = 0, p = 1;                                         \
+            for (int j = 0; j < k; ++j) {                                       \
+                v = v * M + d[i + j];                                           \
+                p *= M;                                                         \
+            }                                                                   \
+            mpz_mul_ui(x, x, p);                                                \
+            mpz_add_ui(x, x, v);                                                \
+        }                                                                       \
+    }                                                                           \
+    static void mpz_a_bloque_##sufijo(const mpz_t x, int L, unsigned char *d,   \
+                                      mpz_t q) {                                \
+        mpz_set(q, x);                                                          \
+        for (int i = L; i > 0; i -= K) {                                        \
+            int k = (i < K) ? i : K;                                            \
+            unsigned long p = 1;                                                \
+            for (int j = 0; j < k; ++j) p *= M;                                 \
+            unsigned long r = mpz_tdiv_q_ui(q, q, p);                           \
+            for (int j = i - 1; j >= i - k; --j) {                              \
+                d[j] = (unsigned char)(r % M);                                  \
+                r /= M;                                                         \
+            }                                                                   \
+        }                                                                       \
+    }
+
+DEFINIR_BLOQUES(latin26, 26, 13)
+DEFINIR_BLOQUES(es27, 27, 13)
+
+/* m = 256: el bloque ya es el entero en big-endian */
+static void bloque_a_mpz_bytes(const unsigned char *d, int L, mpz_t x) {
+    mpz_import(x, (size_t)L, 1, 1, 0, 0, d);
+}
+
+static void mpz_a_bloque_bytes(const mpz_t x, int L, unsigned char *d, mpz_t q) {
+    (void)q;
+    size_t n = mpz_sgn(x) ? (mpz_sizeinbase(x, 2) + 7) / 8 : 0;
+    memset(d, 0, (size_t)L - n);
+    mpz_export(d + L - n, NULL, 1, 1, 0, 0, x);
+}
+
+static void nucleos(const Alfabeto *alf, BloqueAMpz *a_mpz, MpzABloque *a_bloque) {
+    switch (alf->id) {
+    case ALF_LATIN26: *a_mpz = bloque_a_mpz_latin26; *a_bloque = mpz_a_bloque_latin26; break;
+    case ALF_ES27:    *a_mpz = bloque_a_mpz_es27;    *a_bloque = mpz_a_bloque_es27;    break;
+    default:          *a_mpz = bloque_a_mpz_bytes;   *a_bloque = mpz_a_bloque_bytes;   break;
+    }
+}
+
+void indices_to_mpz(const Alfabeto *alf, const unsigned char *idx, int L, mpz_t x) {
+    BloqueAMpz a_mpz; MpzABloque a_bloque;
+    nucleos(alf, &a_mpz, &a_bloque);
+    a_mpz(idx, L, x);
+}
+
+void mpz_to_indices(const Alfabeto *alf, const mpz_t x, int L, unsigned char *idx) {
+    BloqueAMpz a_mpz; MpzABloque a_bloque;
+    nucleos(alf, &a_mpz, &a_bloque);
+    mpz_t q;
+    mpz_init(q);
+    a_bloque(x, L, idx, q);
+    mpz_clear(q);
+}
+
+void compute_modulus_alf(const Alfabeto *alf, int L, mpz_t M) {
+    mpz_ui_pow_ui(M, (unsigned long)alf->m, (unsigned long)L);
+}
 
 /* ---------- Conversiones base-26 ---------- */
 
 void block_to_mpz(const char *block, int L, mpz_t x) {
-    mpz_set_ui(x, 0);
+    unsigned char d[L];
     for (int i = 0; i < L; ++i) {
-        int d = block[i] - 'A';
-        if (d < 0 || d > 25) d = 0; // saneo
-        mpz_mul_ui(x, x, 26);
-        mpz_add_ui(x, x, (unsigned)d);
+        int v = block[i] - 'A';
+        d[i] = (unsigned char)((v < 0 || v > 25) ? 0 : v); // saneo
     }
+    bloque_a_mpz_latin26(d, L, x);
 }
 
 void mpz_to_block(const mpz_t x_in, int L, char *block_out) {
-    mpz_t x, q, r;
-    mpz_inits(x, q, r, NULL);
-    mpz_set(x, x_in);
+    unsigned char d[L];
+    mpz_t q;
+    mpz_init(q);
+    mpz_a_bloque_latin26(x_in, L, d, q);
+    mpz_clear(q);
+    for (int i = 0; i < L; ++i) block_out[i] = (char)('A' + d[i]);
+}
+
+void compute_modulus(int L, mpz_t M) {
+    mpz_ui_pow_ui(M, 26, (unsigned long)L);
+}
+
+/* ---------- Tablas fusionadas por posición y dígito ---------- */
 
-    for (int i = 0; i < L; ++i) block_out[i] = 'A'; // padding por defecto
+/*
+ * La transformación es lineal en los dígitos: con x = Σ d_i·m^(L-1-i),
+ * y = a·x + b = b + Σ (a·m^(L-1-i)·d_i) mod M. Por cada clave se guarda
+ * T[i][d] = a·m^(L-1-i)·d mod M y cada bloque queda en L consultas y sumas
+ * modulares en enteros de ancho fijo, sin GMP. Al descifrar se usa la misma
+ * forma con a^-1 y -a^-1·b.
+ *
+ * m = 26, 27: M < 2^124 cabe en un unsigned __int128; los dígitos de salida
+ * se sacan partiendo y en y = q·m^13 + r con un recíproco precalculado de
+ * m^13 (q y r caben en 64 bits).
+ * m = 256: M = 2^208 es una potencia de 2, así que se suma en 4 palabras de
+ * 64 bits, se trunca y los dígitos son directamente los bytes.
+ */
 
-    for (int pos = L - 1; pos >= 0 && mpz_sgn(x) > 0; --pos) {
-        mpz_tdiv_qr_ui(q, r, x, 26);
-        unsigned long rem = mpz_get_ui(r);
-        block_out[pos] = (char)('A' + rem);
-        mpz_set(x, q);
+typedef unsigned __int128 u128;
+
+#define FUSION_MITAD 13 // dígitos de cada mitad (m^13 < 2^64)
+// aligned_alloc pide un tamaño múltiplo de la alineación
+#define FUSION_TAM(t) ((sizeof(t) + 63) & ~(size_t)63)
+
+typedef struct {
+    u128 M, D, R; // M = m^L, D = m^13, R = floor((2^128 - 1) / D)
+    u128 b;
+    u128 T[BLOCK_SIZE][27];
+} FusionCorta;
+
+typedef struct {
+    uint64_t b[4];
+    uint64_t T[BLOCK_SIZE][256][4]; // palabras de menos a más significativa
+} FusionBytes;
+
+static u128 mpz_a_u128(const mpz_t x) {
+    return ((u128)mpz_getlimbn(x, 1) << 64) | mpz_getlimbn(x, 0);
+}
+
+// floor(s·R / 2^128) sin desbordar (s < 2^124, R < 2^68)
+static inline uint64_t mulhi_u128(u128 s, u128 R) {
+    uint64_t s0 = (uint64_t)s, s1 = (uint64_t)(s >> 64);
+    uint64_t R0 = (uint64_t)R, R1 = (uint64_t)(R >> 64);
+    u128 t = (u128)s1 * R0 + (u128)s0 * R1 + (((u128)s0 * R0) >> 64);
+    return (uint64_t)((u128)s1 * R1 + (t >> 64));
+}
+
+#define DEFINIR_FUSION(sufijo, MM)                                             \
+    static void fusion_##sufijo(const void *tablas, unsigned char *d) {        \
+        const FusionCorta *f = tablas;                                         \
+        u128 s = f->b;                                                         \
+        for (int i = 0; i < BLOCK_SIZE; ++i) {                                 \
+            s += f->T[i][d[i]];                                                \
+            s -= (s >= f->M) ? f->M : 0;                                       \
+        }                                                                      \
+        uint64_t q = mulhi_u128(s, f->R);                                      \
+        u128 r = s - (u128)q * f->D;                                           \
+        while (r >= f->D) { r -= f->D; ++q; }                                  \
+        uint64_t lo = (uint64_t)r;                                             \
+        for (int j = BLOCK_SIZE - 1; j >= BLOCK_SIZE - FUSION_MITAD; --j) {    \
+            d[j] = (unsigned char)(lo % MM);                                   \
+            lo /= MM;                                                          \
+        }                                                                      \
+        for (int j = BLOCK_SIZE - FUSION_MITAD - 1; j >= 0; --j) {             \
+            d[j] = (unsigned char)(q % MM);                                    \
+            q /= MM;                                                           \
+        }                                                                      \
     }
 
-    mpz_clears(x, q, r, NULL);
+DEFINIR_FUSION(latin26, 26)
+DEFINIR_FUSION(es27, 27)
+
+static void fusion_bytes(const void *tablas, unsigned char *d) {
+    const FusionBytes *f = tablas;
+    uint64_t s0 = f->b[0], s1 = f->b[1], s2 = f->b[2], s3 = f->b[3];
+    for (int i = 0; i < BLOCK_SIZE; ++i) {
+        const uint64_t *t = f->T[i][d[i]];
+        u128 c = (u128)s0 + t[0];
+        s0 = (uint64_t)c;
+        c = (u128)s1 + t[1] + (uint64_t)(c >> 64);
+        s1 = (uint64_t)c;
+        c = (u128)s2 + t[2] + (uint64_t)(c >> 64);
+        s2 = (uint64_t)c;
+        s3 += t[3] + (uint64_t)(c >> 64); // lo que pase de 2^208 se descarta al final
+    }
+    uint64_t w[4] = {s0, s1, s2, s3};
+    for (int j = 0; j < BLOCK_SIZE; ++j) {
+        int bit = 8 * (BLOCK_SIZE - 1 - j);
+        d[j] = (unsigned char)(w[bit / 64] >> (bit % 64));
+    }
 }
 
-void compute_modulus(int L, mpz_t M) {
-    mpz_ui_pow_ui(M, 26, (unsigned long)L);
+static int fusion_permitida = 1;
+
+void afin_mod_sin_fusion(void) {
+    fusion_permitida = 0;
 }
 
-/* ---------- Cifrar / Descifrar por bloques ---------- */
+/*
+ * Prepara las tablas para y = a·x + b mod M (a y b ya en la forma de cifrar).
+ * Solo si M es m^BLOCK_SIZE: con otro módulo (o sin fusión) se sigue por GMP.
+ */
+static void fusion_preparar(AfinModCtx *ctx, const mpz_t a, const mpz_t b) {
+    ctx->tablas = NULL;
+    ctx->fusion = NULL;
+    mpz_t Mm, p, t;
+    mpz_inits(Mm, p, t, NULL);
+    compute_modulus_alf(ctx->alf, BLOCK_SIZE, Mm);
+    if (!fusion_permitida || mpz_cmp(Mm, ctx->M) != 0) goto fin;
 
-void encriptar_afin_bloques(FILE *in, FILE *out,
-                            const mpz_t a, const mpz_t b, const mpz_t M) {
-    char bloque[BLOCK_SIZE];
-    size_t count = 0;
-    mpz_t x, y;
-    mpz_inits(x, y, NULL);
+    int m = ctx->alf->m;
+    if (m == 256) {
+        FusionBytes *f = aligned_alloc(64, FUSION_TAM(FusionBytes));
+        if (!f) goto fin;
+        memset(f, 0, sizeof(*f));
+        mpz_mod(t, b, ctx->M);
+        mpz_export(f->b, NULL, -1, 8, 0, 0, t);
+        for (int i = BLOCK_SIZE - 1; i >= 0; --i) {
+            // p = a·256^(L-1-i) mod M
+            mpz_mul_2exp(p, a, 8 * (BLOCK_SIZE - 1 - i));
+            mpz_mod(p, p, ctx->M);
+            for (int dd = 1; dd < 256; ++dd) {
+                mpz_mul_ui(t, p, (unsigned long)dd);
+                mpz_mod(t, t, ctx->M);
+                mpz_export(f->T[i][dd], NULL, -1, 8, 0, 0, t);
+            }
+        }
+        ctx->tablas = f;
+        ctx->fusion = fusion_bytes;
+    } else {
+        FusionCorta *f = aligned_alloc(64, FUSION_TAM(FusionCorta));
+        if (!f) goto fin;
+        memset(f, 0, sizeof(*f));
+        f->M = mpz_a_u128(ctx->M);
+        mpz_ui_pow_ui(t, (unsigned long)m, FUSION_MITAD);
+        f->D = mpz_a_u128(t);
+        f->R = ~(u128)0 / f->D;
+        mpz_mod(t, b, ctx->M);
+        f->b = mpz_a_u128(t);
+        mpz_mod(p, a, ctx->M);
+        for (int i = BLOCK_SIZE - 1; i >= 0; --i) {
+            // p = a·m^(L-1-i) mod M; T[i][d] = d·p mod M (sumas sucesivas)
+            u128 pi = mpz_a_u128(p), acc = 0;
+            for (int dd = 0; dd < m; ++dd) {
+                f->T[i][dd] = acc;
+                acc += pi;
+                acc -= (acc >= f->M) ? f->M : 0;
+            }
+            mpz_mul_ui(p, p, (unsigned long)m);
+            mpz_mod(p, p, ctx->M);
+        }
+        ctx->tablas = f;
+        ctx->fusion = m == 26 ? fusion_latin26 : fusion_es27;
+    }
+fin:
+    mpz_clears(Mm, p, t, NULL);
+}
+
+/* ---------- Cifrado de buffers en memoria ---------- */
 
-    ExtendedEuclidesResult ext = extended_euclides(a, M);
-    if (mpz_cmp_ui(ext.mcd, 1) != 0) {
+/*
+ * Los temporales del camino con GMP se dimensionan aquí una vez: con a, b y x
+ * reducidos mod M, a·x cabe en 2·bits(M), así que el bucle no hace crecer
+ * ningún mpz_t ni pide memoria.
+ */
+static int ctx_preparar(AfinModCtx *ctx, const Alfabeto *alf, const mpz_t a, const mpz_t b,
+                        const mpz_t M, int modo) {
+    mp_bitcnt_t bits = 2 * mpz_sizeinbase(M, 2) + GMP_NUMB_BITS;
+    mpz_inits(ctx->a, ctx->b, ctx->M, NULL);
+    mpz_init2(ctx->x, bits);
+    mpz_init2(ctx->y, bits);
+    mpz_set(ctx->M, M);
+    ctx->alf = alf;
+    ctx->modo = modo;
+    nucleos(alf, &ctx->a_mpz, &ctx->a_bloque);
+
+    ExtendedEuclidesResult ext = extended_euclides(a, ctx->M);
+    int ok = (mpz_cmp_ui(ext.mcd, 1) == 0);
+    ctx->tablas = NULL;
+    ctx->fusion = NULL;
+    if (ok) {
+        if (modo == CIPHER_AFIN) mpz_mod(ctx->a, a, ctx->M);
+        else mpz_mod(ctx->a, ext.s, ctx->M);
+        mpz_mod(ctx->b, b, ctx->M);
+        // Al descifrar, a^-1·(x - b) = a^-1·x + (-a^-1·b)
+        if (modo == CIPHER_AFIN) {
+            fusion_preparar(ctx, ctx->a, ctx->b);
+        } else {
+            mpz_mul(ctx->y, ctx->a, ctx->b);
+            mpz_neg(ctx->y, ctx->y);
+            fusion_preparar(ctx, ctx->a, ctx->y);
+        }
+    } else {
         fprintf(stderr, "No existe inverso de a mod M.\n");
-        mpz_clears(ext.mcd, ext.s, ext.t, NULL);
+        mpz_clears(ctx->a, ctx->b, ctx->M, ctx->x, ctx->y, NULL);
+    }
+    mpz_clears(ext.mcd, ext.s, ext.t, NULL);
+    return ok ? 0 : -1;
+}
+
+int afin_mod_ctx_init(AfinModCtx *ctx, const Alfabeto *alf, const mpz_t a, const mpz_t b, int modo) {
+    mpz_t M;
+    mpz_init(M);
+    compute_modulus_alf(alf, BLOCK_SIZE, M);
+    int r = ctx_preparar(ctx, alf, a, b, M, modo);
+    mpz_clear(M);
+    return r;
+}
+
+void afin_mod_ctx_bloques(AfinModCtx *ctx, unsigned char *idx, size_t nbloques) {
+    if (ctx->fusion) {
+        for (size_t k = 0; k < nbloques; ++k) ctx->fusion(ctx->tablas, idx + k * BLOCK_SIZE);
         return;
     }
+    for (size_t k = 0; k < nbloques; ++k) {
+        unsigned char *bloque = idx + k * BLOCK_SIZE;
+        ctx->a_mpz(bloque, BLOCK_SIZE, ctx->x);
+        if (ctx->modo == CIPHER_AFIN) {
+            mpz_mul(ctx->y, ctx->a, ctx->x);
+            mpz_add(ctx->y, ctx->y, ctx->b);
+        } else {
+            // Sin alias en mpz_mul: con y de entrada y salida GMP copia el operando a un temporal
+            mpz_sub(ctx->x, ctx->x, ctx->b);
+            mpz_mul(ctx->y, ctx->a, ctx->x);
+        }
+        mpz_mod(ctx->y, ctx->y, ctx->M);
+        ctx->a_bloque(ctx->y, BLOCK_SIZE, bloque, ctx->x);
+    }
+}
+
+void afin_mod_ctx_free(AfinModCtx *ctx) {
+    mpz_clears(ctx->a, ctx->b, ctx->M, ctx->x, ctx->y, NULL);
+    free(ctx->tablas);
+}
+
+/* ---------- Cifrar / Descifrar por bloques ---------- */
+
+/*
+ * Lee, pasa a índices y cifra todos los bloques completos de cada trozo; lo
+ * que sobra pasa al principio del siguiente. Al cifrar, el último bloque se
+ * rellena con el índice 0 ('A'); al descifrar, un bloque incompleto se ignora.
+ * Con ix se anotan puntos de control de la salida (siempre en un borde de
+ * bloque) y se cierra el índice al terminar.
+ * Con es, la lectura y la escritura van por ioAsincrona (trozos grandes en
+ * vuelo mientras se cifra) en vez de fread/fwrite.
+ */
+static int afin_bloques_flujo(FILE *in, FILE *out, const Alfabeto *alf,
+                              const mpz_t a, const mpz_t b, const mpz_t M, int modo,
+                              IndiceEscritor *ix, const EsOpciones *es) {
+    AfinModCtx ctx;
+    if (ctx_preparar(&ctx, alf, a, b, M, modo) < 0) return -1;
+
+    AlfLector lr;
+    alf_lector_init(&lr, alf);
+    EsLector *lec = NULL;
+    EsEscritor *esc = NULL;
+    size_t trozo = AFIN_MOD_CHUNK;
+    int ok = 1;
+    if (es) {
+        fflush(out);
+        lec = es_lector_abrir(fileno(in), es);
+        trozo = lec ? es_lector_tam(lec) : 0;
+        esc = lec ? es_escritor_abrir(fileno(out), es, ALF_MAX_SIMBOLO * (trozo + 2 * BLOCK_SIZE)) : NULL;
+    }
+    unsigned char *raw = es ? NULL : malloc(AFIN_MOD_CHUNK);
+    unsigned char *idx = malloc(trozo + 2 * BLOCK_SIZE);
+    char *salida = es ? NULL : malloc(ALF_MAX_SIMBOLO * (AFIN_MOD_CHUNK + 2 * BLOCK_SIZE));
+    if (es && !esc) {
+        // ioAsincrona ya ha dicho la causa (memoria o hilo de E/S)
+        fprintf(stderr, "Error: no se pudo preparar la E/S asíncrona.\n");
+        ok = 0;
+        goto fin;
+    }
+    if ((!es && (!raw || !salida)) || !idx) {
+        fprintf(stderr, "Error: sin memoria.\n");
+        ok = 0;
+        goto fin;
+    }
+
+    size_t pend = 0; // índices de un bloque incompleto del trozo anterior
+    uint64_t bytes_sal = 0, letras_sal = 0;
+    GmpPoolEstad pool0 = { 0, 0, 0 }; // contadores de GMP tras el primer trozo
+    int trozos = 0;
+    for (;;) {
+        INSTR_INICIO(t_lec);
+        size_t got;
+        if (es) {
+            const unsigned char *datos;
+            ssize_t r = es_lector_siguiente(lec, &datos);
+            if (r < 0) {
+                perror("Error leyendo");
+                ok = 0;
+                break;
+            }
+            got = (size_t)r;
+            raw = (unsigned char *)datos;
+        } else {
+            got = fread(raw, 1, AFIN_MOD_CHUNK, in);
+        }
+        INSTR_FIN(ETAPA_LECTURA, t_lec, 0);
+        INSTR_SUMAR(INSTR_BYTES_LEIDOS, got);
+
+        INSTR_INICIO(t_norm);
+        size_t n = got ? alf_leer(&lr, raw, got, idx + pend) : alf_leer_fin(&lr, idx + pend);
+        INSTR_FIN(ETAPA_NORMALIZAR, t_norm, n);
+        n += pend;
 
-    int c;
-    while ((c = fgetc(in)) != EOF) {
-        if (c >= 'a' && c <= 'z') c -= 32; // minúscula → mayúscula
-        if (c < 'A' || c > 'Z') continue;  // ignora no letras
-        bloque[count++] = (char)c;
-
-        if (count == BLOCK_SIZE) {
-            block_to_mpz(bloque, BLOCK_SIZE, x);
-            mpz_mul(y, a, x);
-            mpz_add(y, y, b);
-            mpz_mod(y, y, M);
-            mpz_to_block(y, BLOCK_SIZE, bloque);
-            fwrite(bloque, sizeof(char), BLOCK_SIZE, out);
-            count = 0;
+        if (got == 0 && n % BLOCK_SIZE) {
+            if (modo == CIPHER_AFIN) {
+                INSTR_SUMAR(INSTR_RELLENO, BLOCK_SIZE - n % BLOCK_SIZE);
+                while (n % BLOCK_SIZE) idx[n++] = 0;
+            } else {
+                n -= n % BLOCK_SIZE;
+            }
         }
+
+        INSTR_INICIO(t_blq);
+        size_t nbloques = n / BLOCK_SIZE;
+        afin_mod_ctx_bloques(&ctx, idx, nbloques);
+        INSTR_SUMAR(INSTR_BLOQUES, nbloques);
+        INSTR_FIN(ETAPA_BLOQUES, t_blq, nbloques * BLOCK_SIZE);
+
+        INSTR_INICIO(t_esc);
+        char *sal = es ? (char *)es_escritor_buffer(esc) : salida;
+        size_t nsal = alf_escribir(alf, idx, nbloques * BLOCK_SIZE, sal);
+        if (es)
+            es_escritor_enviar(esc, nsal);
+        else
+            fwrite(sal, 1, nsal, out);
+        INSTR_FIN(ETAPA_ESCRITURA, t_esc, 0);
+        bytes_sal += nsal;
+        letras_sal += nbloques * BLOCK_SIZE;
+        if (ix) indice_anotar(ix, bytes_sal, letras_sal);
+
+        pend = n - nbloques * BLOCK_SIZE;
+        memmove(idx, idx + nbloques * BLOCK_SIZE, pend);
+        if (++trozos == 1) gmp_pool_estad(&pool0);
+        if (got == 0) break;
+    }
+    if (gmp_pool_activo() && trozos > 1) {
+        GmpPoolEstad pool1;
+        gmp_pool_estad(&pool1);
+        fprintf(stderr, "GMP en régimen (%d trozos): %llu peticiones, %llu malloc\n", trozos - 1,
+                (unsigned long long)(pool1.peticiones - pool0.peticiones),
+                (unsigned long long)(pool1.mallocs - pool0.mallocs));
     }
 
-    // último bloque (rellenar con 'A')
-    if (count > 0) {
-        for (size_t i = count; i < BLOCK_SIZE; ++i)
-            bloque[i] = 'A';
-        block_to_mpz(bloque, BLOCK_SIZE, x);
-        mpz_mul(y, a, x);
-        mpz_add(y, y, b);
-        mpz_mod(y, y, M);
-        mpz_to_block(y, BLOCK_SIZE, bloque);
-        fwrite(bloque, sizeof(char), BLOCK_SIZE, out);
+fin:
+    if (ix && indice_cerrar(ix, bytes_sal, letras_sal) < 0)
+        fprintf(stderr, "Error escribiendo el índice.\n");
+    if (es) {
+        if (esc && es_escritor_cerrar(esc) < 0) {
+            perror("Error escribiendo");
+            ok = 0;
+        }
+        es_lector_cerrar(lec);
+    } else {
+        free(raw);
+        free(salida);
     }
+    free(idx);
+    afin_mod_ctx_free(&ctx);
+    return ok ? 0 : -1;
+}
 
-    mpz_clears(x, y, NULL);
+void encriptar_afin_bloques(FILE *in, FILE *out,
+                            const mpz_t a, const mpz_t b, const mpz_t M) {
+    afin_bloques_flujo(in, out, alfabeto_por_m(26), a, b, M, CIPHER_AFIN, NULL, NULL);
 }
 
 void decriptar_afin_bloques(FILE *in, FILE *out,
                             const mpz_t a, const mpz_t b, const mpz_t M) {
-    ExtendedEuclidesResult ext = extended_euclides(a, M);
-    if (mpz_cmp_ui(ext.mcd, 1) != 0) {
-        fprintf(stderr, "No existe inverso de a mod M.\n");
-        mpz_clears(ext.mcd, ext.s, ext.t, NULL);
-        return;
-    }
+    afin_bloques_flujo(in, out, alfabeto_por_m(26), a, b, M, DECIPHER_AFIN, NULL, NULL);
+}
 
-    mpz_t a_inv, x, y, tmp;
-    mpz_inits(a_inv, x, y, tmp, NULL);
-    mpz_mod(a_inv, ext.s, M);
+void encriptar_afin_bloques_alf(FILE *in, FILE *out, const Alfabeto *alf,
+                                const mpz_t a, const mpz_t b) {
+    encriptar_afin_bloques_indice(in, out, alf, a, b, NULL);
+}
 
-    char bloque[BLOCK_SIZE];
-    while (fread(bloque, sizeof(char), BLOCK_SIZE, in) == BLOCK_SIZE) {
-        block_to_mpz(bloque, BLOCK_SIZE, y);
-        mpz_sub(tmp, y, b);
-        mpz_mod(tmp, tmp, M);
-        mpz_mul(x, a_inv, tmp);
-        mpz_mod(x, x, M);
-        mpz_to_block(x, BLOCK_SIZE, bloque);
-        fwrite(bloque, sizeof(char), BLOCK_SIZE, out);
-    }
+void decriptar_afin_bloques_alf(FILE *in, FILE *out, const Alfabeto *alf,
+                                const mpz_t a, const mpz_t b) {
+    mpz_t M;
+    mpz_init(M);
+    compute_modulus_alf(alf, BLOCK_SIZE, M);
+    afin_bloques_flujo(in, out, alf, a, b, M, DECIPHER_AFIN, NULL, NULL);
+    mpz_clear(M);
+}
 
-    mpz_clears(a_inv, x, y, tmp, NULL);
-    mpz_clears(ext.mcd, ext.s, ext.t, NULL);
+int encriptar_afin_bloques_indice(FILE *in, FILE *out, const Alfabeto *alf,
+                                  const mpz_t a, const mpz_t b, const char *ruta_indice) {
+    return afin_bloques_es(in, out, alf, a, b, CIPHER_AFIN, ruta_indice, NULL);
 }
 
-/* ---------- Programa principal ---------- */
+int afin_bloques_es(FILE *in, FILE *out, const Alfabeto *alf, const mpz_t a, const mpz_t b, int modo,
+                    const char *ruta_indice, const EsOpciones *es) {
+    IndiceEscritor ix;
+    if (modo != CIPHER_AFIN) ruta_indice = NULL; // el índice se escribe al cifrar
+    if (indice_crear(&ix, ruta_indice) < 0) return -1;
+    mpz_t M;
+    mpz_init(M);
+    compute_modulus_alf(alf, BLOCK_SIZE, M);
+    int r = afin_bloques_flujo(in, out, alf, a, b, M, modo, ruta_indice ? &ix : NULL, es);
+    mpz_clear(M);
+    return r;
+}
 
-int main(int argc, char *argv[]) {
-    if (argc < 8) {
-        fprintf(stderr, "Uso: %s -C|-D -a <clave_mult> -b <clave_add> [-i in] [-o out]\n", argv[0]);
-        return EXIT_FAILURE;
+/* ---------- Descifrado de un rango ---------- */
+
+/*
+ * Salta al punto de control anterior a offset y cuenta letras hasta él
+ * guardando solo la cola del bloque en curso; después descifra los bloques
+ * que tocan [offset, offset + length) y escribe solo las letras del rango.
+ */
+int decriptar_afin_bloques_rango(FILE *in, FILE *out, const Alfabeto *alf, const mpz_t a, const mpz_t b,
+                                 const char *ruta_indice, uint64_t offset, uint64_t length) {
+    struct stat st;
+    if (fstat(fileno(in), &st) < 0 || !S_ISREG(st.st_mode)) {
+        fprintf(stderr, "El descifrado por rangos necesita un fichero regular.\n");
+        return -1;
     }
+    uint64_t bytes = (uint64_t)st.st_size;
+    if (offset > bytes) offset = bytes;
+    if (length > bytes - offset) length = bytes - offset;
+    uint64_t fin_rango = offset + length;
 
-    int mode = -1;
-    const char *input_path = NULL, *output_path = NULL;
-    char *a_str = NULL, *b_str = NULL;
+    AfinModCtx ctx;
+    if (afin_mod_ctx_init(&ctx, alf, a, b, DECIPHER_AFIN) < 0) return -1;
 
-    for (int i = 1; i < argc; ++i) {
-        if (!strcmp(argv[i], "-C")) mode = 0;
-        else if (!strcmp(argv[i], "-D")) mode = 1;
-        else if (!strcmp(argv[i], "-a") && i + 1 < argc) a_str = argv[++i];
-        else if (!strcmp(argv[i], "-b") && i + 1 < argc) b_str = argv[++i];
-        else if (!strcmp(argv[i], "-i") && i + 1 < argc) input_path = argv[++i];
-        else if (!strcmp(argv[i], "-o") && i + 1 < argc) output_path = argv[++i];
-    }
+    PuntoControl p;
+    indice_buscar(ruta_indice, bytes, offset, &p);
+    if (p.letras % BLOCK_SIZE) p.byte = p.letras = 0; // no es un borde de bloque
+    if (fseeko(in, (off_t)p.byte, SEEK_SET) < 0) { perror("fseek"); afin_mod_ctx_free(&ctx); return -1; }
+
+    AlfLector lr;
+    alf_lector_init(&lr, alf);
+    unsigned char *raw = malloc(AFIN_MOD_CHUNK);
+    unsigned char *idx = malloc(AFIN_MOD_CHUNK + 2 * BLOCK_SIZE);
+    char *salida = malloc(ALF_MAX_SIMBOLO * (AFIN_MOD_CHUNK + 2 * BLOCK_SIZE));
+    int r = 0;
+    if (!raw || !idx || !salida) { fprintf(stderr, "Error: sin memoria.\n"); r = -1; goto fin; }
 
-    FILE *in = input_path ? fopen(input_path, "r") : stdin;
-    FILE *out = output_path ? fopen(output_path, "w") : stdout;
-    if (!in || !out) { perror("fopen"); return EXIT_FAILURE; }
+    // idx[0] es siempre la letra `base`, que empieza un bloque
+    uint64_t pos = p.byte, base = p.letras, l_ini = 0, l_fin = UINT64_MAX;
+    size_t pend = 0;
+    int en_rango = 0;
+    for (;;) {
+        if (!en_rango && pos >= offset) { en_rango = 1; l_ini = base + pend; }
+        if (en_rango && l_fin == UINT64_MAX && pos >= fin_rango) l_fin = base + pend;
+        if (base >= l_fin) break;
 
-    mpz_t a, b, M;
-    mpz_inits(a, b, M, NULL);
-    mpz_set_str(a, a_str, 10);
-    mpz_set_str(b, b_str, 10);
-    compute_modulus(BLOCK_SIZE, M);
+        // Hasta offset y hasta el final del rango se lee justo lo necesario
+        size_t want = AFIN_MOD_CHUNK;
+        if (pos < offset && offset - pos < want) want = (size_t)(offset - pos);
+        else if (pos >= offset && pos < fin_rango && fin_rango - pos < want) want = (size_t)(fin_rango - pos);
+        size_t got = fread(raw, 1, want, in);
+        pos += got;
+        size_t n = got ? alf_leer(&lr, raw, got, idx + pend) : alf_leer_fin(&lr, idx + pend);
+        n += pend;
+        size_t nbloques = n / BLOCK_SIZE;
 
-    if (mode == 0)
-        encriptar_afin_bloques(in, out, a, b, M);
-    else if (mode == 1)
-        decriptar_afin_bloques(in, out, a, b, M);
-    else
-        fprintf(stderr, "Debes indicar -C o -D.\n");
+        if (en_rango) {
+            afin_mod_ctx_bloques(&ctx, idx, nbloques);
+            uint64_t desde = base > l_ini ? base : l_ini;
+            uint64_t hasta = base + nbloques * BLOCK_SIZE;
+            if (hasta > l_fin) hasta = l_fin;
+            if (hasta > desde)
+                fwrite(salida, 1, alf_escribir(alf, idx + (desde - base), (size_t)(hasta - desde), salida), out);
+        }
+        pend = n - nbloques * BLOCK_SIZE;
+        memmove(idx, idx + nbloques * BLOCK_SIZE, pend);
+        base += nbloques * BLOCK_SIZE;
+        if (got == 0) break; // un bloque incompleto al final se ignora, como al descifrar entero
+    }
 
-    mpz_clears(a, b, M, NULL);
-    if (in != stdin) fclose(in);
-    if (out != stdout) fclose(out);
-    return EXIT_SUCCESS;
+fin:
+    free(raw);
+    free(idx);
+    free(salida);
+    afin_mod_ctx_free(&ctx);
+    return r;
 }
@@ -0,0 +1,105 @@
+#include "alfabeto.h"
+#include <string.h>
+#include <strings.h>
+
+#define ES27_ENYE 14 /* índice de la Ñ en ALF_ES27 */
+
+static const Alfabeto ALFABETOS[] = {
+    { ALF_LATIN26, "latin26", 26 },
+    { ALF_ES27,    "es27",    27 },
+    { ALF_BYTES,   "bytes",   256 },
+};
+#define N_ALFABETOS (int)(sizeof(ALFABETOS) / sizeof(ALFABETOS[0]))
+
+/* ES27: letra normalizada (A-Z o NORM_ENYE) -> índice */
+#define I(c, i) [c] = i
+static const unsigned char INDICE_ES27[256] = {
+    I('A', 0),  I('B', 1),  I('C', 2),  I('D', 3),  I('E', 4),  I('F', 5),  I('G', 6),
+    I('H', 7),  I('I', 8),  I('J', 9),  I('K', 10), I('L', 11), I('M', 12), I('N', 13),
+    I(NORM_ENYE, ES27_ENYE),
+    I('O', 15), I('P', 16), I('Q', 17), I('R', 18), I('S', 19), I('T', 20), I('U', 21),
+    I('V', 22), I('W', 23), I('X', 24), I('Y', 25), I('Z', 26),
+};
+#undef I
+
+/* ES27: índice -> letra (la Ñ se escribe aparte, en dos bytes) */
+static const char LETRA_ES27[27] = "ABCDEFGHIJKLMN\0OPQRSTUVWXYZ";
+
+const Alfabeto *alfabeto_por_nombre(const char *nombre) {
+    for (int i = 0; i < N_ALFABETOS; ++i)
+        if (strcasecmp(nombre, ALFABETOS[i].nombre) == 0) return &ALFABETOS[i];
+    return NULL;
+}
+
+const Alfabeto *alfabeto_por_m(int m) {
+    for (int i = 0; i < N_ALFABETOS; ++i)
+        if (ALFABETOS[i].m == m) return &ALFABETOS[i];
+    return NULL;
+}
+
+void alf_lector_init(AlfLector *lr, const Alfabeto *alf) {
+    lr->alf = alf;
+    normalizador_init(&lr->nz, alf->id == ALF_ES27 ? NORM_ES27 : NORM_ES);
+}
+
+/* ---------- Núcleos de lectura / escritura (uno por alfabeto) ---------- */
+
+static size_t leer_latin26(AlfLector *lr, const unsigned char *in, size_t n, unsigned char *idx) {
+    size_t k = normalizar_bloque(&lr->nz, in, n, (char *)idx);
+    for (size_t i = 0; i < k; ++i) idx[i] -= 'A';
+    return k;
+}
+
+static size_t leer_es27(AlfLector *lr, const unsigned char *in, size_t n, unsigned char *idx) {
+    size_t k = normalizar_bloque(&lr->nz, in, n, (char *)idx);
+    for (size_t i = 0; i < k; ++i) idx[i] = INDICE_ES27[idx[i]];
+    return k;
+}
+
+static size_t escribir_latin26(const unsigned char *idx, size_t n, char *out) {
+    for (size_t i = 0; i < n; ++i) out[i] = (char)('A' + idx[i]);
+    return n;
+}
+
+static size_t escribir_es27(const unsigned char *idx, size_t n, char *out) {
+    size_t o = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (idx[i] == ES27_ENYE) {
+            out[o++] = (char)0xC3; // Ñ en UTF-8
+            out[o++] = (char)0x91;
+        } else {
+            out[o++] = LETRA_ES27[idx[i]];
+        }
+    }
+    return o;
+}
+
+size_t alf_leer(AlfLector *lr, const unsigned char *in, size_t n, unsigned char *idx) {
+    switch (lr->alf->id) {
+    case ALF_LATIN26: return leer_latin26(lr, in, n, idx);
+    case ALF_ES27:    return leer_es27(lr, in, n, idx);
+    default:          memcpy(idx, in, n); return n;
+    }
+}
+
+size_t alf_leer_fin(AlfLector *lr, unsigned char *idx) {
+    if (lr->alf->id != ALF_ES27) return 0;
+    size_t k = normalizar_fin(&lr->nz, (char *)idx);
+    for (size_t i = 0; i < k; ++i) idx[i] = INDICE_ES27[idx[i]];
+    return k;
+}
+
+size_t alf_escribir(const Alfabeto *alf, const unsigned char *idx, size_t n, char *out) {
+    switch (alf->id) {
+    case ALF_LATIN26: return escribir_latin26(idx, n, out);
+    case ALF_ES27:    return escribir_es27(idx, n, out);
+    default:          memcpy(out, idx, n); return n;
+    }
+}
+
+size_t alf_indices_clave(const Alfabeto *alf, const char *clave, unsigned char *idx) {
+    AlfLector lr;
+    alf_lector_init(&lr, alf);
+    size_t k = alf_leer(&lr, (const unsigned char *)clave, strlen(clave), idx);
+    return k + alf_leer_fin(&lr, idx + k);
+}
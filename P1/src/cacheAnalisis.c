@@ -0,0 +1,257 @@
+#include "cacheAnalisis.h"
+#include "criptoAnalisisVigenere.h"
+#include "histograma.h"
+#include "normalizar.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CACHE_BLOQUE 65536 // bytes del original normalizados de cada vez
+#define ALINEAR(x) (((x) + 63) & ~(uint64_t)63)
+
+#define H1 0x9E3779B185EBCA87ULL
+#define H2 0xC2B2AE3D27D4EB4FULL
+#define H3 0x165667B19E3779F9ULL
+#define H4 0x85EBCA77C2B2AE63ULL
+
+static inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+static inline uint64_t ronda(uint64_t acc, uint64_t w) {
+    return rotl64(acc + w * H2, 31) * H1;
+}
+
+static inline uint64_t leer64(const unsigned char *p) {
+    uint64_t w;
+    memcpy(&w, p, 8);
+    return w;
+}
+
+uint64_t cache_hash(const void *datos, size_t n) {
+    const unsigned char *p = datos, *fin = p + n;
+    uint64_t h;
+
+    // Cuatro carriles independientes de 8 bytes para no encadenar multiplicaciones
+    if (n >= 32) {
+        uint64_t v1 = H1 + H2, v2 = H2, v3 = 0, v4 = -H1;
+        for (; p + 32 <= fin; p += 32) {
+            v1 = ronda(v1, leer64(p));
+            v2 = ronda(v2, leer64(p + 8));
+            v3 = ronda(v3, leer64(p + 16));
+            v4 = ronda(v4, leer64(p + 24));
+        }
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = (h ^ ronda(0, v1)) * H1 + H4;
+        h = (h ^ ronda(0, v2)) * H1 + H4;
+        h = (h ^ ronda(0, v3)) * H1 + H4;
+        h = (h ^ ronda(0, v4)) * H1 + H4;
+    } else {
+        h = H3;
+    }
+    h += (uint64_t)n;
+
+    // Cola
+    for (; p + 8 <= fin; p += 8) h = rotl64(h ^ ronda(0, leer64(p)), 27) * H1 + H4;
+    for (; p < fin; ++p) h = rotl64(h ^ (*p * H3), 11) * H1;
+
+    // Mezcla final
+    h ^= h >> 33; h *= H2;
+    h ^= h >> 29; h *= H3;
+    h ^= h >> 32;
+    return h;
+}
+
+// Sección [off, off + n) dentro del fichero y alineada para su tipo
+static int seccion_ok(uint64_t off, uint64_t n, uint64_t alin, size_t tam) {
+    return off % alin == 0 && off <= tam && n <= tam - off;
+}
+
+// Las cubetas deben ser crecientes y acabar en npos para no salirse de pos
+static int cubetas_ok(const uint32_t *ini, uint64_t npos) {
+    for (int i = 0; i < KASISKI_CUBETAS; ++i)
+        if (ini[i] > ini[i + 1]) return 0;
+    return ini[0] == 0 && ini[KASISKI_CUBETAS] == npos;
+}
+
+// Proyecta una caché existente y comprueba que corresponde al original y que
+// todas sus secciones caben en el fichero (uno truncado o corrupto se rehace)
+static CacheAnalisis *cache_proyectar(const char *ruta, uint64_t hash, uint64_t bytes) {
+    int fd = open(ruta, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(CacheCab)) { close(fd); return NULL; }
+    size_t tam = (size_t)st.st_size;
+    void *map = mmap(NULL, tam, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    const CacheCab *cab = map;
+    uint64_t npos = cab->kas_letras >= 3 ? cab->kas_letras - 2 : 0;
+    if (memcmp(cab->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || cab->version != CACHE_VERSION ||
+        cab->max_n != CACHE_MAX_N || cab->hash != hash || cab->bytes != bytes ||
+        cab->kas_letras > cab->letras || cab->kas_letras > INT_MAX ||
+        !seccion_ok(cab->off_texto, cab->letras, 1, tam) ||
+        !seccion_ok(cab->off_hist, HIST_N_OFF(CACHE_MAX_N + 1) * sizeof(uint64_t), sizeof(uint64_t), tam) ||
+        !seccion_ok(cab->off_ini, (KASISKI_CUBETAS + 1) * sizeof(uint32_t), sizeof(uint32_t), tam) ||
+        !seccion_ok(cab->off_pos, npos * sizeof(uint32_t), sizeof(uint32_t), tam) ||
+        !cubetas_ok((const uint32_t *)((const char *)map + cab->off_ini), npos)) {
+        munmap(map, tam);
+        return NULL;
+    }
+
+    CacheAnalisis *c = calloc(1, sizeof(CacheAnalisis));
+    if (!c) { munmap(map, tam); return NULL; }
+    c->map = map;
+    c->tam = tam;
+    c->cab = cab;
+    c->texto = (const char *)map + cab->off_texto;
+    c->hist = (const uint64_t *)((const char *)map + cab->off_hist);
+    c->ini = (const uint32_t *)((const char *)map + cab->off_ini);
+    c->pos = (const uint32_t *)((const char *)map + cab->off_pos);
+    return c;
+}
+
+static int escribir_relleno(FILE *f, uint64_t *off) {
+    static const char ceros[64];
+    size_t r = (size_t)(ALINEAR(*off) - *off);
+    *off += r;
+    return fwrite(ceros, 1, r, f) == r ? 0 : -1;
+}
+
+// Construye la caché en ruta_tmp a partir del original ya proyectado
+static int cache_construir(const char *ruta_tmp, const unsigned char *orig, size_t bytes, uint64_t hash) {
+    FILE *f = fopen(ruta_tmp, "w+b");
+    if (!f) return -1;
+
+    CacheCab cab;
+    memset(&cab, 0, sizeof(cab));
+    memcpy(cab.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    cab.version = CACHE_VERSION;
+    cab.max_n = CACHE_MAX_N;
+    cab.hash = hash;
+    cab.bytes = bytes;
+
+    uint64_t off = sizeof(cab);
+    uint64_t *hist = calloc(HIST_N_OFF(CACHE_MAX_N + 1), sizeof(uint64_t));
+    char *letras = malloc(CACHE_BLOQUE);
+    int fase[CACHE_MAX_N + 1] = {0};
+    uint32_t *ini = NULL, *pos = NULL;
+    void *map = MAP_FAILED;
+    int ok = hist && letras && fwrite(&cab, sizeof(cab), 1, f) == 1 && escribir_relleno(f, &off) == 0;
+
+    // 1) Texto compacto e histogramas por columnas, bloque a bloque
+    cab.off_texto = off;
+    Normalizador nz;
+    normalizador_init(&nz, NORM_ASCII);
+    for (size_t i = 0; ok && i < bytes; i += CACHE_BLOQUE) {
+        size_t n = bytes - i < CACHE_BLOQUE ? bytes - i : CACHE_BLOQUE;
+        size_t cnt = normalizar_bloque(&nz, orig + i, n, letras);
+        if (fwrite(letras, 1, cnt, f) != cnt) ok = 0;
+        for (int k = CACHE_MAX_N / 2 + 1; ok && k <= CACHE_MAX_N; ++k) {
+            uint32_t h[CACHE_MAX_N][26];
+            uint64_t *dst = hist + HIST_N_OFF(k);
+            hist_columnas(letras, cnt, k, fase[k], h);
+            for (int c = 0; c < k; ++c)
+                for (int j = 0; j < 26; ++j) dst[c * 26 + j] += h[c][j];
+            fase[k] = (int)((fase[k] + cnt) % (size_t)k);
+        }
+        cab.letras += cnt;
+    }
+    off += cab.letras;
+    ok = ok && escribir_relleno(f, &off) == 0;
+
+    // Las columnas de n <= CACHE_MAX_N / 2 salen de juntar las de 2n:
+    // i % n == c  <=>  i % 2n es c o c + n
+    for (int k = CACHE_MAX_N / 2; ok && k >= 1; --k) {
+        uint64_t *dst = hist + HIST_N_OFF(k);
+        const uint64_t *src = hist + HIST_N_OFF(2 * k);
+        for (int c = 0; c < k; ++c)
+            for (int j = 0; j < 26; ++j) dst[c * 26 + j] = src[c * 26 + j] + src[(c + k) * 26 + j];
+    }
+
+    cab.off_hist = off;
+    size_t nhist = HIST_N_OFF(CACHE_MAX_N + 1);
+    ok = ok && fwrite(hist, sizeof(uint64_t), nhist, f) == nhist;
+    off += nhist * sizeof(uint64_t);
+
+    // 2) Cubetas de Kasiski sobre el texto ya escrito (las posiciones son int)
+    cab.kas_letras = cab.letras < INT_MAX ? cab.letras : INT_MAX;
+    uint64_t npos = cab.kas_letras >= 3 ? cab.kas_letras - 2 : 0;
+    cab.off_ini = off;
+    ini = calloc(KASISKI_CUBETAS + 1, sizeof(uint32_t));
+    pos = malloc((npos ? npos : 1) * sizeof(uint32_t));
+    ok = ok && ini && pos && fflush(f) == 0;
+    if (ok && npos) {
+        size_t tam = (size_t)(cab.off_texto + cab.kas_letras);
+        map = mmap(NULL, tam, PROT_READ, MAP_SHARED, fileno(f), 0);
+        if (map == MAP_FAILED) ok = 0;
+        else {
+            kasiski_cubetas((const char *)map + cab.off_texto, (int)cab.kas_letras, ini, pos);
+            munmap(map, tam);
+        }
+    }
+    ok = ok && fwrite(ini, sizeof(uint32_t), KASISKI_CUBETAS + 1, f) == KASISKI_CUBETAS + 1;
+    off += (KASISKI_CUBETAS + 1) * sizeof(uint32_t);
+    ok = ok && escribir_relleno(f, &off) == 0;
+    cab.off_pos = off;
+    ok = ok && fwrite(pos, sizeof(uint32_t), npos, f) == npos;
+
+    // 3) Cabecera definitiva
+    ok = ok && fseek(f, 0, SEEK_SET) == 0 && fwrite(&cab, sizeof(cab), 1, f) == 1;
+    if (fclose(f) != 0) ok = 0;
+    free(hist); free(letras); free(ini); free(pos);
+    return ok ? 0 : -1;
+}
+
+CacheAnalisis *cache_abrir(const char *fichero, const char *dir) {
+    if (!dir) dir = CACHE_DIR;
+    int fd = open(fichero, O_RDONLY);
+    if (fd < 0) { perror("Error abriendo fichero"); return NULL; }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        fprintf(stderr, "Error: la caché necesita un fichero regular\n");
+        close(fd);
+        return NULL;
+    }
+    size_t bytes = (size_t)st.st_size;
+    const unsigned char *orig = NULL;
+    if (bytes) {
+        void *m = mmap(NULL, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED) { perror("mmap"); close(fd); return NULL; }
+        madvise(m, bytes, MADV_SEQUENTIAL);
+        orig = m;
+    }
+    close(fd);
+
+    uint64_t hash = cache_hash(orig, bytes);
+    char ruta[PATH_MAX], tmp[PATH_MAX + 32];
+    snprintf(ruta, sizeof(ruta), "%s/%016llx.cac", dir, (unsigned long long)hash);
+
+    CacheAnalisis *c = cache_proyectar(ruta, hash, bytes);
+    if (c) {
+        c->acierto = 1;
+    } else {
+        // Fallo: se construye en un temporal y se renombra (atómico frente a otros procesos)
+        if (mkdir(dir, 0755) < 0 && errno != EEXIST) perror("mkdir");
+        snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", ruta, (long)getpid());
+        if (cache_construir(tmp, orig, bytes, hash) == 0 && rename(tmp, ruta) == 0)
+            c = cache_proyectar(ruta, hash, bytes);
+        else {
+            perror("Error escribiendo la caché");
+            unlink(tmp);
+        }
+    }
+    if (orig) munmap((void *)orig, bytes);
+    return c;
+}
+
+void cache_cerrar(CacheAnalisis *c) {
+    if (!c) return;
+    munmap(c->map, c->tam);
+    free(c);
+}
@@ -0,0 +1,262 @@
+#include "criptoAnalisisAfin.h"
+#include "afin_modificado.h"
+#include "euclides.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * Ataque con texto claro conocido a afin_modificado.
+ *
+ * Con dos bloques conocidos (x0, y0), (xi, yi):  yi - y0 = a (xi - x0) mod M,
+ * y después b = y0 - a x0. El barrido sin posición conocida prueba cada
+ * bloque cifrado j como imagen del primer bloque del crib; antes de tocar
+ * GMP descarta j con un filtro módulo d, una potencia de un primo de m que
+ * cabe en 32 bits (d divide a M, así que toda solución lo cumple).
+ */
+
+typedef struct {
+    const Alfabeto *alf;
+    mpz_t M;
+    uint64_t d;                 // módulo del filtro rápido
+    unsigned p;                 // primo del que d es potencia
+    const unsigned char *crib;
+    size_t ncrib;
+    const unsigned char *cifrado;
+    size_t nbloques;
+    uint64_t *cmod;             // bloque cifrado j mod d
+    atomic_int siguiente;       // próxima alineación a probar
+    pthread_mutex_t mtx;
+    ClaveAfinMod *claves;
+    int max_claves, n;
+} Kpa;
+
+/* Bloque de índices mod d (Horner) */
+static uint64_t bloque_mod(const unsigned char *x, int m, uint64_t d) {
+    uint64_t v = 0;
+    for (int i = 0; i < BLOCK_SIZE; ++i) v = (v * (uint64_t)m + x[i]) % d;
+    return v;
+}
+
+/* Inverso de v mod d (v coprimo con d) con extended_euclides */
+static uint64_t inverso_mod(uint64_t v, uint64_t d) {
+    mpz_t zv, zd;
+    mpz_init_set_ui(zv, (unsigned long)v);
+    mpz_init_set_ui(zd, (unsigned long)d);
+    ExtendedEuclidesResult ext = extended_euclides(zv, zd);
+    mpz_mod(ext.s, ext.s, zd);
+    uint64_t inv = mpz_get_ui(ext.s);
+    mpz_clears(zv, zd, ext.mcd, ext.s, ext.t, NULL);
+    return inv;
+}
+
+/*
+ * Restringe el conjunto a = a0 (mod s) con la ecuación a*dx = dy (mod M).
+ * s siempre divide a M; cuando llega a M la solución es única.
+ * Devuelve 0 si la ecuación es incompatible.
+ */
+static int restringir(mpz_t a0, mpz_t s, const mpz_t dx, const mpz_t dy, const mpz_t M) {
+    mpz_t c, r, mg;
+    mpz_inits(c, r, mg, NULL);
+    // (a0 + t*s)*dx = dy  ->  t*(dx*s) = dy - a0*dx
+    mpz_mul(c, dx, s);
+    mpz_mod(c, c, M);
+    mpz_mul(r, a0, dx);
+    mpz_sub(r, dy, r);
+    mpz_mod(r, r, M);
+
+    ExtendedEuclidesResult ext = extended_euclides(c, M);
+    int ok = mpz_divisible_p(r, ext.mcd);
+    if (ok) {
+        // t = (r/g) * (c/g)^-1 mod M/g; el coeficiente s de Bézout es ese inverso
+        mpz_divexact(mg, M, ext.mcd);
+        mpz_divexact(r, r, ext.mcd);
+        mpz_mul(r, r, ext.s);
+        mpz_mod(r, r, mg);
+        mpz_addmul(a0, r, s);
+        mpz_mul(s, s, mg);
+        mpz_mod(a0, a0, s);
+    }
+    mpz_clears(c, r, mg, ext.mcd, ext.s, ext.t, NULL);
+    return ok;
+}
+
+static void anotar(Kpa *K, const mpz_t a, const mpz_t b, long offset) {
+    pthread_mutex_lock(&K->mtx);
+    if (K->n < K->max_claves) {
+        ClaveAfinMod *c = &K->claves[K->n++];
+        mpz_init_set(c->a, a);
+        mpz_init_set(c->b, b);
+        c->offset = offset;
+    }
+    pthread_mutex_unlock(&K->mtx);
+}
+
+/* Resuelve con los k bloques del crib (desde la letra q) frente a los
+ * bloques cifrados j..j+k-1 y anota las claves válidas */
+static void resolver(Kpa *K, size_t q, int k, size_t j) {
+    const Alfabeto *alf = K->alf;
+    mpz_t x0, y0, dx, dy, a0, s, cnt, b;
+    mpz_inits(x0, y0, dx, dy, a0, s, cnt, b, NULL);
+    indices_to_mpz(alf, K->crib + q, BLOCK_SIZE, x0);
+    indices_to_mpz(alf, K->cifrado + j * BLOCK_SIZE, BLOCK_SIZE, y0);
+    mpz_set_ui(s, 1);
+
+    // Cada bloque acota a; con a ya fijada (s = M) los demás solo se comprueban
+    int ok = 1;
+    for (int i = 1; i < k && ok; ++i) {
+        indices_to_mpz(alf, K->crib + q + (size_t)i * BLOCK_SIZE, BLOCK_SIZE, dx);
+        indices_to_mpz(alf, K->cifrado + (j + (size_t)i) * BLOCK_SIZE, BLOCK_SIZE, dy);
+        mpz_sub(dx, dx, x0);
+        mpz_sub(dy, dy, y0);
+        if (mpz_cmp(s, K->M) < 0) {
+            ok = restringir(a0, s, dx, dy, K->M);
+        } else {
+            mpz_submul(dy, a0, dx);
+            ok = mpz_divisible_p(dy, K->M);
+        }
+    }
+
+    if (ok) {
+        // Candidatos a = a0 + t*s; solo valen los invertibles (mcd(a, m) = 1)
+        mpz_divexact(cnt, K->M, s);
+        unsigned long n = mpz_cmp_ui(cnt, KPA_MAX_CAND) > 0 ? KPA_MAX_CAND : mpz_get_ui(cnt);
+        if (mpz_cmp_ui(cnt, KPA_MAX_CAND) > 0)
+            gmp_fprintf(stderr, "Aviso: el crib deja %Zd soluciones en el bloque %zu; se prueban %d\n",
+                        cnt, j, KPA_MAX_CAND);
+        for (unsigned long t = 0; t < n; ++t) {
+            if (mpz_gcd_ui(NULL, a0, (unsigned long)alf->m) == 1) {
+                mpz_mul(b, a0, x0);
+                mpz_sub(b, y0, b);
+                mpz_mod(b, b, K->M);
+                anotar(K, a0, b, (long)(j * BLOCK_SIZE) - (long)q);
+            }
+            mpz_add(a0, a0, s);
+        }
+    }
+    mpz_clears(x0, y0, dx, dy, a0, s, cnt, b, NULL);
+}
+
+/* Barrido de una alineación: el crib empieza q letras antes de un bloque */
+static void alineacion(Kpa *K, size_t q) {
+    if (K->ncrib < q) return;
+    int k = (int)((K->ncrib - q) / BLOCK_SIZE);
+    if (k < 3 || K->nbloques < (size_t)k) return;
+
+    uint64_t d = K->d, pm[k];
+    for (int i = 0; i < k; ++i) pm[i] = bloque_mod(K->crib + q + (size_t)i * BLOCK_SIZE, K->alf->m, d);
+
+    // i1: la diferencia con menos factores p (g = mcd con d lo más pequeño);
+    // i2: otra cualquiera para comprobar
+    int i1 = 0, i2 = 0;
+    uint64_t g1 = d;
+    for (int i = 1; i < k; ++i) {
+        uint64_t g = 1, dp = (pm[i] + d - pm[0]) % d;
+        while (g < d && dp % (g * K->p) == 0) g *= K->p;
+        if (g < g1) { g1 = g; i1 = i; }
+    }
+    i2 = (i1 == 1) ? 2 : 1;
+    size_t j0 = (q > 0) ? 1 : 0;
+    size_t jmax = K->nbloques - (size_t)k;
+
+    if (g1 == d) {
+        // Crib degenerado para el filtro: resolución completa en cada posición
+        for (size_t j = j0; j <= jmax; ++j) resolver(K, q, k, j);
+        return;
+    }
+    // a*dp1 = dc1 (mod d)  ->  g1 | dc1  y  a = (dc1/g1) * (dp1/g1)^-1 (mod d/g1)
+    uint64_t dg = d / g1;
+    uint64_t dp1 = (pm[i1] + d - pm[0]) % d / g1;
+    uint64_t dp2 = (pm[i2] + d - pm[0]) % dg;
+    uint64_t inv1 = inverso_mod(dp1 % dg, dg);
+    const uint64_t *c = K->cmod;
+    for (size_t j = j0; j <= jmax; ++j) {
+        uint64_t dc1 = (c[j + i1] + d - c[j]) % d;
+        if (dc1 % g1) continue;
+        uint64_t a = dc1 / g1 % dg * inv1 % dg;
+        uint64_t dc2 = (c[j + i2] + d - c[j]) % dg;
+        if (a * dp2 % dg != dc2) continue;
+        resolver(K, q, k, j);
+    }
+}
+
+static void *hilo_kpa(void *arg) {
+    Kpa *K = arg;
+    int q;
+    while ((q = atomic_fetch_add(&K->siguiente, 1)) < BLOCK_SIZE) alineacion(K, (size_t)q);
+    return NULL;
+}
+
+static int por_offset(const void *x, const void *y) {
+    long a = ((const ClaveAfinMod *)x)->offset, b = ((const ClaveAfinMod *)y)->offset;
+    return (a > b) - (a < b);
+}
+
+int afin_mod_kpa(const Alfabeto *alf, const unsigned char *crib, size_t ncrib, long offset,
+                 const unsigned char *cifrado, size_t ncifrado, int hilos,
+                 ClaveAfinMod *claves, int max_claves) {
+    Kpa K;
+    K.alf = alf;
+    K.crib = crib;
+    K.ncrib = ncrib;
+    K.cifrado = cifrado;
+    K.nbloques = ncifrado / BLOCK_SIZE;
+    K.claves = claves;
+    K.max_claves = max_claves;
+    K.n = 0;
+    mpz_init(K.M);
+    compute_modulus_alf(alf, BLOCK_SIZE, K.M);
+    pthread_mutex_init(&K.mtx, NULL);
+
+    int ret = -1;
+    if (offset >= 0) {
+        // Posición conocida: basta con dos bloques completos
+        size_t q = (size_t)((BLOCK_SIZE - offset % BLOCK_SIZE) % BLOCK_SIZE);
+        size_t j = ((size_t)offset + q) / BLOCK_SIZE;
+        int k = ncrib > q ? (int)((ncrib - q) / BLOCK_SIZE) : 0;
+        if (k >= 2) {
+            if (j + (size_t)k <= K.nbloques) resolver(&K, q, k, j);
+            ret = K.n;
+        }
+    } else if (ncrib >= 4 * BLOCK_SIZE - 1) {
+        // Filtro: d = p^e < 2^32 con p el mayor primo de m
+        unsigned p = 2, m = (unsigned)alf->m;
+        for (unsigned f = 2; f <= m; ++f)
+            if (m % f == 0) { p = f; while (m % f == 0) m /= f; }
+        K.p = p;
+        K.d = 1;
+        while (K.d * p < (1ULL << 32)) K.d *= p;
+
+        K.cmod = malloc((K.nbloques + 1) * sizeof(uint64_t));
+        if (K.cmod) {
+            for (size_t j = 0; j < K.nbloques; ++j)
+                K.cmod[j] = bloque_mod(cifrado + j * BLOCK_SIZE, alf->m, K.d);
+
+            if (hilos <= 0) hilos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+            if (hilos < 1) hilos = 1;
+            if (hilos > BLOCK_SIZE) hilos = BLOCK_SIZE;
+            atomic_init(&K.siguiente, 0);
+            pthread_t th[BLOCK_SIZE];
+            int lanzados = 0;
+            for (; lanzados < hilos - 1; ++lanzados)
+                if (pthread_create(&th[lanzados], NULL, hilo_kpa, &K) != 0) break;
+            hilo_kpa(&K); // este hilo también trabaja (y termina solo si no arrancó ninguno)
+            for (int t = 0; t < lanzados; ++t) pthread_join(th[t], NULL);
+            free(K.cmod);
+            qsort(claves, (size_t)K.n, sizeof(ClaveAfinMod), por_offset);
+            ret = K.n;
+        }
+    }
+
+    pthread_mutex_destroy(&K.mtx);
+    mpz_clear(K.M);
+    return ret;
+}
+
+void clave_afin_mod_clear(ClaveAfinMod *c) {
+    mpz_clears(c->a, c->b, NULL);
+}
@@ -1,17 +1,53 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
+#include <math.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "criptoAnalisisVigenere.h"
+#include "normalizar.h"
+#include "instr.h"
+#include "histograma.h"
+#include "vigenere.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
-#define MAX_TEXT 1000000
 #define ALPHABET 26
+#define STREAM_CHUNK 65536 // bytes por lectura
 
-#define MAX_K_CAND 30 // Número máximo de candidatos a longitud de clave (2..40)
-#define MIN_DIST 20   // Distancia mínima entre repeticiones a considerar
+#define MIN_DIST KASISKI_MIN_DIST // Distancia mínima entre repeticiones a considerar
 #define NGRAM 3       // Tamaño del n-grama
 #define A 'A'         // Valor ASCII base para las letras mayúsculas
 
+// Añade a buffer las letras de un bloque de bytes; devuelve 1 al llenarse
+static int cargar_bloque(Normalizador *nz, const unsigned char *raw, size_t got, char *buffer, int *len)
+{
+    char letras[STREAM_CHUNK];
+    INSTR_SUMAR(INSTR_BYTES_LEIDOS, got);
+    INSTR_INICIO(t_norm);
+    size_t n = normalizar_bloque(nz, raw, got, letras);
+    INSTR_FIN(ETAPA_NORMALIZAR, t_norm, n);
+    if (n > (size_t)(MAX_TEXT - 1 - *len))
+    {
+        n = (size_t)(MAX_TEXT - 1 - *len);
+        fprintf(stderr, "Aviso: texto truncado a %d letras\n", MAX_TEXT - 1);
+    }
+    memcpy(buffer + *len, letras, n);
+    *len += (int)n;
+    return *len == MAX_TEXT - 1;
+}
+
 // Función para limpiar el texto (solo A-Z)
+// vigenere solo cifra (y solo avanza la clave en) letras ASCII: las letras
+// acentuadas pasan sin cifrar, así que aquí se normaliza en modo NORM_ASCII.
+// El texto se trunca a MAX_TEXT - 1 letras.
 int load_text(const char *filename, char *buffer)
 {
     FILE *f = fopen(filename, "r");
@@ -20,17 +56,58 @@ int load_text(const char *filename, char *buffer)
         perror("Error abriendo fichero");
         exit(EXIT_FAILURE);
     }
-    int len = 0, c;
-    while ((c = fgetc(f)) != EOF)
+    Normalizador nz;
+    normalizador_init(&nz, NORM_ASCII);
+    unsigned char raw[STREAM_CHUNK];
+    size_t got;
+    int len = 0;
+    while ((got = fread(raw, 1, sizeof(raw), f)) > 0)
+        if (cargar_bloque(&nz, raw, got, buffer, &len))
+            break;
+    buffer[len] = '\0';
+    fclose(f);
+    return len;
+}
+
+// Lo mismo desde un fichero ya proyectado en memoria
+int load_text_mem(const unsigned char *p, size_t n, char *buffer)
+{
+    Normalizador nz;
+    normalizador_init(&nz, NORM_ASCII);
+    int len = 0;
+    for (size_t off = 0; off < n; off += STREAM_CHUNK)
     {
-        if (isalpha(c))
-            buffer[len++] = toupper(c);
+        size_t got = n - off < STREAM_CHUNK ? n - off : STREAM_CHUNK;
+        if (cargar_bloque(&nz, p + off, got, buffer, &len))
+            break;
     }
     buffer[len] = '\0';
-    fclose(f);
     return len;
 }
 
+// Descifra el original con la clave recuperada en una sola pasada: la fase
+// solo avanza con las letras y el resto (signos, saltos de línea) se copia
+// tal cual, como con vigenere -D
+int vigenere_descifrar_original(const unsigned char *p, size_t n, const char *key, FILE *out)
+{
+    VigenereCtx ctx;
+    if (vigenere_ctx_init(&ctx, key, 0) < 0)
+        return -1;
+    char buf[STREAM_CHUNK];
+    int ok = 1;
+    for (size_t off = 0; ok && off < n; off += STREAM_CHUNK)
+    {
+        size_t got = n - off < STREAM_CHUNK ? n - off : STREAM_CHUNK;
+        memcpy(buf, p + off, got);
+        vigenere_ctx_aplicar(&ctx, buf, got);
+        INSTR_INICIO(t_esc);
+        ok = fwrite(buf, 1, got, out) == got;
+        INSTR_FIN(ETAPA_ESCRITURA, t_esc, 0);
+    }
+    vigenere_ctx_free(&ctx);
+    return ok ? 0 : -1;
+}
+
 // --------------------------------------------------------
 // Función para calcular el Máximo Común Divisor (MCD)
 int mcd(int a, int b)
@@ -58,100 +135,163 @@ static inline int encN(const char *s, int n)
 }
 
 // --------------------------------------------------------
-// Estructura para almacenar un n-grama codificado y su posición en el texto
-typedef struct
+// Tabla de cubetas de los trigramas: ordenación por recuento (en vez de qsort)
+// que deja las posiciones de cada trigrama contiguas y en orden creciente.
+// ini tiene KASISKI_CUBETAS + 1 entradas y pos len - (NGRAM - 1).
+void kasiski_cubetas(const char *text, int len, uint32_t *ini, uint32_t *pos)
 {
-    int key; // valor entero del n-grama
-    int pos; // posición donde aparece en el texto
-} Ngram;
+    int total = len - (NGRAM - 1); // Total de n-gramas posibles
+    memset(ini, 0, (KASISKI_CUBETAS + 1) * sizeof(uint32_t));
 
-// Función de comparación para qsort (ordena por clave y posición)
-static int cmp_ngram(const void *a, const void *b)
-{
-    const Ngram *x = (const Ngram *)a, *y = (const Ngram *)b;
-    if (x->key != y->key)
-        return (x->key < y->key) ? -1 : 1; // Ordena por clave
-    return x->pos - y->pos;                // Si clave igual, por posición
+    // Cuenta cuántas veces aparece cada trigrama
+    for (int i = 0; i < total; i++)
+        ini[encN(text + i, NGRAM) + 1]++;
+
+    // Suma prefija: ini[c] = primera casilla de la cubeta c
+    for (int c = 0; c < KASISKI_CUBETAS; c++)
+        ini[c + 1] += ini[c];
+
+    // Reparte las posiciones (en orden, así cada cubeta queda ordenada)
+    uint32_t *sig = malloc(KASISKI_CUBETAS * sizeof(uint32_t));
+    if (!sig)
+    {
+        fprintf(stderr, "Error: sin memoria.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(sig, ini, KASISKI_CUBETAS * sizeof(uint32_t));
+    for (int i = 0; i < total; i++)
+        pos[sig[encN(text + i, NGRAM)]++] = (uint32_t)i;
+    free(sig);
 }
 
 // --------------------------------------------------------
 // Función principal del Test de Kasiski
-void kasiski(const char *text, int len)
+int kasiski(const char *text, int len)
 {
-    printf("=== Test de Kasiski ===\n");
+    INSTR_INICIO(t_kas);
+    uint32_t *ini = NULL, *pos = NULL;
 
-    // Verifica que el texto sea lo suficientemente largo
-    if (len < NGRAM + 3)
+    if (len >= NGRAM + 3)
     {
-        printf("Texto demasiado corto para analizar.\n");
-        return;
+        // Crea la tabla de cubetas para todo el texto
+        ini = malloc((KASISKI_CUBETAS + 1) * sizeof(uint32_t));
+        pos = malloc((size_t)(len - (NGRAM - 1)) * sizeof(uint32_t));
+        if (!ini || !pos)
+        {
+            fprintf(stderr, "Error: sin memoria.\n");
+            free(ini);
+            free(pos);
+            return 0;
+        }
+        kasiski_cubetas(text, len, ini, pos);
     }
+    int best_k = kasiski_tabla(text, len, ini, pos);
+
+    // Libera memoria usada
+    INSTR_FIN(ETAPA_KASISKI, t_kas, len);
+    free(ini);
+    free(pos);
+    return best_k;
+}
 
-    // Crea un array de n-gramas para todo el texto
-    int total = len - (NGRAM - 1);              // Total de n-gramas posibles
-    Ngram *arr = malloc(total * sizeof(Ngram)); // Reserva memoria dinámica
-    if (!arr)
+// Tamaño y MCD de las distancias útiles de cada grupo de trigramas
+static void kasiski_grupos(int len, const uint32_t *ini, const uint32_t *pos, uint64_t *cuenta, uint64_t *mcds)
+{
+    // Recorre las cubetas (cada una es un grupo de n-gramas iguales)
+    for (int c = 0; c < KASISKI_CUBETAS; c++)
     {
-        fprintf(stderr, "Error: sin memoria.\n");
-        return;
+        int i = (int)ini[c], j = (int)ini[c + 1];
+        int g = 0; // MCD acumulado del grupo
+
+        // Calcula distancias entre la primera aparición y todas las siguientes del mismo n-grama
+        for (int t = i + 1; t < j; t++)
+        {
+            int d = (int)pos[t] - (int)pos[i]; // distancia desde la primera aparición
+
+            // Filtro para descartar distancias irrelevantes o demasiado grandes
+            if (d < MIN_DIST || d >= len / 2)
+                continue;
+
+            // Calcula el MCD acumulado del grupo
+            g = (g == 0) ? d : mcd(g, d);
+        }
+        cuenta[c] = (uint64_t)(j - i);
+        mcds[c] = (uint64_t)g;
     }
+}
 
-    // Llena el array con los n-gramas codificados y sus posiciones
-    for (int i = 0; i < total; i++)
+// Test de Kasiski sobre una tabla de cubetas ya construida
+int kasiski_tabla(const char *text, int len, const uint32_t *ini, const uint32_t *pos)
+{
+    if (len < NGRAM + 3)
+        return kasiski_informe((uint64_t)(len > 0 ? len : 0), NULL, NULL);
+
+    uint64_t *cuenta = malloc(KASISKI_CUBETAS * sizeof(uint64_t));
+    uint64_t *mcds = malloc(KASISKI_CUBETAS * sizeof(uint64_t));
+    if (!cuenta || !mcds)
     {
-        arr[i].key = encN(text + i, NGRAM);
-        arr[i].pos = i;
+        fprintf(stderr, "Error: sin memoria.\n");
+        free(cuenta);
+        free(mcds);
+        return 0;
     }
+    kasiski_grupos(len, ini, pos, cuenta, mcds);
+    (void)text; // el trigrama de cada cubeta sale de su número
 
-    // Ordena el array por clave (así las repeticiones quedan contiguas)
-    qsort(arr, total, sizeof(Ngram), cmp_ngram);
-
-    // Inicializa el histograma de votos (posibles longitudes de clave)
-    int votes[MAX_K_CAND + 1] = {0};
+    int best_k = kasiski_informe((uint64_t)len, cuenta, mcds);
+    free(cuenta);
+    free(mcds);
+    return best_k;
+}
 
-    // Recorre los grupos de n-gramas iguales para calcular distancias
-    int i = 0;
-    while (i < total)
-    {
-        int j = i + 1;
-        while (j < total && arr[j].key == arr[i].key)
-            j++; // Agrupa repeticiones
+// Votos por longitud: cada grupo repetido vota por el MCD de sus distancias
+// (solo MCDs razonables, entre 2 y 20)
+static void kasiski_votos(const uint64_t *cuenta, const uint64_t *mcds, int votes[MAX_K_CAND + 1])
+{
+    memset(votes, 0, (MAX_K_CAND + 1) * sizeof(int));
+    for (int c = 0; c < KASISKI_CUBETAS; c++)
+        if (cuenta[c] >= 2 && mcds[c] >= 2 && mcds[c] <= 20)
+            votes[mcds[c]]++;
+}
 
-        int group_sz = j - i; // Tamaño del grupo (veces que se repite el n-grama)
-        if (group_sz >= 2)
-        {              // Solo interesa si se repite más de una vez
-            int g = 0; // MCD acumulado del grupo
+// Votos y estimación a partir del tamaño y el MCD de cada grupo de trigramas
+int kasiski_informe(uint64_t len, const uint64_t *cuenta, const uint64_t *mcds)
+{
+    return kasiski_informe_votos(len, cuenta, mcds, NULL);
+}
 
-            // Calcula distancias entre la primera aparición y todas las siguientes del mismo n-grama
-            int base_pos = arr[i].pos; // posición de la primera aparición
+int kasiski_informe_votos(uint64_t len, const uint64_t *cuenta, const uint64_t *mcds, const int *votos)
+{
+    printf("=== Test de Kasiski ===\n");
 
-            for (int t = i + 1; t < j; t++)
-            {
-                int d = arr[t].pos - base_pos; // distancia desde la primera aparición
+    // Verifica que el texto sea lo suficientemente largo
+    if (len < NGRAM + 3)
+    {
+        printf("Texto demasiado corto para analizar.\n");
+        return 0;
+    }
 
-                // Filtro para descartar distancias irrelevantes o demasiado grandes
-                if (d < MIN_DIST || d >= len / 2)
-                    continue;
+    // Histograma de votos (posibles longitudes de clave)
+    int votes[MAX_K_CAND + 1];
+    if (votos) memcpy(votes, votos, sizeof(votes));
+    else kasiski_votos(cuenta, mcds, votes);
 
-                // Calcula el MCD acumulado del grupo
-                g = (g == 0) ? d : mcd(g, d);
-            }
+    for (int c = 0; c < KASISKI_CUBETAS; c++)
+    {
+        if (cuenta[c] < 2) // Solo interesa si se repite más de una vez
+            continue;
+        uint64_t g = mcds[c];
 
-            // Filtro adicional: solo sumar votos para MCDs razonables (entre 2 y 20)
-            if (g >= 2 && g <= 20)
-                votes[g]++;
-
-            // Muestra información del grupo si hay un MCD válido
-            if (g > 1)
-            {
-                char s[NGRAM + 1]; // Extrae el n-grama en texto legible
-                for (int t = 0; t < NGRAM; t++)
-                    s[t] = text[arr[i].pos + t];
-                s[NGRAM] = '\0';
-                printf("N-grama %s (repite %d veces) -> MCD grupo: %d\n", s, group_sz, g);
-            }
+        // Muestra información del grupo si hay un MCD válido
+        if (g > 1)
+        {
+            char s[NGRAM + 1]; // Extrae el n-grama en texto legible
+            for (int t = NGRAM - 1, v = c; t >= 0; t--, v /= 26)
+                s[t] = (char)(A + v % 26);
+            s[NGRAM] = '\0';
+            printf("N-grama %s (repite %llu veces) -> MCD grupo: %llu\n", s,
+                   (unsigned long long)cuenta[c], (unsigned long long)g);
         }
-        i = j; // Avanza al siguiente grupo
     }
 
     // Determina la longitud de clave más votada
@@ -174,9 +314,7 @@ void kasiski(const char *text, int len)
         printf("\n>>> Estimación de longitud de la clave: %d (votos = %d)\n", best_k, best_votes);
     else
         printf("\nNo se encontraron repeticiones útiles para deducir la longitud.\n");
-
-    // Libera memoria usada
-    free(arr);
+    return best_k;
 }
 
 // ===== Ajustes robustos para ataque por IC + M(k) =====
@@ -194,12 +332,7 @@ static const double FREQ_EN_PCT[26] = {
     7.60,2.00,0.11,6.12,6.54,9.25,2.71,0.99,1.92,0.19,1.73,0.19
 };
 
-static inline int is_letter26(char c) {
-    // A-Z sin Ñ (tu cifrado solo avanza en estas)
-    return (c >= 'A' && c <= 'Z' && c != 'Ñ');
-}
-
-static double load_language_probs(const char *lang, double P[26]) {
+double load_language_probs(const char *lang, double P[26]) {
     const double *src = (lang && (strcmp(lang,"en")==0 || strcmp(lang,"EN")==0))
                         ? FREQ_EN_PCT : FREQ_ES_PCT; // por defecto ES
     double sum = 0.0, ic = 0.0;
@@ -212,64 +345,143 @@ static double load_language_probs(const char *lang, double P[26]) {
     return ic;
 }
 
-// Recolecta frecuencias de la subcolumna k (0..n-1) para una clave de longitud n,
-// recorriendo TODO el texto pero incrementando el índice de columna SOLO en A-Z (sin Ñ).
-// Devuelve N (longitud de la subcolumna).
-static int column_freq(const char *text, int len, int n, int k, int freq[26]) {
-    memset(freq, 0, 26 * sizeof(int));
-    int col_idx = 0; // avanza solo cuando vemos A-Z (sin Ñ)
-    int N = 0;
-    for (int i = 0; i < len; ++i) {
-        char c = text[i];
-        if (!is_letter26(c)) continue;      // ignoramos Ñ y no-letras (no avanzan clave)
-        if ((col_idx % n) == k) {
-            freq[c - 'A']++;
-            N++;
+// Recolecta frecuencias de la subcolumna k (0..n-1) para una clave de longitud n.
+// El texto es compacto (solo A-Z, como lo deja load_text), así que la columna
+// de text[i] es i % n. Devuelve N (longitud de la subcolumna).
+static int column_freq(const char *text, int len, int n, int k, uint64_t freq[26]) {
+    INSTR_INICIO(t_col);
+    uint32_t h[26];
+    int N = (int)hist_columna(text, (size_t)len, (size_t)k, (size_t)n, h);
+    for (int j = 0; j < 26; ++j) freq[j] = h[j];
+    INSTR_FIN(ETAPA_COLUMNAS, t_col, len);
+    return N;
+}
+
+// Las n subcolumnas de una pasada. Devuelve -1 si no hay memoria
+static int columnas_contar(const char *text, int len, int n, uint64_t (*freq)[26]) {
+    INSTR_INICIO(t_col);
+    uint32_t (*h)[26] = malloc((size_t)n * sizeof(*h));
+    if (!h) return -1;
+    hist_columnas(text, (size_t)len, n, 0, h);
+    for (int k = 0; k < n; ++k)
+        for (int j = 0; j < 26; ++j) freq[k][j] = h[k][j];
+    free(h);
+    INSTR_FIN(ETAPA_COLUMNAS, t_col, len);
+    return 0;
+}
+
+static void columns_freq(const char *text, int len, int n, uint64_t (*freq)[26]) {
+    if (columnas_contar(text, len, n, freq) < 0) { fprintf(stderr, "Error: sin memoria.\n"); exit(EXIT_FAILURE); }
+}
+
+// IC medio de n subcolumnas (las de menos de 2 letras cuentan como 0)
+static double columns_ic(const uint64_t (*f)[26], int n) {
+    double sum_ic = 0.0;
+    for (int k = 0; k < n; ++k) {
+        double N = 0.0, num = 0.0;
+        for (int j = 0; j < 26; ++j) {
+            N += (double)f[k][j];
+            num += (double)f[k][j] * ((double)f[k][j] - 1.0);
         }
-        col_idx++;
+        if (N >= 2.0) sum_ic += num / (N * (N - 1.0));
     }
-    return N;
+    return sum_ic / n;
 }
 
 // IC medio para un n dado usando las subcolumnas "reales" (con la lógica anterior)
 static double ic_for_n(const char *text, int len, int n) {
-    double sum_ic = 0.0;
-    int cols = 0;
-    for (int k = 0; k < n; ++k) {
-        int f[26]; int N = column_freq(text, len, n, k, f);
-        if (N < 2) { cols++; continue; }
-        long long num = 0;
-        for (int j = 0; j < 26; ++j) num += 1LL * f[j] * (f[j] - 1);
-        long long den = 1LL * N * (N - 1);
-        sum_ic += (den ? (double)num / (double)den : 0.0);
-        cols++;
+    uint64_t (*f)[26] = malloc((size_t)n * sizeof(*f));
+    if (!f) { fprintf(stderr, "Error: sin memoria.\n"); exit(EXIT_FAILURE); }
+    columns_freq(text, len, n, f);
+    double ic = columns_ic((const uint64_t (*)[26])f, n);
+    free(f);
+    return ic;
+}
+
+// Regla común para elegir n por IC: gana la menor distancia al IC del idioma y,
+// a menos de IC_EPS, cuenta como empate. Todos los bucles van de n menor a
+// mayor, así que en un empate se queda la n menor
+#define IC_EPS 5e-5
+static inline int ic_mejora(double dist, double best_dist) {
+    return dist + IC_EPS < best_dist;
+}
+
+// Longitud de clave por IC medio en 1..max_k (lo que elige -ic). Devuelve -1 si no hay memoria
+static int longitud_por_ic(const char *text, int len, int max_k, double ic_lang) {
+    uint64_t (*f)[26] = malloc((size_t)max_k * sizeof(*f));
+    if (!f) return -1;
+    int best_n = 1; double best_dist = 1e300;
+    for (int n = 1; n <= max_k; ++n) {
+        if (columnas_contar(text, len, n, f) < 0) { best_n = -1; break; }
+        double dist = fabs(columns_ic((const uint64_t (*)[26])f, n) - ic_lang);
+        if (ic_mejora(dist, best_dist)) { best_dist = dist; best_n = n; }
     }
-    return (cols ? sum_ic / cols : 0.0);
+    free(f);
+    return best_n;
 }
 
 // M(k) = Σ_j P_j * ( f_{j+k} / ℓ )
 // **ℓ es la longitud de ESA subcolumna** (errata corregida: no es ℓ/n).
 // Recordatorio: como C = P + K, la subclave de CIFRADO coincide con el k que MAXIMIZA M(k)
 // cuando comparamos P_j con la distribución del cifrado desplazada +k.
-static int best_shift_M_for_column(const char *text, int len, int n, int kcol, const double P[26]) {
-    int f[26]; int N = column_freq(text, len, n, kcol, f);
-    if (N == 0) return 0;
+// ℓ es común a los 26 desplazamientos, así que basta con la correlación entera
+// Σ_j w_j f_{j+k} (w_j = P_j · 2^16) para ordenarlos.
+static void m_scores(const uint64_t f[26], const double P[26], uint64_t s[26]) {
+    uint32_t w[26];
+    pesos26(P, w);
+    correlacion26(f, w, s);
+}
+
+static int best_shift_M_for_freq(const uint64_t f[26], const double P[26]) {
+    uint64_t s[26];
+    m_scores(f, P, s);
     int best_k = 0;
-    double best_s = -1e300;
-    for (int k = 0; k < 26; ++k) {
-        double s = 0.0;
-        for (int j = 0; j < 26; ++j) {
-            int idx = (j + k) % 26;         // f_{j+k}
-            s += P[j] * ((double)f[idx] / (double)N);  // dividir por ℓ = N  ← errata arreglada
-        }
-        if (s > best_s + 1e-12 || (fabs(s - best_s) <= 1e-12 && k < best_k)) {
-            best_s = s; best_k = k;
-        }
+    for (int k = 1; k < 26; ++k)
+        if (s[k] > s[best_k]) best_k = k;
+    return best_k; // letra de CIFRADO = 'A' + best_k (0 con la columna vacía)
+}
+
+// Periodo mínimo de la clave: el menor divisor d de n con key[i] == key[i % d]
+static int periodo_minimo(const char *key, int n) {
+    for (int d = 1; d <= n/2; ++d) {
+        if (n % d) continue;
+        int ok = 1;
+        for (int i = d; i < n; ++i) if (key[i] != key[i % d]) { ok = 0; break; }
+        if (ok) return d;
     }
-    return best_k; // letra de CIFRADO = 'A' + best_k
+    return n;
 }
 
-void vigenere_ic_attack(const char *text, int len, int max_k, const char *lang, char *out_key) {
+// Reduce la clave a su periodo mínimo si se repite un patrón (p.ej. CLAVECLAVE -> CLAVE)
+// e imprime el resultado. Devuelve la longitud final de la clave.
+static int reducir_periodo(char *key, int n) {
+    int period = periodo_minimo(key, n);
+    if (period < n) {
+        key[period] = '\0';
+        printf(">>> Clave reducida al periodo detectado: %s (periodo %d)\n", key, period);
+    } else {
+        printf(">>> Clave estimada: %s\n", key);
+    }
+    return period;
+}
+
+// Histogramas de las n subcolumnas desde el texto o desde una tabla ya calculada
+typedef void (*ColumnasFn)(const void *ctx, int n, uint64_t (*f)[26]);
+
+typedef struct { const char *text; int len; } ColumnasTexto;
+typedef struct { const uint64_t *hist; } ColumnasTabla;
+
+static void columnas_texto(const void *ctx, int n, uint64_t (*f)[26]) {
+    const ColumnasTexto *c = ctx;
+    columns_freq(c->text, c->len, n, f);
+}
+
+static void columnas_tabla(const void *ctx, int n, uint64_t (*f)[26]) {
+    const ColumnasTabla *c = ctx;
+    memcpy(f, c->hist + HIST_N_OFF(n), (size_t)n * sizeof(*f));
+}
+
+static void ic_attack(ColumnasFn columnas, const void *ctx, int min_k, int max_k, const char *lang, char *out_key) {
     double P[26];
     double ic_lang = load_language_probs(lang, P);
     const double ic_uniform = 1.0 / 26.0;
@@ -279,15 +491,20 @@ void vigenere_ic_attack(const char *text, int len, int max_k, const char *lang,
 
     if (max_k < 1) max_k = 1;
     if (max_k > 60) max_k = 60;
+    if (min_k < 1) min_k = 1;
+    if (min_k > max_k) min_k = max_k;
+    uint64_t (*f)[26] = malloc((size_t)max_k * sizeof(*f));
+    if (!f) { fprintf(stderr, "Error: sin memoria.\n"); exit(EXIT_FAILURE); }
 
     // 1) Estimar n por IC medio (con columnas reales que saltan Ñ y no-letras)
-    int best_n = 1; double best_dist = 1e300; const double EPS = 5e-5;
+    int best_n = min_k; double best_dist = 1e300;
     printf("IC medio por n:\n");
-    for (int n = 1; n <= max_k; ++n) {
-        double avg_ic = ic_for_n(text, len, n);
+    for (int n = min_k; n <= max_k; ++n) {
+        columnas(ctx, n, f);
+        double avg_ic = columns_ic((const uint64_t (*)[26])f, n);
         double dist   = fabs(avg_ic - ic_lang);
         printf("  n=%2d -> ICmedio=%.5f (dist=%.5f)\n", n, avg_ic, dist);
-        if (dist + EPS < best_dist || (fabs(dist - best_dist) <= EPS && n < best_n)) {
+        if (ic_mejora(dist, best_dist)) {
             best_dist = dist; best_n = n;
         }
     }
@@ -295,68 +512,1193 @@ void vigenere_ic_attack(const char *text, int len, int max_k, const char *lang,
     printf("\n>>> Estimación de longitud de clave: n = %d\n", best_n);
 
     // 2) Subclaves con M(k) correcto (divide por ℓ y usa f_{j+k})
+    columnas(ctx, best_n, f);
     for (int i = 0; i < best_n; ++i) {
-        int k = best_shift_M_for_column(text, len, best_n, i, P);
+        int k = best_shift_M_for_freq(f[i], P);
         out_key[i] = (char)('A' + k);  // clave de CIFRADO (tu vigenere.c usa C = P + K)
         printf("  Subclave[%d] = %c (k=%d)\n", i+1, out_key[i], k);
     }
     out_key[best_n] = '\0';
+    free(f);
 
     // 3) Reducir al periodo mínimo si se repite patrón
-    int period = best_n;
-    for (int d = 1; d <= best_n/2; ++d) {
-        if (best_n % d) continue;
-        int ok = 1;
-        for (int i = d; i < best_n; ++i) if (out_key[i] != out_key[i % d]) { ok = 0; break; }
-        if (ok) { period = d; break; }
+    reducir_periodo(out_key, best_n);
+}
+
+void vigenere_ic_attack(const char *text, int len, int max_k, const char *lang, char *out_key) {
+    ColumnasTexto c = { text, len };
+    ic_attack(columnas_texto, &c, 1, max_k, lang, out_key);
+}
+
+void vigenere_ic_attack_rango(const char *text, int len, int min_k, int max_k, const char *lang, char *out_key) {
+    ColumnasTexto c = { text, len };
+    ic_attack(columnas_texto, &c, min_k, max_k, lang, out_key);
+}
+
+void vigenere_ic_attack_hist(const uint64_t *hist, int max_n, int max_k, const char *lang, char *out_key) {
+    ColumnasTabla c = { hist };
+    if (max_k > max_n) max_k = max_n;
+    ic_attack(columnas_tabla, &c, 1, max_k, lang, out_key);
+}
+
+// ===== Ataque por IC contra varios idiomas (modelos binarios) =====
+// Los histogramas por columnas se calculan una vez; para cada idioma se estima
+// la longitud con su IC, las subclaves con sus probabilidades y se puntúa el
+// descifrado (primeras MODELO_PUNTUAR letras) con sus cuadrigramas.
+
+#define MODELO_PUNTUAR 65536
+
+int vigenere_ic_idiomas(const char *text, long long len, const uint64_t *hist, int max_n, int max_k,
+                        const Modelo *mod, char *out_key) {
+    if (max_k < 1) max_k = 1;
+    if (max_k > 60) max_k = 60;
+    uint64_t *tabla = NULL;
+    if (hist) {
+        if (max_k > max_n) max_k = max_n;
+    } else {
+        tabla = malloc(HIST_N_OFF(max_k + 1) * sizeof(uint64_t));
+        if (!tabla) { fprintf(stderr, "Error: sin memoria.\n"); exit(EXIT_FAILURE); }
+        for (int n = 1; n <= max_k; ++n)
+            columns_freq(text, (int)len, n, (uint64_t (*)[26])(tabla + HIST_N_OFF(n)));
+        hist = tabla;
     }
-    if (period < best_n) {
-        out_key[period] = '\0';
-        printf(">>> Clave reducida al periodo detectado: %s (periodo %d)\n", out_key, period);
+    double ic[61];
+    for (int n = 1; n <= max_k; ++n) ic[n] = columns_ic((const uint64_t (*)[26])(hist + HIST_N_OFF(n)), n);
+
+    size_t npunt = len < MODELO_PUNTUAR ? (size_t)len : MODELO_PUNTUAR;
+    char *claro = malloc(npunt + 1);
+    if (!claro) { fprintf(stderr, "Error: sin memoria.\n"); exit(EXIT_FAILURE); }
+
+    printf("=== Ataque Vigenere por IC contra %d idiomas ===\n", mod->n);
+    int mejor = -1;
+    double mejor_s = -1e300;
+    for (int l = 0; l < mod->n; ++l) {
+        const ModeloIdioma *m = &mod->idiomas[l];
+        int best_n = 1; double best_dist = 1e300;
+        for (int n = 1; n <= max_k; ++n) {
+            double dist = fabs(ic[n] - m->ic);
+            if (ic_mejora(dist, best_dist)) {
+                best_dist = dist; best_n = n;
+            }
+        }
+        char key[61];
+        const uint64_t (*f)[26] = (const uint64_t (*)[26])(hist + HIST_N_OFF(best_n));
+        for (int i = 0; i < best_n; ++i) key[i] = (char)('A' + best_shift_M_for_freq(f[i], m->p1));
+        int period = periodo_minimo(key, best_n);
+        key[period] = '\0';
+
+        for (size_t i = 0; i < npunt; ++i)
+            claro[i] = (char)('A' + (text[i] - key[i % period] + 26) % 26);
+        double s = modelo_puntuar(m, claro, npunt);
+        printf("  %-8s n=%2d  clave=%-20s  log p = %.4f por cuadrigrama\n", m->nombre, best_n, key, s);
+        if (s > mejor_s) {
+            mejor_s = s; mejor = l;
+            strcpy(out_key, key);
+        }
+    }
+    if (mejor >= 0)
+        printf("\n>>> Idioma: %s, clave estimada: %s\n", mod->idiomas[mejor].nombre, out_key);
+    free(claro);
+    free(tabla);
+    return mejor;
+}
+
+// ===== Análisis combinado: Kasiski + IC sobre una sola carga =====
+// El texto se carga y compacta una vez y se reparte, solo lectura, entre
+// tareas independientes: la tabla de Kasiski (la más larga, va primero) y,
+// para cada n, los histogramas de sus columnas, su IC medio y sus subclaves.
+// Los hilos toman tareas de un contador atómico, así que el tiempo total se
+// acerca al de la tarea más larga y no a la suma de los dos análisis.
+// Al final se cruzan los dos estimadores: el IC dice qué longitudes dejan
+// columnas con estadística de idioma (la buena y sus múltiplos) y los votos
+// de Kasiski deshacen el empate entre ellas.
+
+#define TODO_EPS 0.02 // puntuaciones a menos de esto cuentan como empate (gana la n menor)
+
+typedef struct {
+    const char *text;
+    int len, max_k;
+    double P[26];
+    atomic_int siguiente; // 0 = Kasiski, t >= 1 = IC para n = max_k + 1 - t
+    int error;
+    uint64_t *cuenta, *mcds; // grupos de Kasiski
+    uint64_t *hist;          // histogramas por columnas (HIST_N_OFF)
+    double ic[61];
+    char claves[61][61];     // subclaves para cada n
+} Todo;
+
+static void todo_kasiski(Todo *T) {
+    if (T->len < NGRAM + 3) return;
+    uint32_t *ini = malloc((KASISKI_CUBETAS + 1) * sizeof(uint32_t));
+    uint32_t *pos = malloc((size_t)(T->len - (NGRAM - 1)) * sizeof(uint32_t));
+    if (ini && pos) {
+        INSTR_INICIO(t_kas);
+        kasiski_cubetas(T->text, T->len, ini, pos);
+        kasiski_grupos(T->len, ini, pos, T->cuenta, T->mcds);
+        INSTR_FIN(ETAPA_KASISKI, t_kas, T->len);
     } else {
-        printf(">>> Clave estimada: %s\n", out_key);
+        T->error = 1;
     }
+    free(ini);
+    free(pos);
 }
 
-int main(int argc, char *argv[])
-{
-    if (argc < 3)
-    {
-        fprintf(stderr, "Uso: %s {-kasiski | -ic N} -i filein\n", argv[0]);
-        return EXIT_FAILURE;
+static void todo_ic(Todo *T, int n) {
+    uint64_t (*f)[26] = (uint64_t (*)[26])(T->hist + HIST_N_OFF(n));
+    columns_freq(T->text, T->len, n, f);
+    T->ic[n] = columns_ic((const uint64_t (*)[26])f, n);
+    for (int i = 0; i < n; ++i) T->claves[n][i] = (char)('A' + best_shift_M_for_freq(f[i], T->P));
+    T->claves[n][n] = '\0';
+}
+
+static void *todo_hilo(void *arg) {
+    Todo *T = arg;
+    int t;
+    while ((t = atomic_fetch_add(&T->siguiente, 1)) <= T->max_k) {
+        if (t == 0) todo_kasiski(T);
+        else todo_ic(T, T->max_k + 1 - t); // las n grandes (más caras) primero
+    }
+    return NULL;
+}
+
+int vigenere_analisis_completo(const char *text, int len, int max_k, const char *lang, int hilos,
+                               char *out_key) {
+    if (max_k < 1) max_k = 1;
+    if (max_k > 60) max_k = 60;
+    if (hilos <= 0) hilos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (hilos < 1) hilos = 1;
+    if (hilos > max_k + 1) hilos = max_k + 1;
+
+    Todo *T = calloc(1, sizeof(Todo));
+    pthread_t *th = calloc((size_t)hilos, sizeof(pthread_t));
+    if (T) {
+        T->cuenta = calloc(KASISKI_CUBETAS, sizeof(uint64_t));
+        T->mcds = calloc(KASISKI_CUBETAS, sizeof(uint64_t));
+        T->hist = malloc(HIST_N_OFF(max_k + 1) * sizeof(uint64_t));
+    }
+    if (!T || !th || !T->cuenta || !T->mcds || !T->hist) {
+        fprintf(stderr, "Error: sin memoria.\n");
+        if (T) { free(T->cuenta); free(T->mcds); free(T->hist); }
+        free(T); free(th);
+        return 0;
+    }
+    T->text = text;
+    T->len = len;
+    T->max_k = max_k;
+    double ic_lang = load_language_probs(lang, T->P);
+    atomic_init(&T->siguiente, 0);
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int lanzados = 0;
+    for (; lanzados < hilos - 1; ++lanzados)
+        if (pthread_create(&th[lanzados], NULL, todo_hilo, T) != 0) break;
+    todo_hilo(T); // este hilo también trabaja (y termina solo si no arrancó ninguno)
+    for (int i = 0; i < lanzados; ++i) pthread_join(th[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    // Informes de cada análisis, como en -kasiski e -ic
+    int best_kas = T->error ? 0 : kasiski_informe((uint64_t)(len > 0 ? len : 0), T->cuenta, T->mcds);
+    printf("\n");
+    char clave_ic[61];
+    vigenere_ic_attack_hist(T->hist, max_k, max_k, lang, clave_ic);
+    int best_ic = (int)strlen(clave_ic);
+
+    // Puntuación conjunta: cercanía del IC al del idioma (0..1) por 1 + la
+    // fracción de votos de Kasiski que se lleva n
+    int votes[MAX_K_CAND + 1] = {0};
+    if (!T->error && len >= NGRAM + 3) kasiski_votos(T->cuenta, T->mcds, votes);
+    int max_votos = 0;
+    for (int n = 2; n <= MAX_K_CAND; ++n)
+        if (votes[n] > max_votos) max_votos = votes[n];
+
+    double punt[61];
+    int orden[61], best_n = 1;
+    const double rango = ic_lang - 1.0 / 26.0;
+    for (int n = 1; n <= max_k; ++n) {
+        double cerca = 1.0 - fabs(T->ic[n] - ic_lang) / rango;
+        if (cerca < 0.0) cerca = 0.0;
+        double kas = (n <= MAX_K_CAND && max_votos > 0) ? (double)votes[n] / max_votos : 0.0;
+        punt[n] = cerca * (1.0 + kas);
+        orden[n - 1] = n;
+        if (punt[n] > punt[best_n] + TODO_EPS) best_n = n;
+    }
+    for (int i = 1; i < max_k; ++i) // por puntuación (inserción: max_k es pequeño)
+        for (int j = i; j > 0 && punt[orden[j]] > punt[orden[j - 1]]; --j) {
+            int t = orden[j]; orden[j] = orden[j - 1]; orden[j - 1] = t;
+        }
+
+    printf("\n=== Decisión combinada (Kasiski + IC) ===\n");
+    printf("  %2s  %6s  %8s  %10s  %s\n", "n", "votos", "ICmedio", "puntuación", "clave");
+    for (int i = 0; i < max_k && i < 5; ++i) {
+        int n = orden[i];
+        printf("  %2d  %6d  %8.5f  %10.3f  %s\n", n, n <= MAX_K_CAND ? votes[n] : 0, T->ic[n], punt[n],
+               T->claves[n]);
+    }
+    if (best_kas == best_n && best_ic == best_n)
+        printf("\n>>> Longitud: %d (Kasiski e IC coinciden)\n", best_n);
+    else
+        printf("\n>>> Longitud: %d (Kasiski: %d, IC: %d)\n", best_n, best_kas, best_ic);
+    strcpy(out_key, T->claves[best_n]);
+    reducir_periodo(out_key, best_n);
+    printf("Tiempo de análisis: %.3f s con %d hilos\n",
+           (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9, lanzados + 1);
+
+    free(T->cuenta);
+    free(T->mcds);
+    free(T->hist);
+    free(T);
+    free(th);
+    return best_n;
+}
+
+// ===== Análisis IC incremental (streaming) con parada temprana =====
+// Lee el cifrado por bloques y mantiene, para cada n candidato, los histogramas
+// de sus n subcolumnas. Cada STREAM_CHECK letras se recalculan el IC medio y las
+// subclaves; en cuanto la longitud y la clave se mantienen iguales durante
+// STREAM_STABLE evaluaciones con un margen >= al pedido, se deja de leer.
+
+#define STREAM_CHECK 2048    // letras entre dos evaluaciones
+#define STREAM_STABLE 3      // evaluaciones estables consecutivas para parar
+
+typedef struct {
+    int max_k;
+    long long letters;                              // letras A-Z procesadas
+    long long bytes;                                // bytes leídos
+    int phase[MAX_K_CAND + 1];                      // columna actual para cada n
+    long long hist[MAX_K_CAND + 1][MAX_K_CAND][26]; // hist[n][columna][letra]
+    char letras[STREAM_CHUNK];                      // letras del bloque en curso
+} StreamIC;
+
+// IC de una subcolumna a partir de su histograma
+static double stream_col_ic(const long long f[26]) {
+    long long N = 0;
+    double num = 0.0;
+    for (int j = 0; j < 26; ++j) {
+        N += f[j];
+        num += (double)f[j] * (double)(f[j] - 1);
+    }
+    if (N < 2) return 0.0;
+    return num / ((double)N * (double)(N - 1));
+}
+
+// M(k) de una subcolumna: devuelve el mejor desplazamiento y guarda en *gap la
+// diferencia entre la mejor y la segunda mejor puntuación.
+static int stream_col_shift(const long long f[26], const double P[26], double *gap) {
+    long long N = 0;
+    for (int j = 0; j < 26; ++j) N += f[j];
+    if (N == 0) { *gap = 0.0; return 0; }
+    int best_k = 0;
+    double best_s = -1e300, second_s = -1e300;
+    for (int k = 0; k < 26; ++k) {
+        double s = 0.0;
+        for (int j = 0; j < 26; ++j) s += P[j] * ((double)f[(j + k) % 26] / (double)N);
+        if (s > best_s + 1e-12) {
+            second_s = best_s; best_s = s; best_k = k;
+        } else if (s > second_s) {
+            second_s = s;
+        }
+    }
+    *gap = best_s - second_s;
+    return best_k;
+}
+
+// Evalúa el estado actual: devuelve la longitud de clave (ya reducida a su
+// periodo mínimo), escribe la clave en key y la confianza normalizada en *conf:
+// el mínimo entre el margen de IC frente a longitudes no relacionadas con el
+// periodo y el margen de M(k) de cada subcolumna.
+static int stream_ic_evaluate(const StreamIC *s, const double P[26], double ic_lang,
+                              char *key, double *conf) {
+    const double scale = ic_lang - 1.0 / 26.0;
+    double dist[MAX_K_CAND + 1];
+    int best_n = 1; double best_dist = 1e300;
+
+    for (int n = 1; n <= s->max_k; ++n) {
+        double sum_ic = 0.0;
+        for (int k = 0; k < n; ++k) sum_ic += stream_col_ic(s->hist[n][k]);
+        dist[n] = fabs(sum_ic / n - ic_lang);
+        if (ic_mejora(dist[n], best_dist)) {
+            best_dist = dist[n]; best_n = n;
+        }
+    }
+
+    double c = 1e300;
+    for (int i = 0; i < best_n; ++i) {
+        double gap;
+        int k = stream_col_shift(s->hist[best_n][i], P, &gap);
+        key[i] = (char)('A' + k);
+        if (gap / scale < c) c = gap / scale;
     }
+    key[best_n] = '\0';
 
-    char *filein = NULL;
+    // Periodo mínimo de la clave (los múltiplos del periodo real también dan buen IC)
+    int period = periodo_minimo(key, best_n);
+    key[period] = '\0';
+
+    // Competidor: la mejor n que no sea múltiplo ni divisor del periodo
+    double comp = 1e300;
+    for (int n = 1; n <= s->max_k; ++n) {
+        if (n % period == 0 || period % n == 0) continue;
+        if (dist[n] < comp) comp = dist[n];
+    }
+    if (comp < 1e299 && (comp - best_dist) / scale < c) c = (comp - best_dist) / scale;
+
+    *conf = c;
+    return period;
+}
+
+// Añade un bloque de bytes al estado; se detiene al llegar a `limit` letras.
+// Devuelve el número de bytes consumidos.
+// Las letras se compactan primero y luego cada n se cuenta de una pasada.
+static size_t stream_ic_feed(StreamIC *s, const char *buf, size_t len, long long limit) {
+    size_t i = 0;
+    while (i < len && s->letters < limit) {
+        size_t cnt = 0;
+        while (i < len && cnt < STREAM_CHUNK && s->letters + (long long)cnt < limit) {
+            unsigned char c = TABLA_ASCII[(unsigned char)buf[i++]];
+            if (c) s->letras[cnt++] = (char)c;
+        }
+        for (int n = 1; n <= s->max_k; ++n) {
+            uint32_t h[MAX_K_CAND][26];
+            hist_columnas(s->letras, cnt, n, s->phase[n], h);
+            for (int k = 0; k < n; ++k)
+                for (int j = 0; j < 26; ++j) s->hist[n][k][j] += h[k][j];
+            s->phase[n] = (int)((s->phase[n] + cnt) % (size_t)n);
+        }
+        s->letters += (long long)cnt;
+    }
+    s->bytes += (long long)i;
+    return i;
+}
+
+void vigenere_ic_stream(FILE *in, int max_k, const char *lang, double margin, char *out_key) {
+    double P[26];
+    double ic_lang = load_language_probs(lang, P);
+
+    printf("=== Ataque Vigenere por IC en streaming (%s) ===\n", (lang && strcmp(lang,"en")==0) ? "EN" : "ES");
+    printf("IC(teorico idioma)=%.5f, margen de confianza=%.2f\n\n", ic_lang, margin);
+
+    if (max_k < 1) max_k = 1;
+    if (max_k > MAX_K_CAND) max_k = MAX_K_CAND;
+
+    StreamIC *s = calloc(1, sizeof(StreamIC));
+    char *buf = malloc(STREAM_CHUNK);
+    if (!s || !buf) {
+        fprintf(stderr, "Error: sin memoria.\n");
+        free(s); free(buf);
+        return;
+    }
+    s->max_k = max_k;
+
+    char prev_key[MAX_K_CAND + 1] = "";
+    int prev_n = 0, stable = 0, stopped = 0, best_n = 1;
+    double conf = 0.0;
+    long long next_check = STREAM_CHECK;
+    size_t got;
+
+    while (!stopped && (got = fread(buf, 1, STREAM_CHUNK, in)) > 0) {
+        size_t off = 0;
+        while (off < got) {
+            off += stream_ic_feed(s, buf + off, got - off, next_check);
+            if (s->letters < next_check) break;
+
+            best_n = stream_ic_evaluate(s, P, ic_lang, out_key, &conf);
+            if (best_n == prev_n && strcmp(out_key, prev_key) == 0 && conf >= margin)
+                stable++;
+            else
+                stable = (conf >= margin) ? 1 : 0;
+            prev_n = best_n;
+            strcpy(prev_key, out_key);
+            printf("  letras=%10lld  n=%2d  clave=%-*s  confianza=%.3f\n",
+                   s->letters, best_n, max_k, out_key, conf);
+
+            if (stable >= STREAM_STABLE) { stopped = 1; break; }
+            next_check += STREAM_CHECK;
+        }
+    }
+
+    // Resultado final con todo lo leído (si el flujo terminó antes de la parada)
+    if (!stopped) {
+        best_n = stream_ic_evaluate(s, P, ic_lang, out_key, &conf);
+        printf("\nFin de la entrada sin estabilizar (confianza=%.3f)\n", conf);
+    } else {
+        printf("\nClave estable tras %d evaluaciones: lectura detenida\n", STREAM_STABLE);
+    }
+    printf("Leídos %lld bytes (%lld letras)\n", s->bytes, s->letters);
+
+    printf("\n>>> Estimación de longitud de clave: n = %d\n", best_n);
+    reducir_periodo(out_key, best_n);
+
+    free(buf);
+    free(s);
+}
+
+// ===== Estimación rápida por muestreo (ficheros enormes) =====
+// En lugar de recorrer el fichero entero se leen con pread() unas pocas ventanas
+// contiguas repartidas por todo el fichero. Sobre ellas se calcula la estimación
+// de Friedman (forma cerrada) y después el IC de ic_for_n, ventana a ventana.
+// Para las subclaves hace falta que las columnas de todas las ventanas estén en
+// fase: la ventana 0 empieza en el byte 0 (fase conocida) y la fase de las demás
+// se recupera por correlación de sus histogramas de columna con los de la
+// ventana 0, sin leer los huecos entre ventanas.
+
+typedef struct {
+    char *text; // letras A-Z compactadas
+    int len;
+} SampleWindow;
+
+// Lee la ventana [off, off+size) y se queda solo con las letras (como load_text)
+static int sample_read_window(int fd, off_t off, size_t size, SampleWindow *w) {
+    unsigned char *raw = malloc(size);
+    w->text = malloc(size + 1);
+    w->len = 0;
+    if (!raw || !w->text) { free(raw); return -1; }
+
+    size_t got = 0;
+    while (got < size) {
+        ssize_t r = pread(fd, raw + got, size - got, off + (off_t)got);
+        if (r < 0) { free(raw); return -1; }
+        if (r == 0) break;
+        got += (size_t)r;
+    }
+    Normalizador nz;
+    normalizador_init(&nz, NORM_ASCII);
+    w->len = (int)normalizar_bloque(&nz, raw, got, w->text);
+    w->text[w->len] = '\0';
+    free(raw);
+    return 0;
+}
+
+// Desplazamiento r de columnas de la ventana w respecto a la ventana 0:
+// la columna k de la ventana 0 corresponde a la columna (k + r) % n de w.
+static int sample_align(const uint64_t h0[][26], const uint64_t hw[][26], int n) {
+    int best_r = 0;
+    long long best = -1;
+    for (int r = 0; r < n; ++r) {
+        long long s = 0;
+        for (int k = 0; k < n; ++k)
+            for (int j = 0; j < 26; ++j)
+                s += (long long)(h0[k][j] * hw[(k + r) % n][j]);
+        if (s > best) { best = s; best_r = r; }
+    }
+    return best_r;
+}
+
+// Análisis completo (sin parada temprana) reutilizando el acumulador de streaming.
+// Devuelve la longitud de clave y deja la clave en key.
+static int full_ic_pass(FILE *in, int max_k, const double P[26], double ic_lang, char *key) {
+    StreamIC *s = calloc(1, sizeof(StreamIC));
+    char *buf = malloc(STREAM_CHUNK);
     int n = 0;
-    int mode = 0; // 1=kasiski, 2=ic
+    if (s && buf) {
+        double conf;
+        size_t got;
+        s->max_k = max_k;
+        while ((got = fread(buf, 1, STREAM_CHUNK, in)) > 0)
+            stream_ic_feed(s, buf, got, LLONG_MAX);
+        n = stream_ic_evaluate(s, P, ic_lang, key, &conf);
+    }
+    free(buf);
+    free(s);
+    return n;
+}
 
-    for (int i = 1; i < argc; i++)
-    {
-        if (strcmp(argv[i], "-kasiski") == 0)
-            mode = 1;
-        else if (strcmp(argv[i], "-ic") == 0 && i + 1 < argc)
-        {
-            mode = 2;
+void vigenere_sample_attack(const char *filename, int windows, size_t win_bytes, int max_k,
+                            const char *lang, int verify, char *out_key) {
+    double P[26];
+    double ic_lang = load_language_probs(lang, P);
+    const double ic_rand = 1.0 / 26.0;
+
+    if (max_k < 1) max_k = 1;
+    if (max_k > MAX_K_CAND) max_k = MAX_K_CAND;
+    if (windows < 1) windows = 1;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) { perror("Error abriendo fichero"); exit(EXIT_FAILURE); }
+    struct stat st;
+    if (fstat(fd, &st) < 0) { perror("fstat"); close(fd); exit(EXIT_FAILURE); }
+    size_t size = (size_t)st.st_size;
+
+    // Fichero pequeño: una sola ventana que lo cubre entero
+    if (size <= (size_t)windows * win_bytes) { windows = 1; win_bytes = size; }
+
+    printf("=== Estimación por muestreo (%s) ===\n", (lang && strcmp(lang,"en")==0) ? "EN" : "ES");
+    printf("Fichero de %zu bytes: %d ventanas de %zu bytes\n\n", size, windows, win_bytes);
+
+    SampleWindow *win = calloc(windows, sizeof(SampleWindow));
+    if (!win) { fprintf(stderr, "Error: sin memoria.\n"); close(fd); return; }
+    for (int w = 0; w < windows; ++w) {
+        off_t off = (windows == 1) ? 0 : (off_t)((size - win_bytes) / (windows - 1) * w);
+        if (sample_read_window(fd, off, win_bytes, &win[w]) < 0) {
+            perror("pread");
+            for (int v = 0; v <= w; ++v) free(win[v].text);
+            free(win); close(fd);
+            return;
         }
-        else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
-            filein = argv[++i];
     }
+    close(fd);
 
-    if (!filein || mode == 0)
-    {
-        fprintf(stderr, "Parámetros incorrectos. Uso: %s {-kasiski | -ic N} -i filein\n", argv[0]);
-        return EXIT_FAILURE;
+    // 1) Friedman: IC global de la muestra y estimación cerrada de la longitud
+    long long total = 0;
+    double num = 0.0, den = 0.0;
+    for (int w = 0; w < windows; ++w) {
+        uint64_t f[26]; int N = column_freq(win[w].text, win[w].len, 1, 0, f);
+        for (int j = 0; j < 26; ++j) num += (double)f[j] * ((double)f[j] - 1);
+        den += (double)N * (N - 1);
+        total += N;
+    }
+    double ic_obs = den > 0 ? num / den : 0.0;
+    double friedman = ((double)total * (ic_lang - ic_rand)) /
+                      ((total - 1) * ic_obs - total * ic_rand + ic_lang);
+    printf("Letras muestreadas: %lld, IC observado=%.5f\n", total, ic_obs);
+    printf("Friedman: longitud aproximada = %.2f\n\n", friedman);
+
+    // 2) Comprobación por IC (ic_for_n sobre cada ventana, ponderada por letras)
+    int best_n = 1; double best_dist = 1e300;
+    printf("IC medio por n (muestra):\n");
+    for (int n = 1; n <= max_k; ++n) {
+        double acc = 0.0; long long wsum = 0;
+        for (int w = 0; w < windows; ++w) {
+            if (win[w].len < 2 * n) continue;
+            acc += ic_for_n(win[w].text, win[w].len, n) * win[w].len;
+            wsum += win[w].len;
+        }
+        double avg_ic = wsum ? acc / wsum : 0.0;
+        double dist = fabs(avg_ic - ic_lang);
+        printf("  n=%2d -> ICmedio=%.5f (dist=%.5f)\n", n, avg_ic, dist);
+        if (ic_mejora(dist, best_dist)) {
+            best_dist = dist; best_n = n;
+        }
+    }
+    printf("\n>>> Estimación de longitud de clave: n = %d (Friedman %.2f)\n", best_n, friedman);
+
+    // 3) Subclaves: alinear la fase de cada ventana con la ventana 0 y sumar columnas
+    uint64_t (*acc)[26] = calloc(best_n, sizeof(*acc));
+    uint64_t (*hw)[26] = calloc(best_n, sizeof(*hw));
+    if (!acc || !hw) {
+        fprintf(stderr, "Error: sin memoria.\n");
+    } else {
+        columns_freq(win[0].text, win[0].len, best_n, acc);
+        for (int w = 1; w < windows; ++w) {
+            columns_freq(win[w].text, win[w].len, best_n, hw);
+            int r = sample_align((const uint64_t (*)[26])acc, (const uint64_t (*)[26])hw, best_n);
+            for (int k = 0; k < best_n; ++k)
+                for (int j = 0; j < 26; ++j) acc[k][j] += hw[(k + r) % best_n][j];
+        }
+        for (int i = 0; i < best_n; ++i) {
+            int k = best_shift_M_for_freq(acc[i], P);
+            out_key[i] = (char)('A' + k);
+            printf("  Subclave[%d] = %c (k=%d)\n", i+1, out_key[i], k);
+        }
+        out_key[best_n] = '\0';
+        reducir_periodo(out_key, best_n);
     }
+    free(acc); free(hw);
+    for (int w = 0; w < windows; ++w) free(win[w].text);
+    free(win);
+
+    // 4) Verificación opcional contra el análisis del fichero completo
+    if (verify) {
+        char full_key[MAX_K_CAND + 1];
+        FILE *in = fopen(filename, "r");
+        if (!in) { perror("Error abriendo fichero"); return; }
+        full_ic_pass(in, max_k, P, ic_lang, full_key);
+        fclose(in);
+        printf("\nVerificación con el fichero completo: %s -> %s\n", full_key,
+               strcmp(full_key, out_key) == 0 ? "coincide" : "NO coincide");
+    }
+}
 
-    char *text = malloc(MAX_TEXT);
-    int len = load_text(filein, text);
-    char clave[40];
-    if (mode == 1)
-        kasiski(text, len);
-    else if (mode == 2)
+// ===== Prueba masiva de claves candidatas (diccionario o top-N por columna) =====
+// Con la clave k, la columna j del prefijo descifrado es la columna cifrada
+// desplazada -k_j, así que el histograma del texto claro es O = Σ_j rot(H_j, k_j).
+// Se precalculan las 26 rotaciones de cada columna: probar una clave es sumar
+// n vectores de TRIAL_LANES floats, sin volver a descifrar el texto.
+// χ² = Σ (O_p - E_p)² / E_p = S - 2N + ΣE con S = Σ O_p² / E_p, y S solo crece
+// al añadir columnas: en cuanto supera al peor de los mejores, la clave (o toda
+// la rama de claves que comparten ese principio) se abandona.
 
-        vigenere_ic_attack(text, len, MAX_K_CAND, "es", clave);
+#define TRIAL_LANES 32      // 26 letras + relleno para vectorizar
+#define TRIAL_P_MIN 0.0005  // probabilidad mínima (K y W valen 0 en la tabla ES)
+#define TRIAL_LOTE 1024     // claves de diccionario que coge un hilo de cada vez
 
-    free(text);
+typedef struct {
+    int n;
+    float *rot; // rot[(j*26 + k)*TRIAL_LANES + p] = H_j[(p + k) % 26]
+} TrialTabla;
+
+typedef struct {
+    float w[TRIAL_LANES];               // 1 / E_p (0 en el relleno)
+    double cte;                         // ΣE - 2N
+    TrialTabla tablas[TRIAL_MAX_KEY + 1];
+    char **claves;                      // modo diccionario
+    int nclaves;
+    int n, top, fijas;                  // modo top-N: fijas = columnas que reparte el contador
+    int opciones[TRIAL_MAX_KEY][26];    // desplazamientos de cada columna, mejor M(k) primero
+    long long tareas;
+    atomic_llong siguiente;
+} Trial;
+
+typedef struct {
+    Trial *T;
+    TrialResultado top[TRIAL_TOP];
+    int ntop;
+    float umbral;       // S del peor de los TRIAL_TOP mejores (infinito hasta llenarlos)
+    long long nodos;    // sumas de columna hechas
+    int k[TRIAL_MAX_KEY];
+} TrialHilo;
+
+static int trial_tabla(Trial *T, const char *text, int len, int n) {
+    TrialTabla *t = &T->tablas[n];
+    if (t->rot) return 0;
+    t->rot = aligned_alloc(64, (size_t)n * 26 * TRIAL_LANES * sizeof(float));
+    if (!t->rot) return -1;
+    t->n = n;
+    for (int j = 0; j < n; ++j) {
+        uint64_t f[26];
+        column_freq(text, len, n, j, f);
+        for (int k = 0; k < 26; ++k) {
+            float *r = t->rot + ((size_t)j * 26 + k) * TRIAL_LANES;
+            for (int p = 0; p < TRIAL_LANES; ++p) r[p] = p < 26 ? (float)f[(p + k) % 26] : 0.0f;
+        }
+    }
     return 0;
 }
+
+/* o = a + r y devuelve S = Σ o² w (8 acumuladores para que se vectorice) */
+static inline float trial_sumar(float *restrict o, const float *restrict a,
+                                const float *restrict r, const float *restrict w) {
+    float acc[8] = {0};
+    for (int p = 0; p < TRIAL_LANES; p += 8)
+        for (int l = 0; l < 8; ++l) {
+            float v = a[p + l] + r[p + l];
+            o[p + l] = v;
+            acc[l] += v * v * w[p + l];
+        }
+    return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+}
+
+static void trial_anotar(TrialHilo *h, const int *k, int n, float s) {
+    int i = h->ntop < TRIAL_TOP ? h->ntop++ : TRIAL_TOP - 1;
+    while (i > 0 && h->top[i - 1].chi2 > s) {
+        h->top[i] = h->top[i - 1];
+        i--;
+    }
+    for (int j = 0; j < n; ++j) h->top[i].clave[j] = (char)('A' + k[j]);
+    h->top[i].clave[n] = '\0';
+    h->top[i].chi2 = s;
+    if (h->ntop == TRIAL_TOP) h->umbral = (float)h->top[TRIAL_TOP - 1].chi2;
+}
+
+/* Búsqueda en profundidad con poda desde la columna col (o = suma hasta col-1) */
+static void trial_rama(TrialHilo *h, int col, const float *o) {
+    Trial *T = h->T;
+    const float *rot = T->tablas[T->n].rot + (size_t)col * 26 * TRIAL_LANES;
+    _Alignas(64) float o2[TRIAL_LANES];
+    for (int i = 0; i < T->top; ++i) {
+        int k = T->opciones[col][i];
+        float s = trial_sumar(o2, o, rot + (size_t)k * TRIAL_LANES, T->w);
+        h->nodos++;
+        if (s >= h->umbral) continue;
+        h->k[col] = k;
+        if (col + 1 == T->n) trial_anotar(h, h->k, T->n, s);
+        else trial_rama(h, col + 1, o2);
+    }
+}
+
+static void *trial_hilo(void *arg) {
+    TrialHilo *h = arg;
+    Trial *T = h->T;
+    _Alignas(64) float o[TRIAL_LANES], o2[TRIAL_LANES];
+    long long t;
+
+    if (T->claves) {
+        // Diccionario: cada clave se suma columna a columna hasta que no puede ganar
+        while ((t = atomic_fetch_add(&T->siguiente, TRIAL_LOTE)) < T->nclaves) {
+            long long fin = t + TRIAL_LOTE < T->nclaves ? t + TRIAL_LOTE : T->nclaves;
+            for (; t < fin; ++t) {
+                const char *c = T->claves[t];
+                int n = (int)strlen(c);
+                const float *rot = T->tablas[n].rot;
+                float s = 0.0f;
+                memset(o, 0, sizeof(o));
+                int j = 0;
+                for (; j < n; ++j) {
+                    h->k[j] = c[j] - A;
+                    s = trial_sumar(o2, o, rot + ((size_t)j * 26 + h->k[j]) * TRIAL_LANES, T->w);
+                    memcpy(o, o2, sizeof(o));
+                    h->nodos++;
+                    if (s >= h->umbral) break;
+                }
+                if (j == n) trial_anotar(h, h->k, n, s);
+            }
+        }
+        return NULL;
+    }
+
+    // Top-N: cada tarea fija las primeras T->fijas columnas y explora el resto
+    while ((t = atomic_fetch_add(&T->siguiente, 1)) < T->tareas) {
+        memset(o, 0, sizeof(o));
+        float s = 0.0f;
+        long long r = t;
+        int col = 0;
+        for (; col < T->fijas; ++col) {
+            int k = T->opciones[col][r % T->top];
+            r /= T->top;
+            h->k[col] = k;
+            s = trial_sumar(o2, o, T->tablas[T->n].rot + ((size_t)col * 26 + k) * TRIAL_LANES, T->w);
+            memcpy(o, o2, sizeof(o));
+            h->nodos++;
+            if (s >= h->umbral) break;
+        }
+        if (col < T->fijas) continue;
+        if (col == T->n) trial_anotar(h, h->k, T->n, s);
+        else trial_rama(h, col, o);
+    }
+    return NULL;
+}
+
+/* Pesos del χ² para un prefijo de N letras */
+static void trial_pesos(Trial *T, int N, const char *lang) {
+    double P[26], sumE = 0.0;
+    load_language_probs(lang, P);
+    for (int p = 0; p < TRIAL_LANES; ++p) {
+        if (p < 26) {
+            double E = N * (P[p] > TRIAL_P_MIN ? P[p] : TRIAL_P_MIN);
+            T->w[p] = (float)(1.0 / E);
+            sumE += E;
+        } else {
+            T->w[p] = 0.0f;
+        }
+    }
+    T->cte = sumE - 2.0 * N;
+}
+
+/* Lanza los hilos y junta sus mejores claves en res */
+static int trial_ejecutar(Trial *T, int hilos, TrialResultado *res, long long *nodos) {
+    if (hilos <= 0) hilos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (hilos < 1) hilos = 1;
+    TrialHilo *h = calloc((size_t)hilos, sizeof(TrialHilo));
+    pthread_t *th = calloc((size_t)hilos, sizeof(pthread_t));
+    if (!h || !th) {
+        free(h); free(th);
+        return -1;
+    }
+    atomic_init(&T->siguiente, 0);
+    for (int i = 0; i < hilos; ++i) {
+        h[i].T = T;
+        h[i].umbral = INFINITY;
+    }
+    int lanzados = 0;
+    for (; lanzados < hilos - 1; ++lanzados)
+        if (pthread_create(&th[lanzados], NULL, trial_hilo, &h[lanzados]) != 0) break;
+    trial_hilo(&h[lanzados]); // este hilo también trabaja (y termina solo si no arrancó ninguno)
+    TrialHilo todo = { .T = T, .umbral = INFINITY };
+    *nodos = 0;
+    for (int i = 0; i <= lanzados; ++i) {
+        if (i < lanzados) pthread_join(th[i], NULL);
+        *nodos += h[i].nodos;
+        for (int r = 0; r < h[i].ntop; ++r) {
+            const TrialResultado *c = &h[i].top[r];
+            int n = (int)strlen(c->clave), k[TRIAL_MAX_KEY];
+            for (int j = 0; j < n; ++j) k[j] = c->clave[j] - A;
+            if (c->chi2 < todo.umbral) trial_anotar(&todo, k, n, (float)c->chi2);
+        }
+    }
+    for (int r = 0; r < todo.ntop; ++r) {
+        res[r] = todo.top[r];
+        res[r].chi2 += T->cte;
+    }
+    free(h);
+    free(th);
+    return todo.ntop;
+}
+
+static void trial_liberar(Trial *T) {
+    for (int n = 0; n <= TRIAL_MAX_KEY; ++n) free(T->tablas[n].rot);
+    free(T);
+}
+
+int vigenere_trial_claves(const char *text, int len, int prefix, char **claves, int nclaves,
+                          const char *lang, int hilos, TrialResultado *res, long long *nodos) {
+    if (prefix <= 0 || prefix > len) prefix = len;
+    Trial *T = calloc(1, sizeof(Trial));
+    if (!T) return -1;
+    trial_pesos(T, prefix, lang);
+
+    // Normalizar las claves (solo A-Z) y preparar una tabla por longitud
+    int validas = 0;
+    for (int i = 0; i < nclaves; ++i) {
+        char *c = claves[i];
+        int n = 0, largo = 0;
+        for (const char *q = c; *q; ++q) {
+            if (!TABLA_ASCII[(unsigned char)*q]) continue;
+            if (n == TRIAL_MAX_KEY) {
+                largo = 1;
+                break;
+            }
+            c[n++] = (char)TABLA_ASCII[(unsigned char)*q];
+        }
+        if (largo) {
+            fprintf(stderr, "Aviso: clave de más de %d letras ignorada: %.20s...\n", TRIAL_MAX_KEY, c);
+            continue;
+        }
+        c[n] = '\0';
+        if (n == 0) continue;
+        if (trial_tabla(T, text, prefix, n) < 0) { trial_liberar(T); return -1; }
+        claves[validas++] = c;
+    }
+    T->claves = claves;
+    T->nclaves = validas;
+    int r = validas ? trial_ejecutar(T, hilos, res, nodos) : 0;
+    trial_liberar(T);
+    return r;
+}
+
+int vigenere_trial_top(const char *text, int len, int prefix, int n, int top,
+                       const char *lang, int hilos, TrialResultado *res, long long *nodos) {
+    if (prefix <= 0 || prefix > len) prefix = len;
+    if (top < 1) top = 1;
+    if (top > 26) top = 26;
+    double P[26];
+    double ic_lang = load_language_probs(lang, P);
+    if (n <= 0) n = longitud_por_ic(text, len, MAX_K_CAND, ic_lang);
+    if (n < 0) return -1;
+    if (n > TRIAL_MAX_KEY) return -1;
+
+    Trial *T = calloc(1, sizeof(Trial));
+    if (!T) return -1;
+    trial_pesos(T, prefix, lang);
+    if (trial_tabla(T, text, prefix, n) < 0) { trial_liberar(T); return -1; }
+
+    // Las top mejores subclaves de cada columna según M(k) (con todo el texto)
+    for (int j = 0; j < n; ++j) {
+        uint64_t f[26];
+        column_freq(text, len, n, j, f);
+        uint64_t sc[26];
+        m_scores(f, P, sc);
+        for (int k = 0; k < 26; ++k) {
+            T->opciones[j][k] = k;
+        }
+        for (int a = 1; a < 26; ++a)
+            for (int b = a; b > 0 && sc[T->opciones[j][b]] > sc[T->opciones[j][b - 1]]; --b) {
+                int x = T->opciones[j][b];
+                T->opciones[j][b] = T->opciones[j][b - 1];
+                T->opciones[j][b - 1] = x;
+            }
+    }
+    T->n = n;
+    T->top = top;
+    T->fijas = n < 3 ? n : 3;
+    T->tareas = 1;
+    for (int j = 0; j < T->fijas; ++j) T->tareas *= top;
+
+    int r = trial_ejecutar(T, hilos, res, nodos);
+    trial_liberar(T);
+    return r;
+}
+
+// ===== Arrastre de un texto probable (crib dragging) =====
+// Si el claro contiene la palabra p (L letras) a partir de la letra i, la clave
+// en i..i+L-1 es K_j = c[i+j] - p[j] mod 26. Para cada i se deduce ese
+// segmento y se mira si es periódico: K_j = K_{j+n} para todo j < L-n. Con la
+// clave de periodo n y L-n >= CRIB_MIN_COMPROB comprobaciones, un desplazamiento
+// al azar solo pasa con probabilidad 26^-(L-n). Los segmentos se calculan para
+// 32 (o 16) desplazamientos a la vez: cada K_j es una resta de bytes sobre el
+// cifrado desplazado j y cada comprobación, una comparación de vectores.
+
+#define CRIB_TAREA (1 << 20)   // desplazamientos que coge un hilo de cada vez
+#define CRIB_MARCAS (1 << 16)  // marcas que guarda cada hilo como mucho
+#define CRIB_PUNTUAR 4096      // letras con las que se puntúa cada clave candidata
+
+typedef struct {
+    long long pos; // letra del cifrado donde empezaría el crib
+    int n;         // periodo mínimo del segmento de clave
+} CribMarca;
+
+typedef struct {
+    const char *text;
+    long long len, fin; // fin = desplazamientos posibles (len - L + 1)
+    unsigned char p[CRIB_MAX];
+    int L, max_n;
+    atomic_llong siguiente;
+} Crib;
+
+typedef struct {
+    Crib *C;
+    CribMarca *marcas;
+    long long nmarcas, total;
+} CribHilo;
+
+static inline void crib_marcar(CribHilo *h, long long pos, int n) {
+    if (h->nmarcas < CRIB_MARCAS) h->marcas[h->nmarcas++] = (CribMarca){ pos, n };
+    h->total++;
+}
+
+// Desplazamientos [i, fin) de uno en uno
+static void crib_escalar(CribHilo *h, long long i, long long fin) {
+    const Crib *C = h->C;
+    unsigned char k[CRIB_MAX];
+    for (; i < fin; ++i) {
+        for (int j = 0; j < C->L; ++j) k[j] = (unsigned char)((C->text[i + j] - A + 26 - C->p[j]) % 26);
+        for (int n = 1; n <= C->max_n; ++n) {
+            int j = 0;
+            while (j + n < C->L && k[j] == k[j + n]) ++j;
+            if (j + n == C->L) {
+                crib_marcar(h, i, n);
+                break;
+            }
+        }
+    }
+}
+
+static void crib_rango(CribHilo *h, long long i, long long fin) {
+    const Crib *C = h->C;
+#if defined(__AVX2__)
+    // 32 desplazamientos por vuelta; en cada periodo solo siguen los que aún no
+    // tienen uno menor y la comparación para en cuanto no queda ninguno
+    __m256i kv[CRIB_MAX];
+    const __m256i veinti6 = _mm256_set1_epi8(26), cero = _mm256_setzero_si256();
+    for (; i + 32 <= fin; i += 32) {
+        for (int j = 0; j < C->L; ++j) {
+            __m256i d = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i *)(C->text + i + j)),
+                                        _mm256_set1_epi8((char)(A + C->p[j])));
+            kv[j] = _mm256_add_epi8(d, _mm256_and_si256(_mm256_cmpgt_epi8(cero, d), veinti6));
+        }
+        uint32_t resto = 0xFFFFFFFFu;
+        for (int n = 1; n <= C->max_n && resto; ++n) {
+            uint32_t m = resto;
+            for (int j = 0; j + n < C->L && m; ++j)
+                m &= (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(kv[j], kv[j + n]));
+            resto &= ~m;
+            for (; m; m &= m - 1) crib_marcar(h, i + __builtin_ctz(m), n);
+        }
+    }
+#elif defined(__SSE2__)
+    __m128i kv[CRIB_MAX];
+    const __m128i veinti6 = _mm_set1_epi8(26), cero = _mm_setzero_si128();
+    for (; i + 16 <= fin; i += 16) {
+        for (int j = 0; j < C->L; ++j) {
+            __m128i d = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)(C->text + i + j)),
+                                     _mm_set1_epi8((char)(A + C->p[j])));
+            kv[j] = _mm_add_epi8(d, _mm_and_si128(_mm_cmpgt_epi8(cero, d), veinti6));
+        }
+        uint32_t resto = 0xFFFFu;
+        for (int n = 1; n <= C->max_n && resto; ++n) {
+            uint32_t m = resto;
+            for (int j = 0; j + n < C->L && m; ++j)
+                m &= (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(kv[j], kv[j + n]));
+            resto &= ~m;
+            for (; m; m &= m - 1) crib_marcar(h, i + __builtin_ctz(m), n);
+        }
+    }
+#endif
+    crib_escalar(h, i, fin);
+}
+
+static void *crib_hilo(void *arg) {
+    CribHilo *h = arg;
+    Crib *C = h->C;
+    long long t;
+    while ((t = atomic_fetch_add(&C->siguiente, CRIB_TAREA)) < C->fin)
+        crib_rango(h, t, t + CRIB_TAREA < C->fin ? t + CRIB_TAREA : C->fin);
+    return NULL;
+}
+
+// Clave candidata: las marcas que dan la misma clave se juntan en una
+typedef struct {
+    char clave[MAX_K_CAND + 1];
+    int n;
+    long long pos, votos;
+    double chi2;
+} CribCandidato;
+
+static int crib_cmp_clave(const void *a, const void *b) {
+    const CribCandidato *x = a, *y = b;
+    return x->n != y->n ? x->n - y->n : strcmp(x->clave, y->clave);
+}
+
+static int crib_cmp_chi2(const void *a, const void *b) {
+    const CribCandidato *x = a, *y = b;
+    if (x->chi2 != y->chi2) return x->chi2 < y->chi2 ? -1 : 1;
+    return x->votos != y->votos ? (x->votos > y->votos ? -1 : 1) : (x->pos > y->pos) - (x->pos < y->pos);
+}
+
+// χ² por letra de las primeras N letras descifradas con la clave
+static double crib_chi2(const char *text, long long N, const char *clave, int n, const double P[26]) {
+    uint64_t h[26] = {0};
+    for (long long i = 0, c = 0; i < N; ++i) {
+        h[(text[i] - clave[c] + 26) % 26]++;
+        if (++c == n) c = 0;
+    }
+    double chi2 = 0.0;
+    for (int x = 0; x < 26; ++x) {
+        double E = (double)N * (P[x] > TRIAL_P_MIN ? P[x] : TRIAL_P_MIN);
+        chi2 += ((double)h[x] - E) * ((double)h[x] - E) / E;
+    }
+    return N ? chi2 / (double)N : 0.0;
+}
+
+// Longitud y clave por IC medio y M(k), sin informe (lo que daría -ic).
+// Devuelve -1 si no hay memoria
+static int crib_clave_ic(const char *text, int len, int max_k, const char *lang, char *key) {
+    double P[26];
+    double ic_lang = load_language_probs(lang, P);
+    int n = longitud_por_ic(text, len, max_k, ic_lang);
+    if (n < 0) return -1;
+    uint64_t (*f)[26] = malloc((size_t)n * sizeof(*f));
+    if (!f || columnas_contar(text, len, n, f) < 0) { free(f); return -1; }
+    for (int j = 0; j < n; ++j) key[j] = (char)(A + best_shift_M_for_freq(f[j], P));
+    key[n] = '\0';
+    free(f);
+    n = periodo_minimo(key, n);
+    key[n] = '\0';
+    return n;
+}
+
+long long load_text_todo(const unsigned char *p, size_t n, char **out)
+{
+    char *buffer = malloc(n + 1);
+    if (!buffer)
+        return -1;
+    Normalizador nz;
+    normalizador_init(&nz, NORM_ASCII);
+    long long len = 0;
+    for (size_t off = 0; off < n; off += STREAM_CHUNK)
+    {
+        size_t got = n - off < STREAM_CHUNK ? n - off : STREAM_CHUNK;
+        INSTR_SUMAR(INSTR_BYTES_LEIDOS, got);
+        len += (long long)normalizar_bloque(&nz, p + off, got, buffer + len);
+    }
+    buffer[len] = '\0';
+    *out = buffer;
+    return len;
+}
+
+int vigenere_crib(const char *text, long long len, const char *crib, int max_k, const char *lang, int hilos,
+                  char *out_key) {
+    out_key[0] = '\0';
+    Crib *C = calloc(1, sizeof(Crib));
+    if (!C) return -1;
+    for (const char *q = crib; *q && C->L < CRIB_MAX; ++q)
+        if (TABLA_ASCII[(unsigned char)*q]) C->p[C->L++] = (unsigned char)(TABLA_ASCII[(unsigned char)*q] - A);
+    if (max_k < 1 || max_k > MAX_K_CAND) max_k = MAX_K_CAND;
+    C->max_n = C->L - CRIB_MIN_COMPROB < max_k ? C->L - CRIB_MIN_COMPROB : max_k;
+    if (C->max_n < 1 || len < C->L) {
+        fprintf(stderr, "El crib necesita al menos %d letras (y el cifrado, tantas como él)\n",
+                CRIB_MIN_COMPROB + 1);
+        free(C);
+        return -1;
+    }
+    C->text = text;
+    C->len = len;
+    C->fin = len - C->L + 1;
+    atomic_init(&C->siguiente, 0);
+
+    // 1) Arrastre en paralelo: este hilo también trabaja
+    if (hilos <= 0) hilos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (hilos < 1) hilos = 1;
+    CribHilo *h = calloc((size_t)hilos, sizeof(CribHilo));
+    pthread_t *th = calloc((size_t)hilos, sizeof(pthread_t));
+    if (!h || !th) {
+        free(h); free(th); free(C);
+        return -1;
+    }
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int lanzados = 0, ok = 1;
+    for (int i = 0; i < hilos; ++i) {
+        h[i].C = C;
+        h[i].marcas = malloc(CRIB_MARCAS * sizeof(CribMarca));
+        ok &= h[i].marcas != NULL;
+    }
+    for (; ok && lanzados < hilos - 1; ++lanzados)
+        if (pthread_create(&th[lanzados], NULL, crib_hilo, &h[lanzados + 1]) != 0) break;
+    if (ok) crib_hilo(&h[0]);
+    for (int i = 0; i < lanzados; ++i) pthread_join(th[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+    // 2) Cada marca da la clave entera, alineada con el principio del cifrado
+    long long nmarcas = 0, total = 0;
+    for (int i = 0; i < hilos; ++i) {
+        nmarcas += h[i].nmarcas;
+        total += h[i].total;
+    }
+    CribCandidato *cand = ok ? malloc((size_t)(nmarcas ? nmarcas : 1) * sizeof(CribCandidato)) : NULL;
+    if (!cand) {
+        for (int i = 0; i < hilos; ++i) free(h[i].marcas);
+        free(h); free(th); free(C);
+        return -1;
+    }
+    long long nc = 0;
+    for (int i = 0; i < hilos; ++i)
+        for (long long r = 0; r < h[i].nmarcas; ++r) {
+            const CribMarca *m = &h[i].marcas[r];
+            CribCandidato *c = &cand[nc++];
+            for (int j = 0; j < m->n; ++j)
+                c->clave[(m->pos + j) % m->n] = (char)(A + (text[m->pos + j] - A + 26 - C->p[j]) % 26);
+            c->clave[m->n] = '\0';
+            c->n = m->n;
+            c->pos = m->pos;
+            c->votos = 1;
+        }
+
+    // 3) Se juntan las repetidas y se ordenan por el χ² del descifrado
+    qsort(cand, (size_t)nc, sizeof(*cand), crib_cmp_clave);
+    long long nd = 0;
+    for (long long r = 0; r < nc; ++r) {
+        if (nd && crib_cmp_clave(&cand[nd - 1], &cand[r]) == 0) {
+            cand[nd - 1].votos++;
+            if (cand[r].pos < cand[nd - 1].pos) cand[nd - 1].pos = cand[r].pos;
+        } else {
+            cand[nd++] = cand[r];
+        }
+    }
+    double P[26];
+    load_language_probs(lang, P);
+    long long N = len < CRIB_PUNTUAR ? len : CRIB_PUNTUAR;
+    for (long long r = 0; r < nd; ++r) cand[r].chi2 = crib_chi2(text, N, cand[r].clave, cand[r].n, P);
+    qsort(cand, (size_t)nd, sizeof(*cand), crib_cmp_chi2);
+
+    // 4) Contraste con el ataque por IC
+    char key_ic[MAX_K_CAND + 1];
+    int n_ic = crib_clave_ic(text, len < MAX_TEXT ? (int)len : MAX_TEXT - 1, max_k, lang, key_ic);
+    if (n_ic < 0) {
+        fprintf(stderr, "Error: sin memoria.\n");
+        for (int i = 0; i < hilos; ++i) free(h[i].marcas);
+        free(h); free(th); free(cand); free(C);
+        return -1;
+    }
+
+    printf("=== Arrastre del crib \"");
+    for (int j = 0; j < C->L; ++j) putchar(A + C->p[j]);
+    printf("\" (%d letras, periodos 1..%d) ===\n", C->L, C->max_n);
+    printf("%lld desplazamientos en %.3f s (%.1f M/s), %lld marcados", C->fin, secs,
+           secs > 0 ? C->fin / secs / 1e6 : 0.0, total);
+    if (nmarcas < total) printf(" (%lld guardados)", nmarcas);
+    printf(", %lld claves distintas\n", nd);
+    printf("IC: n = %d, clave %s\n\n", n_ic, key_ic);
+    for (long long r = 0; r < nd && r < CRIB_TOP; ++r) {
+        const CribCandidato *c = &cand[r];
+        const char *acuerdo = c->n == n_ic ? (strcmp(c->clave, key_ic) == 0 ? "coincide" : "mismo periodo") : "-";
+        printf("  %2lld. pos %-10lld n=%-2d votos %-6lld chi2 %7.3f  %-14s %s\n", r + 1, c->pos, c->n, c->votos,
+               c->chi2, acuerdo, c->clave);
+        // Claro alrededor del crib
+        long long a = c->pos >= 16 ? c->pos - 16 : 0, b = c->pos + C->L + 16 < len ? c->pos + C->L + 16 : len;
+        printf("      ");
+        for (long long i = a; i < b; ++i) putchar(A + (text[i] - c->clave[i % c->n] + 26) % 26);
+        putchar('\n');
+    }
+    if (nd) {
+        strcpy(out_key, cand[0].clave);
+        printf("\n>>> Clave estimada: %s (%s con el IC)\n", out_key,
+               strcmp(out_key, key_ic) == 0 ? "coincide" : "NO coincide");
+    } else {
+        printf(">>> Ningún desplazamiento da un segmento de clave periódico\n");
+    }
+
+    for (int i = 0; i < hilos; ++i) free(h[i].marcas);
+    free(h); free(th); free(cand); free(C);
+    return (int)(nd < INT_MAX ? nd : INT_MAX);
+}
@@ -130,36 +130,86 @@ ExtendedEuclidesResult extended_euclides(const mpz_t a, const mpz_t b) {
     return res;
 }
 
-/**int main(void) {
-    mpz_t a, b, lhs;
-    mpz_inits(a, b, lhs, NULL);
-
-    // Ejemplo de prueba
-    mpz_set_ui(a, 5);
-    mpz_set_ui(b, 26);
-
-    ExtendedEuclidesResult res = extended_euclides(a, b);
-
-    // 1. Mostrar resultados
-    gmp_printf("a = %Zd, b = %Zd\n", a, b);
-    gmp_printf("gcd = %Zd\n", res.mcd);
-    gmp_printf("s = %Zd, t = %Zd\n", res.s, res.t);
+void euclides_trabajo_init(EuclidesTrabajo *w) {
+    mpz_inits(w->r0, w->r1, w->r2, w->s0, w->s1, w->s2, w->t0, w->t1, w->t2, w->q, NULL);
+}
 
-    // 2. Comprobar identidad de Bézout: a*s + b*t = gcd
-    mpz_mul(lhs, a, res.s);
-    mpz_addmul(lhs, b, res.t);   // lhs = a*s + b*t
+void euclides_trabajo_clear(EuclidesTrabajo *w) {
+    mpz_clears(w->r0, w->r1, w->r2, w->s0, w->s1, w->s2, w->t0, w->t1, w->t2, w->q, NULL);
+}
 
-    gmp_printf("a*s + b*t = %Zd\n", lhs);
+int euclides_w(EuclidesTrabajo *w, mpz_t mcd, const mpz_t a, const mpz_t b, EuclidesCociente fn, void *ctx) {
+    int n = 0;
+    mpz_set(w->r0, a);
+    mpz_set(w->r1, b);
+    while (mpz_sgn(w->r1) != 0) {
+        // r2 = r0 - q*r1 con q = ⌊r0 / r1⌋, en una sola división
+        mpz_fdiv_qr(w->q, w->r2, w->r0, w->r1);
+        if (fn) fn(w->q, n, ctx);
+        n++;
+        mpz_swap(w->r0, w->r1);
+        mpz_swap(w->r1, w->r2);
+    }
+    mpz_set(mcd, w->r0);
+    return n;
+}
 
-    if (mpz_cmp(lhs, res.mcd) == 0) {
-        printf("Identidad de Bézout verificada\n");
-    } else {
-        printf("Error en la identidad de Bézout\n");
+void extended_euclides_w(EuclidesTrabajo *w, mpz_t mcd, mpz_t s, mpz_t t, const mpz_t a, const mpz_t b) {
+    mpz_set(w->r0, a);
+    mpz_set(w->r1, b);
+    mpz_set_ui(w->s0, 1);
+    mpz_set_ui(w->s1, 0);
+    mpz_set_ui(w->t0, 0);
+    mpz_set_ui(w->t1, 1);
+    while (mpz_sgn(w->r1) != 0) {
+        mpz_fdiv_qr(w->q, w->r2, w->r0, w->r1);
+
+        // s2 = s0 - q*s1, t2 = t0 - q*t1
+        mpz_set(w->s2, w->s0);
+        mpz_submul(w->s2, w->q, w->s1);
+        mpz_set(w->t2, w->t0);
+        mpz_submul(w->t2, w->q, w->t1);
+
+        // avanzar sin copiar: los intercambios solo mueven punteros
+        mpz_swap(w->r0, w->r1);
+        mpz_swap(w->r1, w->r2);
+        mpz_swap(w->s0, w->s1);
+        mpz_swap(w->s1, w->s2);
+        mpz_swap(w->t0, w->t1);
+        mpz_swap(w->t1, w->t2);
     }
+    mpz_set(mcd, w->r0);
+    mpz_set(s, w->s0);
+    mpz_set(t, w->t0);
+}
 
-    // Liberar
-    mpz_clears(a, b, lhs, NULL);
-    mpz_clears(res.mcd, res.s, res.t, NULL);
+int euclides_u64(uint64_t a, uint64_t b, uint64_t *mcd, uint64_t q[EUCLIDES_U64_PASOS]) {
+    int n = 0;
+    while (b != 0) {
+        uint64_t qn = a / b, r = a - qn * b;
+        if (q) q[n] = qn;
+        n++;
+        a = b;
+        b = r;
+    }
+    *mcd = a;
+    return n;
+}
 
-    return 0;
-}**/
+uint64_t extended_euclides_u64(uint64_t a, uint64_t b, int64_t *s, int64_t *t) {
+    // |s|, |t| <= max(a, b) < 2^63; q·s1 puede pasarse un momento de 64 bits
+    __int128 s0 = 1, s1 = 0, t0 = 0, t1 = 1;
+    while (b != 0) {
+        uint64_t q = a / b, r = a - q * b;
+        __int128 s2 = s0 - (__int128)q * s1, t2 = t0 - (__int128)q * t1;
+        a = b;
+        b = r;
+        s0 = s1;
+        s1 = s2;
+        t0 = t1;
+        t1 = t2;
+    }
+    *s = (int64_t)s0;
+    *t = (int64_t)t0;
+    return a;
+}
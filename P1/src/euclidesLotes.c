@@ -0,0 +1,499 @@
+#define _GNU_SOURCE
+#include "euclidesLotes.h"
+#include "euclides.h"
+#include <gmp.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define EUC_RESERVA 4096 // hueco de salida que se asegura antes de cada par
+
+enum { LOTE_LIBRE, LOTE_LLENO, LOTE_HECHO };
+
+typedef struct {
+    char *in;
+    size_t nin, cap_in;
+    char *out;
+    size_t nout, cap_out;
+    long long pares, rapidos, errores;
+    int estado;
+    int mal; // sin memoria para la salida
+} EucLote;
+
+typedef struct {
+    const EucOpciones *op;
+    EucLote *lotes;
+    int nlotes;
+    long long leidos;    // lotes llenados por el hilo principal
+    long long siguiente; // siguiente lote que coge un hilo de cálculo
+    int fin;             // no queda entrada
+    pthread_mutex_t mu;
+    pthread_cond_t hay_trabajo, hay_hecho;
+} EucCola;
+
+typedef struct {
+    EucCola *c;
+    EucLote *l; // lote en curso (para el callback de cocientes)
+    EuclidesTrabajo w;
+    mpz_t a, b, g, s, t;
+} EucHilo;
+
+/* ---------- salida ---------- */
+
+static int reservar(EucLote *l, size_t n) {
+    if (l->nout + n <= l->cap_out) return 0;
+    size_t cap = l->cap_out ? l->cap_out : EUC_LOTE;
+    while (cap < l->nout + n) cap *= 2;
+    char *p = realloc(l->out, cap);
+    if (!p) {
+        l->mal = 1;
+        return -1;
+    }
+    l->out = p;
+    l->cap_out = cap;
+    return 0;
+}
+
+static void poner_u64(EucLote *l, uint64_t v) {
+    char tmp[20];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n) l->out[l->nout++] = tmp[--n];
+}
+
+static void poner_i64(EucLote *l, int64_t v) {
+    if (v < 0) {
+        l->out[l->nout++] = '-';
+        poner_u64(l, (uint64_t)0 - (uint64_t)v);
+    } else {
+        poner_u64(l, (uint64_t)v);
+    }
+}
+
+static void poner_cab(EucLote *l, unsigned cab) {
+    l->out[l->nout++] = (char)(cab & 0xFF);
+    l->out[l->nout++] = (char)(cab >> 8);
+}
+
+static void poner_u64_bin(EucLote *l, uint64_t m, int neg) {
+    int n = 0;
+    for (uint64_t x = m; x; x >>= 8) n++;
+    poner_cab(l, (unsigned)n | (neg && m ? EUC_BIN_SIGNO : 0));
+    for (int i = n - 1; i >= 0; --i) l->out[l->nout++] = (char)(m >> (8 * i));
+}
+
+/* Un número de 64 bits en el formato de salida (separado por sep en texto) */
+static void poner_num64(EucLote *l, int bin, char sep, uint64_t m, int neg) {
+    if (bin) {
+        poner_u64_bin(l, m, neg);
+        return;
+    }
+    if (sep) l->out[l->nout++] = sep;
+    if (neg) poner_i64(l, -(int64_t)m);
+    else poner_u64(l, m);
+}
+
+static void poner_mpz(EucLote *l, int bin, char sep, const mpz_t x) {
+    size_t n = bin ? (mpz_sizeinbase(x, 2) + 7) / 8 + 2 : mpz_sizeinbase(x, 10) + 3;
+    if (reservar(l, n + EUC_RESERVA) < 0) return;
+    if (bin) {
+        if (n - 2 > EUC_BIN_MAX) {
+            poner_cab(l, EUC_BIN_ERROR);
+            return;
+        }
+        size_t cnt = 0;
+        mpz_export(l->out + l->nout + 2, &cnt, 1, 1, 1, 0, x);
+        poner_cab(l, (unsigned)cnt | (mpz_sgn(x) < 0 ? EUC_BIN_SIGNO : 0));
+        l->nout += cnt;
+        return;
+    }
+    if (sep) l->out[l->nout++] = sep;
+    mpz_get_str(l->out + l->nout, 10, x);
+    l->nout += strlen(l->out + l->nout);
+}
+
+static void poner_error(EucLote *l, int bin) {
+    if (bin) {
+        poner_cab(l, EUC_BIN_ERROR);
+    } else {
+        memcpy(l->out + l->nout, "error\n", 6);
+        l->nout += 6;
+    }
+    l->errores++;
+}
+
+/* ---------- cálculo ---------- */
+
+static void cociente_mpz(const mpz_t q, int n, void *ctx) {
+    EucHilo *h = ctx;
+    (void)n;
+    poner_mpz(h->l, h->c->op->bin_out, ' ', q);
+}
+
+/* Par de 64 bits (0 <= a, b < 2^63) */
+static void calcular_u64(EucHilo *h, uint64_t a, uint64_t b) {
+    EucLote *l = h->l;
+    int bin = h->c->op->bin_out;
+    uint64_t g;
+    switch (h->c->op->modo) {
+    case EUC_MCD:
+        euclides_u64(a, b, &g, NULL);
+        poner_num64(l, bin, 0, g, 0);
+        break;
+    case EUC_EXT: {
+        int64_t s, t;
+        g = extended_euclides_u64(a, b, &s, &t);
+        poner_num64(l, bin, 0, g, 0);
+        poner_num64(l, bin, ' ', s < 0 ? (uint64_t)0 - (uint64_t)s : (uint64_t)s, s < 0);
+        poner_num64(l, bin, ' ', t < 0 ? (uint64_t)0 - (uint64_t)t : (uint64_t)t, t < 0);
+        break;
+    }
+    case EUC_CF: {
+        uint64_t q[EUCLIDES_U64_PASOS];
+        int n = euclides_u64(a, b, &g, q);
+        poner_num64(l, bin, 0, g, 0);
+        if (bin)
+            for (int i = 0; i < 4; ++i) l->out[l->nout++] = (char)((uint32_t)n >> (8 * i));
+        for (int i = 0; i < n; ++i) poner_num64(l, bin, ' ', q[i], 0);
+        break;
+    }
+    }
+    if (!bin) l->out[l->nout++] = '\n';
+    l->rapidos++;
+}
+
+/* Par en h->a, h->b */
+static void calcular_mpz(EucHilo *h) {
+    EucLote *l = h->l;
+    int bin = h->c->op->bin_out;
+    switch (h->c->op->modo) {
+    case EUC_MCD:
+        // Sin cocientes que sacar, mpz_gcd (subcuadrático) da el mismo mcd si no hay signos
+        if (mpz_sgn(h->a) >= 0 && mpz_sgn(h->b) >= 0) mpz_gcd(h->g, h->a, h->b);
+        else euclides_w(&h->w, h->g, h->a, h->b, NULL, NULL);
+        poner_mpz(l, bin, 0, h->g);
+        break;
+    case EUC_EXT:
+        extended_euclides_w(&h->w, h->g, h->s, h->t, h->a, h->b);
+        poner_mpz(l, bin, 0, h->g);
+        poner_mpz(l, bin, ' ', h->s);
+        poner_mpz(l, bin, ' ', h->t);
+        break;
+    case EUC_CF: {
+        // El mcd va delante de los cocientes: se deja su sitio y se escribe al final
+        size_t ini = l->nout;
+        int n = euclides_w(&h->w, h->g, h->a, h->b, cociente_mpz, h);
+        if (l->mal) return;
+        size_t nq = l->nout - ini;
+        size_t ng = bin ? (mpz_sizeinbase(h->g, 2) + 7) / 8 + 6 : mpz_sizeinbase(h->g, 10) + 2;
+        if (reservar(l, ng + EUC_RESERVA) < 0) return;
+        memmove(l->out + ini + ng, l->out + ini, nq);
+        l->nout = ini;
+        poner_mpz(l, bin, 0, h->g);
+        if (bin)
+            for (int i = 0; i < 4; ++i) l->out[l->nout++] = (char)((uint32_t)n >> (8 * i));
+        memmove(l->out + l->nout, l->out + ini + ng, nq);
+        l->nout += nq;
+        break;
+    }
+    }
+    if (!bin && !l->mal) l->out[l->nout++] = '\n';
+}
+
+/* ---------- entrada ---------- */
+
+/* Número decimal en [p, fin) sin signo y de como mucho 18 cifras */
+static int leer_u63(const char *p, const char *fin, uint64_t *v) {
+    if (p == fin || fin - p > 18) return 0;
+    uint64_t x = 0;
+    for (; p < fin; ++p) {
+        if (*p < '0' || *p > '9') return 0;
+        x = x * 10 + (uint64_t)(*p - '0');
+    }
+    *v = x;
+    return 1;
+}
+
+static inline int separador(char c) {
+    return c == ' ' || c == '\t' || c == ',' || c == '\r';
+}
+
+static void procesar_texto(EucHilo *h) {
+    EucLote *l = h->l;
+    char *p = l->in, *fin = l->in + l->nin;
+    while (p < fin && !l->mal) {
+        char *eol = memchr(p, '\n', (size_t)(fin - p));
+        if (!eol) eol = fin;
+        char *linea = p;
+        p = eol + 1;
+        while (linea < eol && separador(*linea)) linea++;
+        if (linea == eol || *linea == '#') continue;
+        if (reservar(l, EUC_RESERVA) < 0) break;
+        l->pares++;
+
+        // Dos campos: a y b
+        char *a0 = linea, *a1 = a0;
+        while (a1 < eol && !separador(*a1)) a1++;
+        char *b0 = a1;
+        while (b0 < eol && separador(*b0)) b0++;
+        char *b1 = b0;
+        while (b1 < eol && !separador(*b1)) b1++;
+        char *resto = b1;
+        while (resto < eol && separador(*resto)) resto++;
+        if (b0 == eol || resto != eol) {
+            poner_error(l, h->c->op->bin_out);
+            continue;
+        }
+        uint64_t a, b;
+        if (leer_u63(a0, a1, &a) && leer_u63(b0, b1, &b)) {
+            calcular_u64(h, a, b);
+            continue;
+        }
+        // Camino general: los campos se terminan en el propio lote
+        *a1 = '\0';
+        *b1 = '\0';
+        if (mpz_set_str(h->a, a0, 10) < 0 || mpz_set_str(h->b, b0, 10) < 0) {
+            poner_error(l, h->c->op->bin_out);
+            continue;
+        }
+        calcular_mpz(h);
+    }
+}
+
+static inline size_t cab_bin(const unsigned char *p) {
+    return (size_t)p[0] | (size_t)p[1] << 8;
+}
+
+/* Bytes que ocupa el número que empieza en p (la cabecera de error va sola) */
+static inline size_t tam_bin(const unsigned char *p) {
+    size_t cab = cab_bin(p);
+    return cab == EUC_BIN_ERROR ? 2 : 2 + (cab & EUC_BIN_LARGO);
+}
+
+/* Número binario en p (ya comprobado que está completo); 1 si cabe en 63 bits */
+static int leer_bin(const unsigned char *p, uint64_t *v, mpz_t x, size_t *tam) {
+    size_t cab = cab_bin(p), n = cab & EUC_BIN_LARGO;
+    *tam = 2 + n;
+    if (!(cab & EUC_BIN_SIGNO) && (n < 8 || (n == 8 && p[2] < 0x80))) {
+        uint64_t m = 0;
+        for (size_t i = 0; i < n; ++i) m = m << 8 | p[2 + i];
+        *v = m;
+        return 1;
+    }
+    mpz_import(x, n, 1, 1, 1, 0, p + 2);
+    if (cab & EUC_BIN_SIGNO) mpz_neg(x, x);
+    return 0;
+}
+
+static void procesar_bin(EucHilo *h) {
+    EucLote *l = h->l;
+    const unsigned char *p = (const unsigned char *)l->in, *fin = p + l->nin;
+    while (p < fin && !l->mal) {
+        if (reservar(l, EUC_RESERVA) < 0) break;
+        l->pares++;
+        // Un par incompleto solo puede quedar al final de la entrada
+        size_t resto = (size_t)(fin - p), ta = resto >= 2 ? tam_bin(p) : 0;
+        if (resto < 4 || resto < ta + 2 || resto < ta + tam_bin(p + ta)) {
+            poner_error(l, h->c->op->bin_out);
+            break;
+        }
+        size_t tb = tam_bin(p + ta);
+        // Magnitudes de más de EUC_BIN_MAX bytes (o la cabecera de error)
+        if ((cab_bin(p) & EUC_BIN_LARGO) > EUC_BIN_MAX || (cab_bin(p + ta) & EUC_BIN_LARGO) > EUC_BIN_MAX) {
+            p += ta + tb;
+            poner_error(l, h->c->op->bin_out);
+            continue;
+        }
+        uint64_t a, b;
+        int ra = leer_bin(p, &a, h->a, &ta);
+        int rb = leer_bin(p + ta, &b, h->b, &tb);
+        p += ta + tb;
+        if (ra && rb) {
+            calcular_u64(h, a, b);
+            continue;
+        }
+        if (ra) mpz_set_ui(h->a, a);
+        if (rb) mpz_set_ui(h->b, b);
+        calcular_mpz(h);
+    }
+}
+
+/* Bytes de [p, p+n) que forman registros completos */
+static size_t frontera(const char *p, size_t n, int bin) {
+    if (!bin) {
+        const char *e = memrchr(p, '\n', n);
+        return e ? (size_t)(e - p) + 1 : 0;
+    }
+    const unsigned char *u = (const unsigned char *)p;
+    size_t i = 0;
+    for (;;) {
+        size_t j = i;
+        for (int k = 0; k < 2; ++k) {
+            if (n - j < 2) return i;
+            j += tam_bin(u + j);
+            if (j > n) return i;
+        }
+        i = j;
+    }
+}
+
+/* ---------- cola ---------- */
+
+static void *euc_hilo(void *arg) {
+    EucHilo *h = arg;
+    EucCola *c = h->c;
+    pthread_mutex_lock(&c->mu);
+    for (;;) {
+        while (c->siguiente == c->leidos && !c->fin) pthread_cond_wait(&c->hay_trabajo, &c->mu);
+        if (c->siguiente == c->leidos) break;
+        EucLote *l = &c->lotes[c->siguiente++ % c->nlotes];
+        pthread_mutex_unlock(&c->mu);
+
+        h->l = l;
+        l->nout = 0;
+        l->pares = l->rapidos = l->errores = 0;
+        l->mal = 0;
+        if (c->op->bin_in) procesar_bin(h);
+        else procesar_texto(h);
+
+        pthread_mutex_lock(&c->mu);
+        l->estado = LOTE_HECHO;
+        pthread_cond_broadcast(&c->hay_hecho);
+    }
+    pthread_mutex_unlock(&c->mu);
+    return NULL;
+}
+
+/* Llena l con la entrada pendiente (*resto) y lo que se lea; 0 si no hay nada */
+static int llenar(EucLote *l, FILE *in, int bin, char **resto, size_t *nresto, int *eof) {
+    // Un byte más que cap_in: el último campo del lote se termina en su sitio
+    if (l->cap_in < *nresto + EUC_LOTE) {
+        char *p = realloc(l->in, *nresto + EUC_LOTE + 1);
+        if (!p) return -1;
+        l->in = p;
+        l->cap_in = *nresto + EUC_LOTE;
+    }
+    memcpy(l->in, *resto, *nresto);
+    l->nin = *nresto;
+    for (;;) {
+        while (!*eof && l->nin < l->cap_in) {
+            size_t got = fread(l->in + l->nin, 1, l->cap_in - l->nin, in);
+            if (got == 0) {
+                if (ferror(in)) return -1;
+                *eof = 1;
+            }
+            l->nin += got;
+        }
+        size_t corte = *eof ? l->nin : frontera(l->in, l->nin, bin);
+        if (corte > 0 || *eof) {
+            *nresto = l->nin - corte;
+            if (*nresto > EUC_LOTE) {
+                char *p = realloc(*resto, *nresto);
+                if (!p) return -1;
+                *resto = p;
+            }
+            memcpy(*resto, l->in + corte, *nresto);
+            l->nin = corte;
+            return corte > 0;
+        }
+        // Ni un registro completo: línea (o número) mayor que el lote
+        char *p = realloc(l->in, l->cap_in * 2 + 1);
+        if (!p) return -1;
+        l->in = p;
+        l->cap_in *= 2;
+    }
+}
+
+int euclides_lotes(FILE *in, FILE *out, const EucOpciones *op, EucEstad *st) {
+    int hilos = op->hilos > 0 ? op->hilos : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (hilos < 1) hilos = 1;
+    memset(st, 0, sizeof(*st));
+
+    EucCola c = { .op = op, .nlotes = hilos * EUC_LOTES_POR_HILO };
+    c.lotes = calloc((size_t)c.nlotes, sizeof(EucLote));
+    EucHilo *h = calloc((size_t)hilos, sizeof(EucHilo));
+    pthread_t *th = calloc((size_t)hilos, sizeof(pthread_t));
+    char *resto = malloc(EUC_LOTE);
+    if (!c.lotes || !h || !th || !resto) {
+        free(c.lotes); free(h); free(th); free(resto);
+        return -1;
+    }
+    pthread_mutex_init(&c.mu, NULL);
+    pthread_cond_init(&c.hay_trabajo, NULL);
+    pthread_cond_init(&c.hay_hecho, NULL);
+
+    // Cada hilo prepara su espacio de trabajo antes de empezar
+    int lanzados = 0;
+    for (; lanzados < hilos; ++lanzados) {
+        EucHilo *x = &h[lanzados];
+        x->c = &c;
+        euclides_trabajo_init(&x->w);
+        mpz_inits(x->a, x->b, x->g, x->s, x->t, NULL);
+        if (pthread_create(&th[lanzados], NULL, euc_hilo, x) != 0) {
+            euclides_trabajo_clear(&x->w);
+            mpz_clears(x->a, x->b, x->g, x->s, x->t, NULL);
+            break;
+        }
+    }
+
+    // El hilo principal lee por delante y escribe los lotes en orden
+    int eof = 0, ret = lanzados > 0 ? 0 : -1;
+    size_t nresto = 0;
+    long long escritos = 0;
+    pthread_mutex_lock(&c.mu);
+    while (ret == 0) {
+        while (!c.fin && c.leidos - escritos < c.nlotes) {
+            EucLote *l = &c.lotes[c.leidos % c.nlotes];
+            pthread_mutex_unlock(&c.mu);
+            int r = eof && nresto == 0 ? 0 : llenar(l, in, op->bin_in, &resto, &nresto, &eof);
+            pthread_mutex_lock(&c.mu);
+            if (r < 0) ret = -1;
+            if (r <= 0) {
+                c.fin = 1;
+                pthread_cond_broadcast(&c.hay_trabajo);
+                break;
+            }
+            l->estado = LOTE_LLENO;
+            c.leidos++;
+            pthread_cond_signal(&c.hay_trabajo);
+        }
+        if (escritos == c.leidos) break;
+        EucLote *l = &c.lotes[escritos % c.nlotes];
+        while (l->estado != LOTE_HECHO) pthread_cond_wait(&c.hay_hecho, &c.mu);
+        pthread_mutex_unlock(&c.mu);
+        if (l->mal || fwrite(l->out, 1, l->nout, out) != l->nout) ret = -1;
+        st->pares += l->pares;
+        st->rapidos += l->rapidos;
+        st->errores += l->errores;
+        pthread_mutex_lock(&c.mu);
+        l->estado = LOTE_LIBRE;
+        escritos++;
+    }
+    c.fin = 1;
+    pthread_cond_broadcast(&c.hay_trabajo);
+    pthread_mutex_unlock(&c.mu);
+
+    for (int i = 0; i < lanzados; ++i) {
+        pthread_join(th[i], NULL);
+        euclides_trabajo_clear(&h[i].w);
+        mpz_clears(h[i].a, h[i].b, h[i].g, h[i].s, h[i].t, NULL);
+    }
+    for (int i = 0; i < c.nlotes; ++i) {
+        free(c.lotes[i].in);
+        free(c.lotes[i].out);
+    }
+    pthread_mutex_destroy(&c.mu);
+    pthread_cond_destroy(&c.hay_trabajo);
+    pthread_cond_destroy(&c.hay_hecho);
+    free(c.lotes);
+    free(h);
+    free(th);
+    free(resto);
+    if (fflush(out) != 0) ret = -1;
+    return ret;
+}
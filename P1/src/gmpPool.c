@@ -0,0 +1,136 @@
+#include "gmpPool.h"
+#include <gmp.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct Libre {
+    struct Libre *sig;
+} Libre;
+
+// Las losas se encadenan por su primer hueco para liberarlas al final
+typedef struct Losa {
+    struct Losa *sig;
+    _Alignas(16) char datos[];
+} Losa;
+
+typedef struct {
+    Libre *libres[GMP_POOL_CLASES];
+    char *resto; // lo que queda sin partir de la losa actual
+    size_t queda;
+} PoolHilo;
+
+static _Thread_local PoolHilo pool;
+static Losa *losas = NULL;
+static pthread_mutex_t losas_mu = PTHREAD_MUTEX_INITIALIZER;
+static atomic_int activo;
+static atomic_ullong n_peticiones, n_mallocs, n_reutilizados;
+
+static inline void contar(atomic_ullong *c) {
+    atomic_fetch_add_explicit(c, 1, memory_order_relaxed);
+}
+
+static inline int clase(size_t n) {
+    if (n <= GMP_POOL_MIN) return 0;
+    return (int)(sizeof(unsigned long) * 8 - (size_t)__builtin_clzl(n - 1)) - 4; // ceil(log2 n) - log2 16
+}
+
+static void *sin_memoria(size_t n) {
+    fprintf(stderr, "GMP: sin memoria para %zu bytes\n", n);
+    abort();
+}
+
+static void *reservar(size_t n) {
+    if (n > GMP_POOL_MAX) {
+        contar(&n_mallocs);
+        void *p = malloc(n);
+        return p ? p : sin_memoria(n);
+    }
+    int c = clase(n);
+    Libre *l = pool.libres[c];
+    if (l) {
+        pool.libres[c] = l->sig;
+        contar(&n_reutilizados);
+        return l;
+    }
+    size_t tam = (size_t)GMP_POOL_MIN << c;
+    if (pool.queda < tam) {
+        contar(&n_mallocs);
+        Losa *s = malloc(sizeof(Losa) + GMP_POOL_LOSA);
+        if (!s) return sin_memoria(GMP_POOL_LOSA);
+        pthread_mutex_lock(&losas_mu);
+        s->sig = losas;
+        losas = s;
+        pthread_mutex_unlock(&losas_mu);
+        pool.resto = s->datos;
+        pool.queda = GMP_POOL_LOSA;
+    }
+    void *p = pool.resto;
+    pool.resto += tam;
+    pool.queda -= tam;
+    return p;
+}
+
+static void liberar(void *p, size_t n) {
+    if (n > GMP_POOL_MAX) {
+        free(p);
+        return;
+    }
+    int c = clase(n);
+    Libre *l = p;
+    l->sig = pool.libres[c];
+    pool.libres[c] = l;
+}
+
+static void *pool_reservar(size_t n) {
+    contar(&n_peticiones);
+    return reservar(n);
+}
+
+static void *pool_redimensionar(void *p, size_t viejo, size_t nuevo) {
+    contar(&n_peticiones);
+    if (viejo > GMP_POOL_MAX && nuevo > GMP_POOL_MAX) {
+        contar(&n_mallocs);
+        void *q = realloc(p, nuevo);
+        return q ? q : sin_memoria(nuevo);
+    }
+    // Misma clase: el bloque ya tiene sitio
+    if (viejo <= GMP_POOL_MAX && nuevo <= GMP_POOL_MAX && clase(viejo) == clase(nuevo)) return p;
+    void *q = reservar(nuevo);
+    memcpy(q, p, viejo < nuevo ? viejo : nuevo);
+    liberar(p, viejo);
+    return q;
+}
+
+static void pool_liberar(void *p, size_t n) {
+    contar(&n_peticiones);
+    liberar(p, n);
+}
+
+void gmp_pool_instalar(void) {
+    mp_set_memory_functions(pool_reservar, pool_redimensionar, pool_liberar);
+    atomic_store(&activo, 1);
+}
+
+int gmp_pool_activo(void) {
+    return atomic_load(&activo);
+}
+
+void gmp_pool_estad(GmpPoolEstad *st) {
+    st->peticiones = atomic_load_explicit(&n_peticiones, memory_order_relaxed);
+    st->mallocs = atomic_load_explicit(&n_mallocs, memory_order_relaxed);
+    st->reutilizados = atomic_load_explicit(&n_reutilizados, memory_order_relaxed);
+}
+
+void gmp_pool_liberar(void) {
+    pthread_mutex_lock(&losas_mu);
+    while (losas) {
+        Losa *s = losas;
+        losas = s->sig;
+        free(s);
+    }
+    pthread_mutex_unlock(&losas_mu);
+    memset(&pool, 0, sizeof(pool));
+}
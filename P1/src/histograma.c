@@ -0,0 +1,75 @@
+#include "histograma.h"
+#include <string.h>
+
+#define HIST_CASILLAS 27 // 26 letras + descarte
+#define HIST_SUB 4       // sub-histogramas intercalados
+
+/* Byte -> casilla (0 = no es letra, 1..26 = A..Z) */
+#define L(x) [x] = x - 'A' + 1
+static const unsigned char CASILLA[256] = {
+    L('A'), L('B'), L('C'), L('D'), L('E'), L('F'), L('G'), L('H'), L('I'),
+    L('J'), L('K'), L('L'), L('M'), L('N'), L('O'), L('P'), L('Q'), L('R'),
+    L('S'), L('T'), L('U'), L('V'), L('W'), L('X'), L('Y'), L('Z'),
+};
+#undef L
+
+static size_t juntar(uint32_t sub[HIST_SUB][HIST_CASILLAS], uint32_t hist[26]) {
+    size_t n = 0;
+    for (int c = 0; c < 26; ++c) {
+        hist[c] = sub[0][c + 1] + sub[1][c + 1] + sub[2][c + 1] + sub[3][c + 1];
+        n += hist[c];
+    }
+    return n;
+}
+
+size_t hist_letras(const char *text, size_t len, uint32_t hist[26]) {
+    return hist_columna(text, len, 0, 1, hist);
+}
+
+size_t hist_columna(const char *text, size_t len, size_t inicio, size_t paso, uint32_t hist[26]) {
+    uint32_t sub[HIST_SUB][HIST_CASILLAS];
+    memset(sub, 0, sizeof(sub));
+    const unsigned char *t = (const unsigned char *)text;
+    size_t i = inicio, salto = HIST_SUB * paso;
+
+    // Cuatro letras por vuelta, cada una en su sub-histograma
+    for (; len >= salto && i < len - salto + paso; i += salto) {
+        sub[0][CASILLA[t[i]]]++;
+        sub[1][CASILLA[t[i + paso]]]++;
+        sub[2][CASILLA[t[i + 2 * paso]]]++;
+        sub[3][CASILLA[t[i + 3 * paso]]]++;
+    }
+    for (; i < len; i += paso) sub[0][CASILLA[t[i]]]++;
+    return juntar(sub, hist);
+}
+
+void hist_columnas(const char *text, size_t len, int n, int fase, uint32_t (*hist)[26]) {
+    if (n == 1) {
+        hist_letras(text, len, hist[0]);
+        return;
+    }
+    // Con n >= 2 dos letras seguidas ya van a columnas distintas
+    uint32_t loc[n][HIST_CASILLAS];
+    memset(loc, 0, sizeof(loc));
+    const unsigned char *t = (const unsigned char *)text;
+    int col = fase % n;
+    for (size_t i = 0; i < len; ++i) {
+        loc[col][CASILLA[t[i]]]++;
+        if (++col == n) col = 0;
+    }
+    for (int k = 0; k < n; ++k) memcpy(hist[k], loc[k] + 1, 26 * sizeof(uint32_t));
+}
+
+void pesos26(const double P[26], uint32_t w[26]) {
+    for (int j = 0; j < 26; ++j) w[j] = (uint32_t)(P[j] * 65536.0 + 0.5);
+}
+
+void correlacion26(const uint64_t f[26], const uint32_t w[26], uint64_t out[26]) {
+    uint64_t f2[52];
+    for (int j = 0; j < 26; ++j) f2[j] = f2[j + 26] = f[j];
+    for (int k = 0; k < 26; ++k) {
+        uint64_t s = 0;
+        for (int j = 0; j < 26; ++j) s += w[j] * f2[j + k];
+        out[k] = s;
+    }
+}
@@ -0,0 +1,79 @@
+#include "indice.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int indice_crear(IndiceEscritor *ix, const char *ruta) {
+    memset(ix, 0, sizeof(*ix));
+    if (!ruta) return 0;
+    ix->f = fopen(ruta, "wb");
+    if (!ix->f) { perror(ruta); return -1; }
+    memcpy(ix->cab.magic, INDICE_MAGIC, sizeof(INDICE_MAGIC));
+    ix->cab.version = INDICE_VERSION;
+    ix->cab.paso = INDICE_PASO;
+    PuntoControl p0 = {0, 0};
+    ix->siguiente = INDICE_PASO;
+    if (fwrite(&ix->cab, sizeof(ix->cab), 1, ix->f) != 1 || fwrite(&p0, sizeof(p0), 1, ix->f) != 1) {
+        fclose(ix->f);
+        ix->f = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void indice_anotar(IndiceEscritor *ix, uint64_t byte, uint64_t letras) {
+    if (!ix->f || byte < ix->siguiente) return;
+    PuntoControl p = {byte, letras};
+    fwrite(&p, sizeof(p), 1, ix->f);
+    ix->siguiente = byte + INDICE_PASO;
+}
+
+int indice_cerrar(IndiceEscritor *ix, uint64_t bytes, uint64_t letras) {
+    if (!ix->f) return 0;
+    ix->cab.bytes = bytes;
+    ix->cab.letras = letras;
+    int ok = fseek(ix->f, 0, SEEK_SET) == 0 && fwrite(&ix->cab, sizeof(ix->cab), 1, ix->f) == 1;
+    if (fclose(ix->f) != 0) ok = 0;
+    ix->f = NULL;
+    return ok ? 0 : -1;
+}
+
+int indice_buscar(const char *ruta, uint64_t bytes, uint64_t offset, PuntoControl *p) {
+    p->byte = p->letras = 0;
+    if (!ruta) return -1;
+    int fd = open(ruta, O_RDONLY);
+    if (fd < 0) { perror(ruta); return -1; }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(IndiceCab) + sizeof(PuntoControl)) {
+        close(fd);
+        return -1;
+    }
+    size_t tam = (size_t)st.st_size;
+    void *map = mmap(NULL, tam, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const IndiceCab *cab = map;
+    int r = -1;
+    if (memcmp(cab->magic, INDICE_MAGIC, sizeof(INDICE_MAGIC)) != 0 || cab->version != INDICE_VERSION) {
+        fprintf(stderr, "Aviso: %s no es un índice válido; se recorre desde el principio\n", ruta);
+    } else if (cab->bytes != bytes) {
+        fprintf(stderr, "Aviso: %s es de otro cifrado (%llu bytes, no %llu); se recorre desde el principio\n",
+                ruta, (unsigned long long)cab->bytes, (unsigned long long)bytes);
+    } else {
+        // Búsqueda binaria del último punto con byte <= offset
+        const PuntoControl *pc = (const PuntoControl *)(cab + 1);
+        size_t lo = 0, hi = (tam - sizeof(IndiceCab)) / sizeof(PuntoControl);
+        while (hi - lo > 1) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (pc[mid].byte <= offset) lo = mid;
+            else hi = mid;
+        }
+        *p = pc[lo];
+        r = 0;
+    }
+    munmap(map, tam);
+    return r;
+}
@@ -0,0 +1,179 @@
+#include "instr.h"
+
+#ifdef CRIPTO_INSTR
+
+#include <gmp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+typedef struct {
+    unsigned long long llamadas;
+    unsigned long long letras;
+    unsigned long long ciclos;
+    unsigned long long ns;
+} InstrEstadoEtapa;
+
+unsigned long long instr_contadores[INSTR_N_CONTADORES];
+static InstrEstadoEtapa etapas[INSTR_N_ETAPAS];
+
+static const char *NOMBRE_CONTADOR[INSTR_N_CONTADORES] = {
+    "bytes leidos", "letras ASCII", "letras UTF-8", "descarte ASCII",
+    "descarte UTF-8", "descarte otro", "bloques", "letras de relleno",
+    "reservas GMP",
+};
+static const char *NOMBRE_ETAPA[INSTR_N_ETAPAS] = {
+    "lectura", "normalizar", "afin", "bloques", "vigenere",
+    "columnas", "kasiski", "escritura",
+};
+
+static unsigned long long ahora_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static unsigned long long ciclos(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return ahora_ns(); // sin contador de ciclos: se usan ns
+#endif
+}
+
+InstrMarca instr_marca(void) {
+    InstrMarca m = { ciclos(), ahora_ns() };
+    return m;
+}
+
+void instr_etapa(InstrEtapa e, InstrMarca desde, unsigned long long letras) {
+    unsigned long long c = ciclos() - desde.ciclos;
+    unsigned long long ns = ahora_ns() - desde.t0_ns;
+    __atomic_fetch_add(&etapas[e].llamadas, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&etapas[e].letras, letras, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&etapas[e].ciclos, c, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&etapas[e].ns, ns, __ATOMIC_RELAXED);
+}
+
+/* ---------- Volcado (solo write(): se puede llamar desde el manejador) ---------- */
+
+typedef struct {
+    char buf[4096];
+    size_t len;
+} Salida;
+
+static void poner(Salida *s, const char *txt) {
+    size_t n = strlen(txt);
+    if (s->len >= sizeof(s->buf)) return;
+    size_t libre = sizeof(s->buf) - s->len;
+    if (n > libre) n = libre;
+    memcpy(s->buf + s->len, txt, n);
+    s->len += n;
+}
+
+/* Entero sin signo alineado a la derecha en `ancho` columnas */
+static void poner_u(Salida *s, unsigned long long v, int ancho) {
+    char tmp[24];
+    int n = 0;
+    do { tmp[n++] = (char)('0' + v % 10); v /= 10; } while (v);
+    while (ancho-- > n) poner(s, " ");
+    char num[24];
+    for (int i = 0; i < n; i++) num[i] = tmp[n - 1 - i];
+    num[n] = '\0';
+    poner(s, num);
+}
+
+/* Cociente a/b con dos decimales */
+static void poner_ratio(Salida *s, unsigned long long a, unsigned long long b, int ancho) {
+    if (b == 0) { poner_u(s, 0, ancho - 3); poner(s, ".00"); return; }
+    unsigned long long x = (a * 100 + b / 2) / b;
+    poner_u(s, x / 100, ancho - 3);
+    poner(s, ".");
+    poner_u(s, (x / 10) % 10, 1);
+    poner_u(s, x % 10, 1);
+}
+
+static void poner_texto(Salida *s, const char *txt, int ancho) {
+    poner(s, txt);
+    for (int n = (int)strlen(txt); n < ancho; n++) poner(s, " ");
+}
+
+void instr_volcar(void) {
+    Salida s;
+    s.len = 0;
+    poner(&s, "\n=== Instrumentacion ===\n");
+    for (int i = 0; i < INSTR_N_CONTADORES; i++) {
+        poner(&s, "  ");
+        poner_texto(&s, NOMBRE_CONTADOR[i], 20);
+        poner_u(&s, __atomic_load_n(&instr_contadores[i], __ATOMIC_RELAXED), 14);
+        poner(&s, "\n");
+    }
+    poner(&s, "  etapa          llamadas        letras          ciclos            ns   ciclos/letra  ns/letra\n");
+    for (int e = 0; e < INSTR_N_ETAPAS; e++) {
+        InstrEstadoEtapa t = etapas[e];
+        if (t.llamadas == 0) continue;
+        poner(&s, "  ");
+        poner_texto(&s, NOMBRE_ETAPA[e], 12);
+        poner_u(&s, t.llamadas, 10);
+        poner_u(&s, t.letras, 14);
+        poner_u(&s, t.ciclos, 16);
+        poner_u(&s, t.ns, 14);
+        poner_ratio(&s, t.ciclos, t.letras, 15);
+        poner_ratio(&s, t.ns, t.letras, 10);
+        poner(&s, "\n");
+    }
+    ssize_t r = write(STDERR_FILENO, s.buf, s.len);
+    (void)r;
+}
+
+/* Al salir, primero se vacía stdout para no mezclar el volcado con la salida */
+static void instr_salida(void) {
+    fflush(stdout);
+    instr_volcar();
+}
+
+static void manejador_usr1(int sig) {
+    (void)sig;
+    instr_volcar();
+}
+
+/* ---------- Contador de reservas de GMP ---------- */
+
+static void *(*gmp_alloc_orig)(size_t);
+static void *(*gmp_realloc_orig)(void *, size_t, size_t);
+
+static void *gmp_alloc_contado(size_t n) {
+    INSTR_SUMAR(INSTR_GMP_RESERVAS, 1);
+    return gmp_alloc_orig(n);
+}
+
+static void *gmp_realloc_contado(void *p, size_t viejo, size_t nuevo) {
+    INSTR_SUMAR(INSTR_GMP_RESERVAS, 1);
+    return gmp_realloc_orig(p, viejo, nuevo);
+}
+
+__attribute__((constructor))
+static void instr_init(void) {
+    void (*libera)(void *, size_t);
+    mp_get_memory_functions(&gmp_alloc_orig, &gmp_realloc_orig, &libera);
+    mp_set_memory_functions(gmp_alloc_contado, gmp_realloc_contado, libera);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = manejador_usr1;
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &sa, NULL);
+    atexit(instr_salida);
+}
+
+#else
+
+/* Sin CRIPTO_INSTR la unidad queda vacía */
+typedef int instr_vacio;
+
+#endif
@@ -0,0 +1,539 @@
+#define _GNU_SOURCE
+#include "ioAsincrona.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* ---------- io_uring mínimo (sin liburing) ---------- */
+
+typedef struct {
+    int fd;
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_map, *cq_map;
+    size_t sq_tam, cq_tam, sqes_tam;
+} Anillo;
+
+static int anillo_crear(Anillo *r, unsigned entradas) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(r, 0, sizeof(*r));
+    r->fd = (int)syscall(__NR_io_uring_setup, entradas, &p);
+    if (r->fd < 0) return -1;
+
+    r->sq_tam = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_tam = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    int unico = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (unico) {
+        if (r->cq_tam > r->sq_tam) r->sq_tam = r->cq_tam;
+        r->cq_tam = r->sq_tam;
+    }
+    r->sqes_tam = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    r->sq_map = mmap(NULL, r->sq_tam, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd,
+                     IORING_OFF_SQ_RING);
+    r->cq_map = unico || r->sq_map == MAP_FAILED
+                    ? r->sq_map
+                    : mmap(NULL, r->cq_tam, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd,
+                           IORING_OFF_CQ_RING);
+    r->sqes = mmap(NULL, r->sqes_tam, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd,
+                   IORING_OFF_SQES);
+    if (r->sq_map == MAP_FAILED || r->cq_map == MAP_FAILED || r->sqes == MAP_FAILED) {
+        if (r->sqes != MAP_FAILED) munmap(r->sqes, r->sqes_tam);
+        if (r->cq_map != MAP_FAILED && r->cq_map != r->sq_map) munmap(r->cq_map, r->cq_tam);
+        if (r->sq_map != MAP_FAILED) munmap(r->sq_map, r->sq_tam);
+        close(r->fd);
+        return -1;
+    }
+
+    char *sq = r->sq_map, *cq = r->cq_map;
+    r->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    r->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned *)(sq + p.sq_off.array);
+    r->cq_head = (unsigned *)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    r->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 0;
+}
+
+static void anillo_destruir(Anillo *r) {
+    munmap(r->sqes, r->sqes_tam);
+    if (r->cq_map != r->sq_map) munmap(r->cq_map, r->cq_tam);
+    munmap(r->sq_map, r->sq_tam);
+    close(r->fd);
+}
+
+/* Encola y manda una lectura o escritura (off = -1: posición actual del fd) */
+static int anillo_pedir(Anillo *r, int op, int fd, void *buf, size_t len, off_t off, uint64_t dato) {
+    unsigned cola = *r->sq_tail; // solo hay un productor
+    unsigned i = cola & *r->sq_mask;
+    struct io_uring_sqe *s = &r->sqes[i];
+    memset(s, 0, sizeof(*s));
+    s->opcode = (uint8_t)op;
+    s->fd = fd;
+    s->addr = (uint64_t)(uintptr_t)buf;
+    s->len = (uint32_t)len;
+    s->off = (uint64_t)off;
+    s->user_data = dato;
+    r->sq_array[i] = i;
+    __atomic_store_n(r->sq_tail, cola + 1, __ATOMIC_RELEASE);
+    for (;;) {
+        long n = syscall(__NR_io_uring_enter, r->fd, 1, 0, 0, NULL, 0);
+        if (n == 1) return 0;
+        if (n < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) return -1;
+    }
+}
+
+/* Espera a que termine una operación */
+static int anillo_esperar(Anillo *r, uint64_t *dato, int *res) {
+    for (;;) {
+        unsigned cab = *r->cq_head;
+        if (cab != __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) {
+            const struct io_uring_cqe *c = &r->cqes[cab & *r->cq_mask];
+            *dato = c->user_data;
+            *res = c->res;
+            __atomic_store_n(r->cq_head, cab + 1, __ATOMIC_RELEASE);
+            return 0;
+        }
+        if (syscall(__NR_io_uring_enter, r->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+            return -1;
+    }
+}
+
+/* ---------- Estado común ---------- */
+
+enum { LIBRE, EN_VUELO, LISTO };
+
+typedef struct {
+    unsigned char *buf;
+    int estado;
+    size_t len;   // bytes leídos / por escribir
+    size_t hecho; // bytes ya escritos (escrituras cortas)
+    off_t off;
+} Trozo;
+
+/* Ficheros regulares: por desplazamiento, desde la posición actual */
+static int posicional(int fd, off_t *off) {
+    struct stat st;
+    int fl = fcntl(fd, F_GETFL);
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || fl < 0 || (fl & O_APPEND)) return 0;
+    *off = lseek(fd, 0, SEEK_CUR);
+    return *off >= 0;
+}
+
+static Trozo *trozos_crear(int n, size_t tam) {
+    Trozo *t = calloc((size_t)n, sizeof(Trozo));
+    for (int i = 0; t && i < n; ++i)
+        if (!(t[i].buf = aligned_alloc(ES_ALINEAR, tam))) {
+            while (i--) free(t[i].buf);
+            free(t);
+            return NULL;
+        }
+    return t;
+}
+
+static void trozos_liberar(Trozo *t, int n) {
+    for (int i = 0; i < n; ++i) free(t[i].buf);
+    free(t);
+}
+
+static size_t redondear(size_t tam) {
+    return (tam + ES_ALINEAR - 1) / ES_ALINEAR * ES_ALINEAR;
+}
+
+static int usar_uring(EsMotor motor, Anillo *r, int n) {
+    if (motor == ES_HILOS) return 0;
+    if (anillo_crear(r, (unsigned)n) == 0) return 1;
+    if (motor == ES_URING) fprintf(stderr, "Aviso: io_uring no disponible, se usan hilos\n");
+    return 0;
+}
+
+/* ---------- Lector ---------- */
+
+struct EsLector {
+    int fd, n, posicional, uring, fin, error, prestado, en_vuelo, flags;
+    size_t tam;
+    off_t off;                     // siguiente desplazamiento a pedir
+    unsigned pedidos, consumidos;  // números de trozo
+    Trozo *t;
+    Anillo r;
+    pthread_t hilo;
+    pthread_mutex_t mx;
+    pthread_cond_t cv;
+    int parar;
+};
+
+/* Hay sitio para pedir otro trozo (el prestado sigue ocupado) */
+static int lector_cabe(const EsLector *l) {
+    return !l->fin && l->pedidos - l->consumidos < (unsigned)(l->n - l->prestado);
+}
+
+static void lector_lanzar(EsLector *l) {
+    while (lector_cabe(l) && !l->error && (l->posicional || l->en_vuelo == 0)) {
+        Trozo *c = &l->t[l->pedidos % (unsigned)l->n];
+        c->off = l->posicional ? l->off : -1;
+        c->estado = EN_VUELO;
+        if (anillo_pedir(&l->r, IORING_OP_READ, l->fd, c->buf, l->tam, c->off, l->pedidos % (unsigned)l->n) < 0) {
+            l->error = errno;
+            return;
+        }
+        if (l->posicional) l->off += (off_t)l->tam;
+        l->pedidos++;
+        l->en_vuelo++;
+    }
+}
+
+static void lector_completar(EsLector *l) {
+    uint64_t i;
+    int res;
+    if (anillo_esperar(&l->r, &i, &res) < 0) {
+        l->error = errno;
+        return;
+    }
+    Trozo *c = &l->t[i];
+    if (res == -EINTR || res == -EAGAIN) {
+        if (anillo_pedir(&l->r, IORING_OP_READ, l->fd, c->buf, l->tam, c->off, i) < 0) l->error = errno;
+        return;
+    }
+    l->en_vuelo--;
+    if (res < 0) {
+        l->error = -res;
+        return;
+    }
+    c->len = (size_t)res;
+    c->estado = LISTO;
+    if (res == 0 || (l->posicional && (size_t)res < l->tam)) l->fin = 1;
+    lector_lanzar(l);
+}
+
+static void *lector_hilo(void *arg) {
+    EsLector *l = arg;
+    pthread_mutex_lock(&l->mx);
+    for (;;) {
+        while (!l->parar && !l->error && !lector_cabe(l)) pthread_cond_wait(&l->cv, &l->mx);
+        if (l->parar || l->error || l->fin) break;
+        Trozo *c = &l->t[l->pedidos % (unsigned)l->n];
+        off_t off = l->off;
+        c->estado = EN_VUELO;
+        l->pedidos++;
+        if (l->posicional) l->off += (off_t)l->tam;
+        pthread_mutex_unlock(&l->mx);
+
+        ssize_t got;
+        do got = l->posicional ? pread(l->fd, c->buf, l->tam, off) : read(l->fd, c->buf, l->tam);
+        while (got < 0 && errno == EINTR);
+
+        pthread_mutex_lock(&l->mx);
+        if (got < 0) {
+            l->error = errno;
+        } else {
+            c->len = (size_t)got;
+            c->estado = LISTO;
+            if (got == 0 || (l->posicional && (size_t)got < l->tam)) l->fin = 1;
+        }
+        pthread_cond_broadcast(&l->cv);
+    }
+    pthread_mutex_unlock(&l->mx);
+    return NULL;
+}
+
+/* O_DIRECT en la entrada: desplazamientos, tamaños y búferes ya están alineados */
+static void lector_directo(EsLector *l) {
+    l->flags = fcntl(l->fd, F_GETFL);
+    if (!l->posicional || l->off % ES_ALINEAR || l->flags < 0 ||
+        fcntl(l->fd, F_SETFL, l->flags | O_DIRECT) < 0) {
+        fprintf(stderr, "Aviso: la entrada no admite O_DIRECT, se lee con caché\n");
+        l->flags = -1;
+    }
+}
+
+EsLector *es_lector_abrir(int fd, const EsOpciones *op) {
+    EsLector *l = calloc(1, sizeof(EsLector));
+    if (!l) return NULL;
+    l->fd = fd;
+    l->n = op && op->nbufs > 0 ? op->nbufs : ES_BUFS;
+    if (l->n < 2) l->n = 2;
+    l->tam = redondear(op && op->tam_buf ? op->tam_buf : ES_TAM_BUF);
+    l->flags = -1;
+    l->posicional = posicional(fd, &l->off);
+    if (op && op->directo) lector_directo(l);
+    if (!(l->t = trozos_crear(l->n, l->tam))) {
+        fprintf(stderr, "Error: sin memoria para %d búferes de lectura de %zu bytes\n", l->n, l->tam);
+        if (l->flags >= 0) fcntl(fd, F_SETFL, l->flags);
+        free(l);
+        return NULL;
+    }
+    l->uring = usar_uring(op ? op->motor : ES_AUTO, &l->r, l->n);
+    if (l->uring) {
+        lector_lanzar(l);
+    } else {
+        pthread_mutex_init(&l->mx, NULL);
+        pthread_cond_init(&l->cv, NULL);
+        int rc = pthread_create(&l->hilo, NULL, lector_hilo, l);
+        if (rc != 0) {
+            fprintf(stderr, "Error: no se pudo arrancar el hilo de lectura: %s\n", strerror(rc));
+            pthread_mutex_destroy(&l->mx);
+            pthread_cond_destroy(&l->cv);
+            if (l->flags >= 0) fcntl(fd, F_SETFL, l->flags);
+            trozos_liberar(l->t, l->n);
+            free(l);
+            return NULL;
+        }
+    }
+    return l;
+}
+
+ssize_t es_lector_siguiente(EsLector *l, const unsigned char **datos) {
+    unsigned n = (unsigned)l->n;
+    Trozo *c = &l->t[l->consumidos % n];
+    if (l->uring) {
+        if (l->prestado) {
+            l->t[(l->consumidos - 1) % n].estado = LIBRE;
+            l->prestado = 0;
+        }
+        lector_lanzar(l);
+        while (c->estado != LISTO && !l->error) {
+            if (c->estado == LIBRE) return 0; // no se pidió: ya se llegó al final
+            lector_completar(l);
+        }
+        if (l->error) {
+            errno = l->error;
+            return -1;
+        }
+        l->consumidos++;
+        l->prestado = 1;
+        *datos = c->buf;
+        return (ssize_t)c->len;
+    }
+
+    pthread_mutex_lock(&l->mx);
+    if (l->prestado) {
+        l->t[(l->consumidos - 1) % n].estado = LIBRE;
+        l->prestado = 0;
+        pthread_cond_broadcast(&l->cv);
+    }
+    while (c->estado != LISTO && !l->error && !(c->estado == LIBRE && l->fin))
+        pthread_cond_wait(&l->cv, &l->mx);
+    ssize_t r = l->error ? -1 : c->estado == LISTO ? (ssize_t)c->len : 0;
+    if (l->error) errno = l->error;
+    if (c->estado == LISTO && !l->error) {
+        l->consumidos++;
+        l->prestado = 1;
+        *datos = c->buf;
+        pthread_cond_broadcast(&l->cv);
+    }
+    pthread_mutex_unlock(&l->mx);
+    return r;
+}
+
+size_t es_lector_tam(const EsLector *l) {
+    return l->tam;
+}
+
+const char *es_lector_motor(const EsLector *l) {
+    return l->uring ? "io_uring" : "hilos";
+}
+
+void es_lector_cerrar(EsLector *l) {
+    if (!l) return;
+    if (l->uring) {
+        while (l->en_vuelo > 0) { // no se liberan búferes que el núcleo aún usa
+            uint64_t i;
+            int res;
+            if (anillo_esperar(&l->r, &i, &res) < 0) break;
+            l->en_vuelo--;
+        }
+        anillo_destruir(&l->r);
+    } else {
+        pthread_mutex_lock(&l->mx);
+        l->parar = 1;
+        pthread_cond_broadcast(&l->cv);
+        pthread_mutex_unlock(&l->mx);
+        pthread_join(l->hilo, NULL);
+        pthread_mutex_destroy(&l->mx);
+        pthread_cond_destroy(&l->cv);
+    }
+    if (l->flags >= 0) fcntl(l->fd, F_SETFL, l->flags);
+    trozos_liberar(l->t, l->n);
+    free(l);
+}
+
+/* ---------- Escritor ---------- */
+
+struct EsEscritor {
+    int fd, n, posicional, uring, error, en_vuelo;
+    size_t tam;
+    off_t off;                              // desplazamiento del siguiente trozo
+    unsigned llenos, mandados, escritos;    // números de trozo
+    Trozo *t;
+    Anillo r;
+    pthread_t hilo;
+    pthread_mutex_t mx;
+    pthread_cond_t cv;
+    int parar;
+};
+
+static int escritor_pedir(EsEscritor *e, unsigned i) {
+    Trozo *c = &e->t[i];
+    off_t off = e->posicional ? c->off + (off_t)c->hecho : -1;
+    if (anillo_pedir(&e->r, IORING_OP_WRITE, e->fd, c->buf + c->hecho, c->len - c->hecho, off, i) < 0) {
+        e->error = errno;
+        return -1;
+    }
+    return 0;
+}
+
+static void escritor_lanzar(EsEscritor *e) {
+    while (e->mandados != e->llenos && !e->error && (e->posicional || e->en_vuelo == 0)) {
+        if (escritor_pedir(e, e->mandados % (unsigned)e->n) < 0) return;
+        e->mandados++;
+        e->en_vuelo++;
+    }
+}
+
+static void escritor_completar(EsEscritor *e) {
+    uint64_t i;
+    int res;
+    if (anillo_esperar(&e->r, &i, &res) < 0) {
+        e->error = errno;
+        e->en_vuelo = 0;
+        return;
+    }
+    Trozo *c = &e->t[i];
+    if (res > 0) c->hecho += (size_t)res;
+    if ((res == -EINTR || res == -EAGAIN || (res > 0 && c->hecho < c->len)) && !e->error &&
+        escritor_pedir(e, (unsigned)i) == 0)
+        return; // sigue en vuelo con lo que falta
+    if (res < 0 && !e->error) e->error = -res;
+    if (res == 0) e->error = EIO;
+    c->estado = LIBRE;
+    e->en_vuelo--;
+    e->escritos++;
+    escritor_lanzar(e);
+}
+
+static void *escritor_hilo(void *arg) {
+    EsEscritor *e = arg;
+    pthread_mutex_lock(&e->mx);
+    for (;;) {
+        while (!e->parar && e->mandados == e->llenos) pthread_cond_wait(&e->cv, &e->mx);
+        if (e->mandados == e->llenos) break; // parar y ya no queda nada
+        Trozo *c = &e->t[e->mandados % (unsigned)e->n];
+        int error = e->error;
+        pthread_mutex_unlock(&e->mx);
+
+        while (!error && c->hecho < c->len) {
+            ssize_t w = e->posicional ? pwrite(e->fd, c->buf + c->hecho, c->len - c->hecho, c->off + (off_t)c->hecho)
+                                      : write(e->fd, c->buf + c->hecho, c->len - c->hecho);
+            if (w > 0) c->hecho += (size_t)w;
+            else if (w == 0) error = EIO;
+            else if (errno != EINTR) error = errno;
+        }
+
+        pthread_mutex_lock(&e->mx);
+        if (error) e->error = error;
+        c->estado = LIBRE;
+        e->mandados++;
+        e->escritos++;
+        pthread_cond_broadcast(&e->cv);
+    }
+    pthread_mutex_unlock(&e->mx);
+    return NULL;
+}
+
+EsEscritor *es_escritor_abrir(int fd, const EsOpciones *op, size_t tam) {
+    EsEscritor *e = calloc(1, sizeof(EsEscritor));
+    if (!e) return NULL;
+    e->fd = fd;
+    e->n = op && op->nbufs > 0 ? op->nbufs : ES_BUFS;
+    if (e->n < 2) e->n = 2;
+    e->tam = redondear(tam);
+    e->posicional = posicional(fd, &e->off);
+    if (!(e->t = trozos_crear(e->n, e->tam))) {
+        fprintf(stderr, "Error: sin memoria para %d búferes de escritura de %zu bytes\n", e->n, e->tam);
+        free(e);
+        return NULL;
+    }
+    e->uring = usar_uring(op ? op->motor : ES_AUTO, &e->r, e->n);
+    if (!e->uring) {
+        pthread_mutex_init(&e->mx, NULL);
+        pthread_cond_init(&e->cv, NULL);
+        int rc = pthread_create(&e->hilo, NULL, escritor_hilo, e);
+        if (rc != 0) {
+            fprintf(stderr, "Error: no se pudo arrancar el hilo de escritura: %s\n", strerror(rc));
+            pthread_mutex_destroy(&e->mx);
+            pthread_cond_destroy(&e->cv);
+            trozos_liberar(e->t, e->n);
+            free(e);
+            return NULL;
+        }
+    }
+    return e;
+}
+
+unsigned char *es_escritor_buffer(EsEscritor *e) {
+    Trozo *c = &e->t[e->llenos % (unsigned)e->n];
+    if (e->uring) {
+        while (c->estado != LIBRE && e->en_vuelo > 0) escritor_completar(e);
+    } else {
+        pthread_mutex_lock(&e->mx);
+        while (c->estado != LIBRE) pthread_cond_wait(&e->cv, &e->mx);
+        pthread_mutex_unlock(&e->mx);
+    }
+    return c->buf;
+}
+
+void es_escritor_enviar(EsEscritor *e, size_t n) {
+    if (n == 0) return;
+    Trozo *c = &e->t[e->llenos % (unsigned)e->n];
+    c->len = n;
+    c->hecho = 0;
+    c->off = e->off;
+    e->off += (off_t)n;
+    c->estado = EN_VUELO;
+    if (e->uring) {
+        e->llenos++;
+        escritor_lanzar(e);
+    } else {
+        pthread_mutex_lock(&e->mx);
+        e->llenos++;
+        pthread_cond_broadcast(&e->cv);
+        pthread_mutex_unlock(&e->mx);
+    }
+}
+
+int es_escritor_cerrar(EsEscritor *e) {
+    if (!e) return -1;
+    if (e->uring) {
+        while (e->escritos != e->llenos && !e->error) escritor_completar(e);
+        while (e->en_vuelo > 0) escritor_completar(e); // tras un error, solo se recoge
+        anillo_destruir(&e->r);
+    } else {
+        pthread_mutex_lock(&e->mx);
+        e->parar = 1;
+        pthread_cond_broadcast(&e->cv);
+        pthread_mutex_unlock(&e->mx);
+        pthread_join(e->hilo, NULL);
+        pthread_mutex_destroy(&e->mx);
+        pthread_cond_destroy(&e->cv);
+    }
+    // Deja el fd donde lo habría dejado write (para quien siga escribiendo)
+    if (e->posicional) lseek(e->fd, e->off, SEEK_SET);
+    int r = e->error ? -1 : 0;
+    if (e->error) errno = e->error;
+    trozos_liberar(e->t, e->n);
+    free(e);
+    return r;
+}
@@ -0,0 +1,263 @@
+#include "kasiskiExterno.h"
+#include "criptoAnalisisVigenere.h"
+#include "instr.h"
+#include "normalizar.h"
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define KEXT_BLOQUE 65536   // bytes de la entrada normalizados de cada vez
+#define KEXT_NGRAM 3
+#define KEXT_VENTANA MAX_TEXT // letras de cada ventana de votos (lo que analiza kasiski())
+
+/* Búfer de escritura de una partición y su temporal */
+typedef struct {
+    int fd;
+    uint64_t *buf;
+    size_t n, cap;      // registros en el búfer y capacidad
+    uint64_t registros; // registros ya volcados
+} Particion;
+
+/* Reparto de las particiones entre los hilos */
+typedef struct {
+    Particion *part;
+    int np;
+    uint64_t len;       // letras de todo el texto
+    size_t cap_lectura; // registros por lectura de cada hilo
+    atomic_int siguiente;
+    atomic_int error;
+    // Por trigrama (cada partición toca solo su rango): apariciones en todo el
+    // texto, MCD en la primera ventana (para el informe) y, en la ventana en
+    // curso, su número, la primera posición, las apariciones y el MCD
+    uint64_t *cuenta, *mcds;
+    uint64_t *ventana, *base, *n_ventana, *g_ventana;
+    atomic_int votos[MAX_K_CAND + 1];
+} Trabajo;
+
+static uint64_t mcd64(uint64_t a, uint64_t b) {
+    while (b) {
+        uint64_t t = b;
+        b = a % b;
+        a = t;
+    }
+    return a;
+}
+
+// Temporal ya borrado del directorio: desaparece solo al cerrarlo
+static int temporal(void) {
+    const char *dir = getenv("TMPDIR");
+    char ruta[PATH_MAX];
+    snprintf(ruta, sizeof(ruta), "%s/kasiskiXXXXXX", dir && *dir ? dir : "/tmp");
+    int fd = mkstemp(ruta);
+    if (fd >= 0) unlink(ruta);
+    return fd;
+}
+
+static int particion_volcar(Particion *p) {
+    const char *b = (const char *)p->buf;
+    size_t bytes = p->n * sizeof(uint64_t);
+    while (bytes) {
+        ssize_t w = write(p->fd, b, bytes);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        b += w;
+        bytes -= (size_t)w;
+    }
+    p->registros += p->n;
+    p->n = 0;
+    return 0;
+}
+
+// Partición de la clave c (las claves se reparten en rangos iguales)
+static inline int particion_de(unsigned c, int np) {
+    return (int)((uint64_t)c * (uint64_t)np / KASISKI_CUBETAS);
+}
+
+// Pasada 1: normaliza la entrada y reparte los trigramas. Devuelve las letras.
+static int repartir(FILE *in, Particion *part, int np, uint64_t *len_out) {
+    unsigned char *raw = malloc(KEXT_BLOQUE);
+    char *letras = malloc(KEXT_BLOQUE);
+    if (!raw || !letras) { free(raw); free(letras); return -1; }
+
+    Normalizador nz;
+    normalizador_init(&nz, NORM_ASCII);
+    uint64_t len = 0;
+    unsigned clave = 0;
+    size_t got;
+    int ok = 1;
+    while (ok && (got = fread(raw, 1, KEXT_BLOQUE, in)) > 0) {
+        INSTR_SUMAR(INSTR_BYTES_LEIDOS, got);
+        INSTR_INICIO(t_norm);
+        size_t n = normalizar_bloque(&nz, raw, got, letras);
+        INSTR_FIN(ETAPA_NORMALIZAR, t_norm, n);
+        if (len + n > KEXT_MASCARA_POS) {
+            fprintf(stderr, "Error: más de 2^%d letras\n", KEXT_BITS_POS);
+            ok = 0;
+            break;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            // clave del trigrama que termina en esta letra
+            clave = (clave * 26 + (unsigned)(letras[i] - 'A')) % KASISKI_CUBETAS;
+            if (++len < KEXT_NGRAM) continue;
+            Particion *p = &part[particion_de(clave, np)];
+            p->buf[p->n++] = ((uint64_t)clave << KEXT_BITS_POS) | (len - KEXT_NGRAM);
+            if (p->n == p->cap && particion_volcar(p) < 0) { ok = 0; break; }
+        }
+    }
+    if (ferror(in)) ok = 0;
+    for (int p = 0; ok && p < np; ++p)
+        if (particion_volcar(&part[p]) < 0) ok = 0;
+    free(raw);
+    free(letras);
+    *len_out = len;
+    return ok ? 0 : -1;
+}
+
+// Cierra la ventana en curso del trigrama c: vota como kasiski_votos
+static inline void ventana_votar(Trabajo *t, unsigned c, int votos[MAX_K_CAND + 1]) {
+    if (t->ventana[c] == 0) t->mcds[c] = t->g_ventana[c];
+    if (t->n_ventana[c] >= 2 && t->g_ventana[c] >= 2 && t->g_ventana[c] <= 20) votos[t->g_ventana[c]]++;
+}
+
+// Pasada 2: cada hilo toma particiones y, por trigrama, acumula el MCD de las
+// distancias a su primera aparición dentro de cada ventana de KEXT_VENTANA
+// letras (con el mismo filtro que kasiski() sobre ese trozo). Los votos de las
+// ventanas se suman: el MCD de todo un texto enorme tiende a 1 o 2.
+static void *hilo_particiones(void *arg) {
+    Trabajo *t = arg;
+    uint64_t *buf = malloc(t->cap_lectura * sizeof(uint64_t));
+    if (!buf) { t->error = 1; return NULL; }
+    int votos[MAX_K_CAND + 1] = {0};
+    int p;
+    while ((p = atomic_fetch_add(&t->siguiente, 1)) < t->np) {
+        off_t off = 0;
+        for (;;) {
+            ssize_t r = pread(t->part[p].fd, buf, t->cap_lectura * sizeof(uint64_t), off);
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0) { t->error = 1; break; }
+            size_t n = (size_t)r / sizeof(uint64_t);
+            if (n == 0) break;
+            for (size_t k = 0; k < n; ++k) {
+                unsigned c = (unsigned)(buf[k] >> KEXT_BITS_POS);
+                uint64_t pos = buf[k] & KEXT_MASCARA_POS, v = pos / KEXT_VENTANA;
+                // Los registros llegan en orden de posición: el primero de la
+                // ventana es la base
+                if (t->cuenta[c]++ == 0 || t->ventana[c] != v) {
+                    if (t->cuenta[c] > 1) ventana_votar(t, c, votos);
+                    t->ventana[c] = v;
+                    t->base[c] = pos;
+                    t->n_ventana[c] = 1;
+                    t->g_ventana[c] = 0;
+                    continue;
+                }
+                t->n_ventana[c]++;
+                uint64_t ini = v * KEXT_VENTANA, fin = t->len < ini + KEXT_VENTANA ? t->len : ini + KEXT_VENTANA;
+                uint64_t d = pos - t->base[c];
+                if (d < KASISKI_MIN_DIST || d >= (fin - ini) / 2) continue;
+                t->g_ventana[c] = t->g_ventana[c] ? mcd64(t->g_ventana[c], d) : d;
+            }
+            off += (off_t)(n * sizeof(uint64_t));
+        }
+        // Ventanas abiertas de los trigramas de la partición
+        for (unsigned c = 0; c < KASISKI_CUBETAS; ++c)
+            if (particion_de(c, t->np) == p && t->cuenta[c]) ventana_votar(t, c, votos);
+    }
+    for (int k = 0; k <= MAX_K_CAND; ++k)
+        if (votos[k]) atomic_fetch_add(&t->votos[k], votos[k]);
+    free(buf);
+    return NULL;
+}
+
+int kasiski_externo(FILE *in, size_t mem_limit, int hilos) {
+    INSTR_INICIO(t_kas);
+    if (mem_limit < KEXT_MEM_MIN) mem_limit = KEXT_MEM_MIN;
+    if (hilos <= 0) hilos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (hilos < 1) hilos = 1;
+    if (hilos > KEXT_PARTICIONES) hilos = KEXT_PARTICIONES;
+
+    // Mitad de la memoria para escribir particiones y mitad para leerlas
+    size_t cap_escritura = mem_limit / 2 / KEXT_PARTICIONES / sizeof(uint64_t);
+    size_t cap_lectura = mem_limit / 2 / (size_t)hilos / sizeof(uint64_t);
+
+    Particion part[KEXT_PARTICIONES];
+    memset(part, 0, sizeof(part));
+    int np = 0, ok = 1;
+    for (; np < KEXT_PARTICIONES; ++np) {
+        part[np].fd = temporal();
+        part[np].cap = cap_escritura;
+        part[np].buf = malloc(cap_escritura * sizeof(uint64_t));
+        if (part[np].fd < 0 || !part[np].buf) {
+            perror("Error creando temporales");
+            if (part[np].fd >= 0) close(part[np].fd);
+            free(part[np].buf);
+            ok = 0;
+            break;
+        }
+    }
+
+    uint64_t len = 0;
+    int best_k = 0;
+    if (ok && repartir(in, part, np, &len) < 0) {
+        perror("Error escribiendo temporales");
+        ok = 0;
+    }
+    for (int p = 0; p < np; ++p) {
+        free(part[p].buf);
+        part[p].buf = NULL;
+    }
+
+    Trabajo t;
+    memset(&t, 0, sizeof(t));
+    t.part = part;
+    t.np = np;
+    t.len = len;
+    t.cap_lectura = cap_lectura;
+    t.cuenta = calloc(KASISKI_CUBETAS, sizeof(uint64_t));
+    t.mcds = calloc(KASISKI_CUBETAS, sizeof(uint64_t));
+    t.ventana = malloc(KASISKI_CUBETAS * sizeof(uint64_t));
+    t.base = malloc(KASISKI_CUBETAS * sizeof(uint64_t));
+    t.n_ventana = malloc(KASISKI_CUBETAS * sizeof(uint64_t));
+    t.g_ventana = malloc(KASISKI_CUBETAS * sizeof(uint64_t));
+    for (int k = 0; k <= MAX_K_CAND; ++k) atomic_init(&t.votos[k], 0);
+    if (!t.cuenta || !t.mcds || !t.ventana || !t.base || !t.n_ventana || !t.g_ventana) ok = 0;
+
+    if (ok) {
+        pthread_t th[KEXT_PARTICIONES];
+        int lanzados = 0;
+        for (; lanzados < hilos; ++lanzados)
+            if (pthread_create(&th[lanzados], NULL, hilo_particiones, &t) != 0) break;
+        if (lanzados == 0) hilo_particiones(&t);
+        for (int i = 0; i < lanzados; ++i) pthread_join(th[i], NULL);
+        if (t.error) {
+            fprintf(stderr, "Error leyendo temporales\n");
+            ok = 0;
+        }
+    }
+
+    if (ok) {
+        uint64_t registros = 0;
+        for (int p = 0; p < np; ++p) registros += part[p].registros;
+        fprintf(stderr, "Kasiski externo: %llu letras, %d particiones (%.1f MiB), %d hilos, %.1f MiB de memoria\n",
+                (unsigned long long)len, np, registros * sizeof(uint64_t) / 1048576.0, hilos,
+                mem_limit / 1048576.0);
+        int votos[MAX_K_CAND + 1];
+        for (int k = 0; k <= MAX_K_CAND; ++k) votos[k] = atomic_load(&t.votos[k]);
+        best_k = kasiski_informe_votos(len, t.cuenta, t.mcds, votos);
+    }
+
+    for (int p = 0; p < np; ++p) close(part[p].fd);
+    free(t.cuenta);
+    free(t.mcds);
+    free(t.ventana);
+    free(t.base);
+    free(t.n_ventana);
+    free(t.g_ventana);
+    INSTR_FIN(ETAPA_KASISKI, t_kas, len);
+    return ok ? best_k : -1;
+}
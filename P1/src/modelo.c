@@ -0,0 +1,197 @@
+#include "modelo.h"
+#include "normalizar.h"
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MODELO_BLOQUE 65536
+#define MODELO_SUELO 0.01 // cuenta que se da a los n-gramas que no aparecen
+
+/* Recuentos de un trozo del corpus */
+typedef struct {
+    const char *text;
+    size_t ini, fin, len; // cuenta los n-gramas que empiezan en [ini, fin)
+    uint64_t uni[26];
+    uint64_t bi[26 * 26];
+    uint32_t *cuad;
+} Recuento;
+
+static void *hilo_contar(void *arg) {
+    Recuento *r = arg;
+    const unsigned char *t = (const unsigned char *)r->text;
+    unsigned q = 0;
+
+    // Arranca el cuadrigrama con las 3 letras anteriores a ini
+    size_t i = r->ini >= 3 ? r->ini - 3 : 0;
+    for (; i < r->ini; ++i) q = (q * 26 + (t[i] - 'A')) % MODELO_CUAD;
+    for (i = r->ini; i < r->fin; ++i) {
+        unsigned c = t[i] - 'A';
+        q = (q * 26 + c) % MODELO_CUAD;
+        r->uni[c]++;
+        if (i + 1 < r->len) r->bi[c * 26 + (t[i + 1] - 'A')]++;
+        if (i >= 3) r->cuad[q]++;
+    }
+    return NULL;
+}
+
+// Lee y normaliza un corpus a continuación de *buf
+static int leer_corpus(const char *ruta, char **buf, size_t *len, size_t *cap) {
+    FILE *f = fopen(ruta, "rb");
+    if (!f) { perror(ruta); return -1; }
+    Normalizador nz;
+    normalizador_init(&nz, NORM_ES);
+    unsigned char raw[MODELO_BLOQUE];
+    size_t got;
+    while ((got = fread(raw, 1, sizeof(raw), f)) > 0) {
+        if (*len + got > *cap) {
+            size_t nuevo = *cap ? *cap : MODELO_BLOQUE;
+            while (nuevo < *len + got) nuevo *= 2;
+            char *p = realloc(*buf, nuevo);
+            if (!p) { fclose(f); return -1; }
+            *buf = p;
+            *cap = nuevo;
+        }
+        *len += normalizar_bloque(&nz, raw, got, *buf + *len);
+    }
+    fclose(f);
+    return 0;
+}
+
+int modelo_entrenar(ModeloIdioma *m, const char *nombre, char *const *ficheros, int nficheros, int hilos) {
+    char *text = NULL;
+    size_t len = 0, cap = 0;
+    for (int i = 0; i < nficheros; ++i)
+        if (leer_corpus(ficheros[i], &text, &len, &cap) < 0) { free(text); return -1; }
+
+    if (hilos <= 0) hilos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (hilos < 1) hilos = 1;
+    if ((size_t)hilos > len / MODELO_BLOQUE + 1) hilos = (int)(len / MODELO_BLOQUE + 1);
+
+    // Cada hilo cuenta su trozo en tablas propias; luego se suman
+    Recuento *r = calloc(hilos, sizeof(Recuento));
+    pthread_t *th = malloc(hilos * sizeof(pthread_t));
+    if (!r || !th) { free(r); free(th); free(text); return -1; }
+    // Sin memoria para todas las tablas se reparte el texto entre las que haya
+    int listas = 0;
+    for (; listas < hilos; ++listas)
+        if (!(r[listas].cuad = calloc(MODELO_CUAD, sizeof(uint32_t)))) break;
+    hilos = listas;
+    for (int t = 0; t < hilos; ++t) {
+        r[t].text = text;
+        r[t].len = len;
+        r[t].ini = len * t / hilos;
+        r[t].fin = len * (t + 1) / hilos;
+    }
+    // Los trozos de los hilos que no arranquen los cuenta este
+    int lanzados = 0;
+    for (; lanzados < hilos; ++lanzados)
+        if (pthread_create(&th[lanzados], NULL, hilo_contar, &r[lanzados]) != 0) break;
+    for (int t = lanzados; t < hilos; ++t) hilo_contar(&r[t]);
+    for (int t = 0; t < lanzados; ++t) pthread_join(th[t], NULL);
+
+    uint64_t uni[26] = {0}, bi[26 * 26] = {0};
+    uint64_t *cuad = calloc(MODELO_CUAD, sizeof(uint64_t));
+    for (int t = 0; t < hilos; ++t) {
+        for (int j = 0; j < 26; ++j) uni[j] += r[t].uni[j];
+        for (int j = 0; j < 26 * 26; ++j) bi[j] += r[t].bi[j];
+        for (int j = 0; cuad && j < MODELO_CUAD; ++j) cuad[j] += r[t].cuad[j];
+        free(r[t].cuad);
+    }
+    free(r); free(th); free(text);
+    if (!cuad || hilos == 0) { free(cuad); return -1; }
+
+    // Log-probabilidades (los n-gramas ausentes reciben MODELO_SUELO)
+    memset(m, 0, sizeof(*m));
+    snprintf(m->nombre, sizeof(m->nombre), "%s", nombre);
+    m->letras = len;
+    double n1 = (double)len, n2 = len > 1 ? (double)(len - 1) : 1.0, n4 = len > 3 ? (double)(len - 3) : 1.0;
+    if (n1 < 1.0) n1 = 1.0;
+    for (int j = 0; j < 26; ++j) {
+        m->p1[j] = (double)uni[j] / n1;
+        m->ic += m->p1[j] * m->p1[j];
+        m->uni[j] = (float)log((uni[j] ? (double)uni[j] : MODELO_SUELO) / n1);
+    }
+    for (int j = 0; j < 26 * 26; ++j)
+        m->bi[j] = (float)log((bi[j] ? (double)bi[j] : MODELO_SUELO) / n2);
+    for (int j = 0; j < MODELO_CUAD; ++j)
+        m->cuad[j] = (float)log((cuad[j] ? (double)cuad[j] : MODELO_SUELO) / n4);
+    free(cuad);
+    return 0;
+}
+
+int modelo_guardar(const char *ruta, const ModeloIdioma *idiomas, int n) {
+    FILE *f = fopen(ruta, "wb");
+    if (!f) { perror(ruta); return -1; }
+    ModeloCab cab;
+    memset(&cab, 0, sizeof(cab));
+    memcpy(cab.magic, MODELO_MAGIC, sizeof(MODELO_MAGIC));
+    cab.version = MODELO_VERSION;
+    cab.nidiomas = (uint32_t)n;
+    cab.tam_idioma = sizeof(ModeloIdioma);
+    int ok = fwrite(&cab, sizeof(cab), 1, f) == 1 &&
+             fwrite(idiomas, sizeof(ModeloIdioma), (size_t)n, f) == (size_t)n;
+    if (fclose(f) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+Modelo *modelo_abrir(const char *ruta) {
+    int fd = open(ruta, O_RDONLY);
+    if (fd < 0) { perror(ruta); return NULL; }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(ModeloCab)) {
+        fprintf(stderr, "Error: %s no es un modelo válido\n", ruta);
+        close(fd);
+        return NULL;
+    }
+    size_t tam = (size_t)st.st_size;
+    void *map = mmap(NULL, tam, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) { perror("mmap"); return NULL; }
+
+    const ModeloCab *cab = map;
+    if (memcmp(cab->magic, MODELO_MAGIC, sizeof(MODELO_MAGIC)) != 0 || cab->version != MODELO_VERSION ||
+        cab->tam_idioma != sizeof(ModeloIdioma) || cab->nidiomas > MODELO_MAX_IDIOMAS ||
+        sizeof(ModeloCab) + cab->nidiomas * sizeof(ModeloIdioma) > tam) {
+        fprintf(stderr, "Error: %s no es un modelo válido (versión %d)\n", ruta, MODELO_VERSION);
+        munmap(map, tam);
+        return NULL;
+    }
+
+    Modelo *m = malloc(sizeof(Modelo));
+    if (!m) { munmap(map, tam); return NULL; }
+    m->map = map;
+    m->tam = tam;
+    m->n = (int)cab->nidiomas;
+    m->idiomas = (const ModeloIdioma *)((const char *)map + sizeof(ModeloCab));
+    return m;
+}
+
+void modelo_cerrar(Modelo *m) {
+    if (!m) return;
+    munmap(m->map, m->tam);
+    free(m);
+}
+
+const ModeloIdioma *modelo_buscar(const Modelo *m, const char *nombre) {
+    for (int i = 0; i < m->n; ++i)
+        if (strcmp(m->idiomas[i].nombre, nombre) == 0) return &m->idiomas[i];
+    return NULL;
+}
+
+double modelo_puntuar(const ModeloIdioma *m, const char *text, size_t len) {
+    if (len < 4) return 0.0;
+    const unsigned char *t = (const unsigned char *)text;
+    unsigned q = ((t[0] - 'A') * 26 + (t[1] - 'A')) * 26 + (t[2] - 'A');
+    double s = 0.0;
+    for (size_t i = 3; i < len; ++i) {
+        q = (q * 26 + (t[i] - 'A')) % MODELO_CUAD;
+        s += m->cuad[q];
+    }
+    return s / (double)(len - 3);
+}
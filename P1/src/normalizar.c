@@ -0,0 +1,190 @@
+#include "normalizar.h"
+#include "instr.h"
+#include <stddef.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/* Estados del autómata UTF-8 */
+#define EST_BASE 0 /* byte inicial */
+#define EST_C3   1 /* visto 0xC3: el siguiente byte decide la letra */
+#define EST_N    2 /* NORM_ES27: N retenida al final del bloque anterior */
+#define EST_N_CC 3 /* NORM_ES27: N retenida seguida de 0xCC */
+
+#define L(x) [x] = x, [x + 32] = x
+const unsigned char TABLA_ASCII[256] = {
+    L('A'), L('B'), L('C'), L('D'), L('E'), L('F'), L('G'), L('H'), L('I'),
+    L('J'), L('K'), L('L'), L('M'), L('N'), L('O'), L('P'), L('Q'), L('R'),
+    L('S'), L('T'), L('U'), L('V'), L('W'), L('X'), L('Y'), L('Z'),
+};
+#undef L
+
+/* Continuaciones de 0xC3 (Latin-1 U+00C0..U+00FF): vocales con tilde o
+ * diéresis -> vocal base, Ñ/ñ -> N; el resto se descarta. En texto NFD
+ * (letra + marca combinante 0xCC xx) la marca se descarta sola y queda la
+ * letra base. */
+static const unsigned char TABLA_C3[256] = {
+    [0x80] = 'A', [0x81] = 'A', [0x82] = 'A', [0x83] = 'A', [0x84] = 'A', /* ÀÁÂÃÄ */
+    [0x88] = 'E', [0x89] = 'E', [0x8A] = 'E', [0x8B] = 'E',               /* ÈÉÊË */
+    [0x8C] = 'I', [0x8D] = 'I', [0x8E] = 'I', [0x8F] = 'I',               /* ÌÍÎÏ */
+    [0x91] = 'N',                                                         /* Ñ */
+    [0x92] = 'O', [0x93] = 'O', [0x94] = 'O', [0x95] = 'O', [0x96] = 'O', /* ÒÓÔÕÖ */
+    [0x99] = 'U', [0x9A] = 'U', [0x9B] = 'U', [0x9C] = 'U',               /* ÙÚÛÜ */
+    [0xA0] = 'A', [0xA1] = 'A', [0xA2] = 'A', [0xA3] = 'A', [0xA4] = 'A', /* àáâãä */
+    [0xA8] = 'E', [0xA9] = 'E', [0xAA] = 'E', [0xAB] = 'E',               /* èéêë */
+    [0xAC] = 'I', [0xAD] = 'I', [0xAE] = 'I', [0xAF] = 'I',               /* ìíîï */
+    [0xB1] = 'N',                                                         /* ñ */
+    [0xB2] = 'O', [0xB3] = 'O', [0xB4] = 'O', [0xB5] = 'O', [0xB6] = 'O', /* òóôõö */
+    [0xB9] = 'U', [0xBA] = 'U', [0xBB] = 'U', [0xBC] = 'U',               /* ùúûü */
+};
+
+/* Igual que TABLA_C3 pero conservando la Ñ (NORM_ES27) */
+static const unsigned char TABLA_C3_27[256] = {
+    [0x80] = 'A', [0x81] = 'A', [0x82] = 'A', [0x83] = 'A', [0x84] = 'A',
+    [0x88] = 'E', [0x89] = 'E', [0x8A] = 'E', [0x8B] = 'E',
+    [0x8C] = 'I', [0x8D] = 'I', [0x8E] = 'I', [0x8F] = 'I',
+    [0x91] = NORM_ENYE,
+    [0x92] = 'O', [0x93] = 'O', [0x94] = 'O', [0x95] = 'O', [0x96] = 'O',
+    [0x99] = 'U', [0x9A] = 'U', [0x9B] = 'U', [0x9C] = 'U',
+    [0xA0] = 'A', [0xA1] = 'A', [0xA2] = 'A', [0xA3] = 'A', [0xA4] = 'A',
+    [0xA8] = 'E', [0xA9] = 'E', [0xAA] = 'E', [0xAB] = 'E',
+    [0xAC] = 'I', [0xAD] = 'I', [0xAE] = 'I', [0xAF] = 'I',
+    [0xB1] = NORM_ENYE,
+    [0xB2] = 'O', [0xB3] = 'O', [0xB4] = 'O', [0xB5] = 'O', [0xB6] = 'O',
+    [0xB9] = 'U', [0xBA] = 'U', [0xBB] = 'U', [0xBC] = 'U',
+};
+
+void normalizador_init(Normalizador *nz, int modo) {
+    nz->modo = modo;
+    nz->estado = EST_BASE;
+}
+
+#if defined(__SSE2__)
+/* Copia a out las letras marcadas en mask (bit i -> byte i de up) */
+static inline size_t compactar(const unsigned char *up, unsigned mask, char *out) {
+    size_t o = 0;
+    while (mask) {
+        out[o++] = (char)up[__builtin_ctz(mask)];
+        mask &= mask - 1;
+    }
+    return o;
+}
+#endif
+
+size_t normalizar_bloque(Normalizador *nz, const unsigned char *in, size_t n, char *out) {
+    size_t i = 0, o = 0;
+    int es = (nz->modo != NORM_ASCII);
+    int enye = (nz->modo == NORM_ES27);
+    const unsigned char *c3 = enye ? TABLA_C3_27 : TABLA_C3;
+
+    if (n == 0) return 0;
+
+    // Secuencia UTF-8 partida en el bloque anterior
+    if (nz->estado == EST_C3) {
+        unsigned char c = c3[in[0]];
+        if (c) out[o++] = (char)c;
+        INSTR_SUMAR(c ? INSTR_LETRAS_UTF8 : INSTR_DESCARTE_UTF8, 1);
+        nz->estado = EST_BASE;
+        i = 1;
+    }
+    // N retenida: decide si es Ñ en NFD (N + 0xCC 0x83)
+    if (nz->estado == EST_N) {
+        if (in[0] == 0xCC) {
+            nz->estado = EST_N_CC;
+            i = 1;
+            if (n == 1) return 0;
+        } else {
+            out[o++] = 'N';
+            nz->estado = EST_BASE;
+        }
+    }
+    if (nz->estado == EST_N_CC) {
+        out[o++] = (in[i] == 0x83) ? (char)NORM_ENYE : 'N';
+        nz->estado = EST_BASE;
+        i++;
+    }
+    size_t ini = i;
+
+    while (i < n) {
+#if defined(__AVX2__)
+        // Camino rápido: 32 bytes seguidos sin bytes >= 0x80
+        while (i + 32 <= n) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(in + i));
+            if (_mm256_movemask_epi8(v) != 0) break;
+            // letra <=> (v | 0x20) - 'a' < 26 (sin signo), con el sesgo de 128
+            __m256i t = _mm256_add_epi8(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), _mm256_set1_epi8(31));
+            unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(-102), t));
+            __m256i up = _mm256_and_si256(v, _mm256_set1_epi8((char)0xDF));
+            INSTR_SUMAR(INSTR_LETRAS_ASCII, __builtin_popcount(mask));
+            INSTR_SUMAR(INSTR_DESCARTE_ASCII, 32 - __builtin_popcount(mask));
+            if (mask == 0xFFFFFFFFu) {
+                _mm256_storeu_si256((__m256i *)(out + o), up);
+                o += 32;
+            } else if (mask) {
+                unsigned char tmp[32];
+                _mm256_storeu_si256((__m256i *)tmp, up);
+                o += compactar(tmp, mask, out + o);
+            }
+            i += 32;
+        }
+#elif defined(__SSE2__)
+        // Camino rápido: 16 bytes seguidos sin bytes >= 0x80
+        while (i + 16 <= n) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+            if (_mm_movemask_epi8(v) != 0) break;
+            // letra <=> (v | 0x20) - 'a' < 26 (sin signo), con el sesgo de 128
+            __m128i t = _mm_add_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8(31));
+            unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmplt_epi8(t, _mm_set1_epi8(-102)));
+            __m128i up = _mm_and_si128(v, _mm_set1_epi8((char)0xDF));
+            INSTR_SUMAR(INSTR_LETRAS_ASCII, __builtin_popcount(mask));
+            INSTR_SUMAR(INSTR_DESCARTE_ASCII, 16 - __builtin_popcount(mask));
+            if (mask == 0xFFFF) {
+                _mm_storeu_si128((__m128i *)(out + o), up);
+                o += 16;
+            } else if (mask) {
+                unsigned char tmp[16];
+                _mm_storeu_si128((__m128i *)tmp, up);
+                o += compactar(tmp, mask, out + o);
+            }
+            i += 16;
+        }
+#endif
+        // Camino escalar: hasta 64 bytes o fin del bloque
+        size_t end = (n - i > 64) ? i + 64 : n;
+        while (i < end) {
+            unsigned char b = in[i++];
+            unsigned char c = TABLA_ASCII[b];
+            if (c) {
+                out[o++] = (char)c;
+                INSTR_SUMAR(INSTR_LETRAS_ASCII, 1);
+            } else if (b == 0xC3 && es) {
+                if (i == n) { nz->estado = EST_C3; break; }
+                c = c3[in[i++]];
+                if (c) out[o++] = (char)c;
+                INSTR_SUMAR(c ? INSTR_LETRAS_UTF8 : INSTR_DESCARTE_UTF8, 1);
+            } else if (b == 0xCC && enye && i >= ini + 2 && TABLA_ASCII[in[i - 2]] == 'N') {
+                // Tilde combinante tras N: la N ya emitida pasa a ser Ñ
+                if (i == n) { o--; nz->estado = EST_N_CC; break; }
+                if (in[i] == 0x83) out[o - 1] = (char)NORM_ENYE;
+                i++;
+            } else {
+                INSTR_SUMAR(b < 0x80 ? INSTR_DESCARTE_ASCII : INSTR_DESCARTE_OTRO, 1);
+            }
+        }
+    }
+    // Una N al final del bloque puede ser el comienzo de una Ñ en NFD
+    if (enye && nz->estado == EST_BASE && n > ini && TABLA_ASCII[in[n - 1]] == 'N') {
+        o--;
+        nz->estado = EST_N;
+    }
+    return o;
+}
+
+size_t normalizar_fin(Normalizador *nz, char *out) {
+    int retenida = (nz->estado == EST_N || nz->estado == EST_N_CC);
+    nz->estado = EST_BASE;
+    if (!retenida) return 0;
+    out[0] = 'N';
+    return 1;
+}
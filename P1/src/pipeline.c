@@ -0,0 +1,264 @@
+#include "pipeline.h"
+#include "afin.h"
+#include "afin_modificado.h"
+#include "alfabeto.h"
+#include "vigenere.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PIPE_NBUF 8                       // buffers en circulación
+#define PIPE_CAP 8                        // capacidad de cada anillo (potencia de 2)
+#define PIPE_LETRAS (2520 * BLOCK_SIZE)   // letras por buffer: múltiplo del bloque
+#define PIPE_HOLGURA BLOCK_SIZE           // sitio para el relleno del último bloque
+#define PIPE_ESPERAS 128                  // vueltas activas antes de ceder la CPU
+
+typedef struct {
+    unsigned char *datos; // índices del alfabeto
+    size_t len;
+    int fin; // último buffer del flujo
+} PipeBuf;
+
+/* Anillo de un solo productor y un solo consumidor */
+typedef struct {
+    PipeBuf *slots[PIPE_CAP];
+    _Alignas(64) atomic_size_t cabeza; // lo avanza el productor
+    _Alignas(64) atomic_size_t cola;   // lo avanza el consumidor
+} Anillo;
+
+/* sched_yield no es punto de cancelación: se comprueba aquí para poder
+ * cancelar los hilos que esperan si otro no llega a arrancar */
+static void esperar(int *vueltas) {
+    if (++*vueltas > PIPE_ESPERAS) {
+        pthread_testcancel();
+        sched_yield();
+    }
+}
+
+static void anillo_poner(Anillo *r, PipeBuf *b) {
+    size_t h = atomic_load_explicit(&r->cabeza, memory_order_relaxed);
+    int vueltas = 0;
+    while (h - atomic_load_explicit(&r->cola, memory_order_acquire) == PIPE_CAP)
+        esperar(&vueltas);
+    r->slots[h & (PIPE_CAP - 1)] = b;
+    atomic_store_explicit(&r->cabeza, h + 1, memory_order_release);
+}
+
+static PipeBuf *anillo_quitar(Anillo *r) {
+    size_t t = atomic_load_explicit(&r->cola, memory_order_relaxed);
+    int vueltas = 0;
+    while (atomic_load_explicit(&r->cabeza, memory_order_acquire) == t)
+        esperar(&vueltas);
+    PipeBuf *b = r->slots[t & (PIPE_CAP - 1)];
+    atomic_store_explicit(&r->cola, t + 1, memory_order_release);
+    return b;
+}
+
+/* Etapa ya preparada (con sus tablas / clave invertida) */
+typedef struct {
+    int tipo;
+    VigenereCtx vig;
+    AfinCtx afin;
+    AfinModCtx mod;
+    int modo;
+    Anillo *entrada, *salida;
+} Etapa;
+
+typedef struct {
+    FILE *f;
+    const Alfabeto *alf;
+    Anillo *libres; // buffers vacíos que devuelve el escritor
+    Anillo *salida;
+    int error;      // sin memoria o fallo de lectura / escritura
+} Extremo;
+
+/* Lector: llena buffers con índices del alfabeto, todos salvo el último con
+ * exactamente PIPE_LETRAS índices para que los bloques nunca queden partidos */
+static void *hilo_lector(void *arg) {
+    Extremo *x = arg;
+    AlfLector lr;
+    alf_lector_init(&lr, x->alf);
+    unsigned char *raw = malloc(PIPE_LETRAS);
+    int eof = (raw == NULL);
+    int sobra = -1; // índice que no cupo en el buffer anterior
+    if (!raw) {
+        fprintf(stderr, "Error: sin memoria.\n");
+        x->error = 1;
+    }
+    pthread_cleanup_push(free, raw);
+
+    for (;;) {
+        PipeBuf *b = anillo_quitar(x->libres);
+        b->len = 0;
+        if (sobra >= 0) b->datos[b->len++] = (unsigned char)sobra;
+        sobra = -1;
+        while (!eof && b->len < PIPE_LETRAS) {
+            size_t got = fread(raw, 1, PIPE_LETRAS - b->len, x->f);
+            if (got == 0) {
+                if (ferror(x->f)) {
+                    perror("Error leyendo");
+                    x->error = 1;
+                }
+                b->len += alf_leer_fin(&lr, b->datos + b->len);
+                eof = 1;
+                break;
+            }
+            b->len += alf_leer(&lr, raw, got, b->datos + b->len);
+        }
+        // es27 puede soltar una N retenida además de lo leído
+        if (b->len > PIPE_LETRAS) {
+            sobra = b->datos[PIPE_LETRAS];
+            b->len = PIPE_LETRAS;
+        }
+        b->fin = eof;
+        anillo_poner(x->salida, b);
+        if (eof) break;
+    }
+    pthread_cleanup_pop(1);
+    return NULL;
+}
+
+static void *hilo_etapa(void *arg) {
+    Etapa *e = arg;
+    for (;;) {
+        PipeBuf *b = anillo_quitar(e->entrada);
+        switch (e->tipo) {
+        case PIPE_VIGENERE:
+            vigenere_ctx_indices(&e->vig, b->datos, b->len);
+            break;
+        case PIPE_AFIN:
+            afin_ctx_aplicar(&e->afin, b->datos, b->len);
+            break;
+        case PIPE_AFIN_MOD:
+            if (b->fin && b->len % BLOCK_SIZE) {
+                if (e->modo == CIPHER_AFIN) {
+                    // último bloque: rellenar con el índice 0 (como encriptar_afin_bloques)
+                    while (b->len % BLOCK_SIZE) b->datos[b->len++] = 0;
+                } else {
+                    // al descifrar se ignora un bloque incompleto
+                    b->len -= b->len % BLOCK_SIZE;
+                }
+            }
+            afin_mod_ctx_bloques(&e->mod, b->datos, b->len / BLOCK_SIZE);
+            break;
+        }
+        int fin = b->fin;
+        anillo_poner(e->salida, b);
+        if (fin) break;
+    }
+    return NULL;
+}
+
+/* Escritor: aunque falle la memoria o la escritura sigue devolviendo los
+ * buffers hasta el último, para que el resto de etapas termine */
+static void *hilo_escritor(void *arg) {
+    Extremo *x = arg;
+    char *salida = malloc(ALF_MAX_SIMBOLO * (PIPE_LETRAS + PIPE_HOLGURA));
+    if (!salida) {
+        fprintf(stderr, "Error: sin memoria.\n");
+        x->error = 1;
+    }
+    pthread_cleanup_push(free, salida);
+    for (;;) {
+        PipeBuf *b = anillo_quitar(x->salida);
+        if (!x->error) {
+            size_t nsal = alf_escribir(x->alf, b->datos, b->len, salida);
+            if (fwrite(salida, 1, nsal, x->f) != nsal) {
+                perror("Error escribiendo");
+                x->error = 1;
+            }
+        }
+        if (b->fin) break;
+        anillo_poner(x->libres, b);
+    }
+    if (fflush(x->f) != 0 && !x->error) {
+        perror("Error escribiendo");
+        x->error = 1;
+    }
+    pthread_cleanup_pop(1);
+    return NULL;
+}
+
+static void etapa_liberar(Etapa *e) {
+    if (e->tipo == PIPE_VIGENERE) vigenere_ctx_free(&e->vig);
+    else if (e->tipo == PIPE_AFIN_MOD) afin_mod_ctx_free(&e->mod);
+}
+
+int pipeline_ejecutar(FILE *in, FILE *out, const Alfabeto *alf, PipeEtapaSpec *specs, int n, int modo) {
+    if (n < 0 || n > PIPE_MAX_ETAPAS) return -1;
+
+    // 1) Preparar las etapas (al descifrar, en orden inverso)
+    Etapa etapas[PIPE_MAX_ETAPAS];
+    int listas = 0, ok = 1;
+    for (int i = 0; i < n && ok; ++i) {
+        PipeEtapaSpec *s = &specs[modo == CIPHER_AFIN ? i : n - 1 - i];
+        Etapa *e = &etapas[i];
+        memset(e, 0, sizeof(*e));
+        e->tipo = s->tipo;
+        e->modo = modo;
+        if (s->tipo == PIPE_VIGENERE) {
+            ok = vigenere_ctx_init_alf(&e->vig, alf, s->clave, modo == CIPHER_AFIN) == 0;
+            if (!ok) fprintf(stderr, "Error: la clave no tiene símbolos del alfabeto %s\n", alf->nombre);
+        } else if (s->tipo == PIPE_AFIN) {
+            mpz_t m;
+            mpz_init_set_ui(m, (unsigned long)alf->m);
+            ok = afin_ctx_init(&e->afin, s->a, s->b, m, modo) == 0;
+            mpz_clear(m);
+        } else if (s->tipo == PIPE_AFIN_MOD) {
+            ok = afin_mod_ctx_init(&e->mod, alf, s->a, s->b, modo) == 0;
+        } else {
+            ok = 0;
+        }
+        if (ok) listas++;
+    }
+    if (!ok) {
+        for (int i = 0; i < listas; ++i) etapa_liberar(&etapas[i]);
+        return -1;
+    }
+
+    // 2) Buffers y anillos: libres -> lector -> etapa 0 -> ... -> escritor -> libres
+    Anillo *anillos = calloc((size_t)n + 2, sizeof(Anillo));
+    PipeBuf bufs[PIPE_NBUF];
+    unsigned char *memoria = malloc((size_t)PIPE_NBUF * (PIPE_LETRAS + PIPE_HOLGURA));
+    if (!anillos || !memoria) {
+        fprintf(stderr, "Error: sin memoria.\n");
+        free(anillos); free(memoria);
+        for (int i = 0; i < n; ++i) etapa_liberar(&etapas[i]);
+        return -1;
+    }
+    Anillo *libres = &anillos[n + 1];
+    for (int i = 0; i < PIPE_NBUF; ++i) {
+        bufs[i].datos = memoria + (size_t)i * (PIPE_LETRAS + PIPE_HOLGURA);
+        anillo_poner(libres, &bufs[i]);
+    }
+
+    Extremo lector = { in, alf, libres, &anillos[0], 0 };
+    Extremo escritor = { out, alf, libres, &anillos[n], 0 };
+    for (int i = 0; i < n; ++i) {
+        etapas[i].entrada = &anillos[i];
+        etapas[i].salida = &anillos[i + 1];
+    }
+
+    // 3) Un hilo por etapa; si alguno no arranca, los demás se quedarían
+    // esperando en los anillos: se cancelan
+    pthread_t hilos[PIPE_MAX_ETAPAS + 2];
+    int lanzados = 0;
+    if (pthread_create(&hilos[0], NULL, hilo_lector, &lector) == 0) lanzados = 1;
+    for (int i = 0; i < n && lanzados == i + 1; ++i)
+        if (pthread_create(&hilos[i + 1], NULL, hilo_etapa, &etapas[i]) == 0) lanzados++;
+    if (lanzados == n + 1 && pthread_create(&hilos[n + 1], NULL, hilo_escritor, &escritor) == 0) lanzados++;
+    int arrancados = lanzados == n + 2;
+    if (!arrancados) {
+        fprintf(stderr, "Error: no se pudo arrancar el hilo %d de la tubería\n", lanzados);
+        for (int i = 0; i < lanzados; ++i) pthread_cancel(hilos[i]);
+    }
+    for (int i = 0; i < lanzados; ++i) pthread_join(hilos[i], NULL);
+
+    for (int i = 0; i < n; ++i) etapa_liberar(&etapas[i]);
+    free(memoria);
+    free(anillos);
+    return arrancados && !lector.error && !escritor.error ? 0 : -1;
+}
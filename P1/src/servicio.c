@@ -0,0 +1,349 @@
+#include "servicio.h"
+#include "afin.h"
+#include "afin_modificado.h"
+#include "alfabeto.h"
+#include "pipeline.h"
+#include "vigenere.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <gmp.h>
+
+/* Contexto ya validado de una clave */
+typedef struct {
+    int usado;
+    uint64_t hash;
+    uint8_t cifrado, modo, alf;
+    char *clave;
+    const Alfabeto *alfabeto;
+    VigenereCtx vig; // la fase se copia en cada petición: el contexto guardado no cambia
+    AfinCtx afin;
+    AfinModCtx mod;
+} Entrada;
+
+/* Estado de cada hilo: su caché de claves y sus búferes de trabajo */
+typedef struct {
+    int escucha;
+    atomic_int *parar;
+    atomic_int conexion; // la que se está atendiendo (-1 si ninguna)
+    Entrada cache[SERV_CACHE];
+    char clave[SERV_MAX_CLAVE + 1];
+    unsigned char *datos, *idx;
+    char *salida;
+    size_t cap; // datos que caben en los búferes
+} Hilo;
+
+static int leer_todo(int fd, void *buf, size_t n) {
+    char *p = buf;
+    while (n) {
+        ssize_t r = read(fd, p, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        p += r;
+        n -= (size_t)r;
+    }
+    return 0;
+}
+
+static int escribir_todo(int fd, const void *buf, size_t n) {
+    const char *p = buf;
+    while (n) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+// FNV-1a de la clave junto con cifrado, modo y alfabeto
+static uint64_t hash_clave(const ServPeticion *p, const char *clave) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    const unsigned char cab[3] = {p->cifrado, p->modo, p->alf};
+    for (int i = 0; i < 3; ++i) h = (h ^ cab[i]) * 0x100000001b3ULL;
+    for (const unsigned char *c = (const unsigned char *)clave; *c; ++c) h = (h ^ *c) * 0x100000001b3ULL;
+    return h;
+}
+
+// Vigenère con latin26 cifra el texto tal cual (como el ejecutable vigenere)
+static int modo_texto(const Entrada *e) {
+    return e->cifrado == PIPE_VIGENERE && e->alf == ALF_LATIN26;
+}
+
+static void entrada_liberar(Entrada *e) {
+    if (!e->usado) return;
+    if (e->cifrado == PIPE_VIGENERE) vigenere_ctx_free(&e->vig);
+    else if (e->cifrado == PIPE_AFIN_MOD) afin_mod_ctx_free(&e->mod);
+    free(e->clave);
+    e->usado = 0;
+}
+
+// Valida la clave y prepara su contexto (lo caro: GMP, inversos, tablas)
+static int entrada_preparar(Entrada *e, const ServPeticion *p, const char *clave, uint64_t h) {
+    const Alfabeto *alf = p->alf == ALF_LATIN26 ? alfabeto_por_nombre("latin26")
+                        : p->alf == ALF_ES27    ? alfabeto_por_nombre("es27")
+                                                : alfabeto_por_nombre("bytes");
+    memset(e, 0, sizeof(*e));
+    e->alfabeto = alf;
+    e->hash = h;
+    e->cifrado = p->cifrado;
+    e->modo = p->modo;
+    e->alf = p->alf;
+
+    int ok;
+    if (p->cifrado == PIPE_VIGENERE) {
+        ok = (modo_texto(e) ? vigenere_ctx_init(&e->vig, clave, p->modo == CIPHER_AFIN)
+                            : vigenere_ctx_init_alf(&e->vig, alf, clave, p->modo == CIPHER_AFIN)) == 0;
+        if (!ok && modo_texto(e)) vigenere_ctx_free(&e->vig);
+    } else {
+        char a_str[SERV_MAX_CLAVE + 1];
+        snprintf(a_str, sizeof(a_str), "%s", clave);
+        char *coma = strchr(a_str, ',');
+        mpz_t a, b, m;
+        mpz_inits(a, b, m, NULL);
+        ok = coma != NULL;
+        if (ok) {
+            *coma++ = '\0';
+            ok = mpz_set_str(a, a_str, 10) == 0 && mpz_set_str(b, coma, 10) == 0;
+        }
+        if (ok && p->cifrado == PIPE_AFIN) {
+            mpz_set_ui(m, (unsigned long)alf->m);
+            ok = afin_ctx_init(&e->afin, a, b, m, p->modo) == 0;
+        } else if (ok) {
+            ok = afin_mod_ctx_init(&e->mod, alf, a, b, p->modo) == 0;
+        }
+        mpz_clears(a, b, m, NULL);
+    }
+    if (ok && !(e->clave = strdup(clave))) {
+        e->usado = 1;
+        entrada_liberar(e);
+        return -1;
+    }
+    e->usado = ok;
+    return ok ? 0 : -1;
+}
+
+static Entrada *buscar(Hilo *h, const ServPeticion *p) {
+    uint64_t hs = hash_clave(p, h->clave);
+    Entrada *e = &h->cache[hs % SERV_CACHE];
+    if (e->usado && e->hash == hs && e->cifrado == p->cifrado && e->modo == p->modo && e->alf == p->alf &&
+        strcmp(e->clave, h->clave) == 0)
+        return e;
+    entrada_liberar(e);
+    return entrada_preparar(e, p, h->clave, hs) == 0 ? e : NULL;
+}
+
+static int reservar(Hilo *h, size_t n) {
+    if (n <= h->cap && h->datos) return 0;
+    size_t cap = h->cap ? h->cap : 4096;
+    while (cap < n) cap *= 2;
+    unsigned char *d = realloc(h->datos, cap);
+    if (d) h->datos = d;
+    unsigned char *i = realloc(h->idx, cap + BLOCK_SIZE);
+    if (i) h->idx = i;
+    char *s = realloc(h->salida, ALF_MAX_SIMBOLO * (cap + BLOCK_SIZE));
+    if (s) h->salida = s;
+    if (!d || !i || !s) return -1;
+    h->cap = cap;
+    return 0;
+}
+
+// Cifra los datos de la petición; devuelve los bytes de salida en h->salida
+static size_t aplicar(Hilo *h, Entrada *e, size_t n) {
+    if (modo_texto(e)) {
+        VigenereCtx v = e->vig;
+        memcpy(h->salida, h->datos, n);
+        vigenere_ctx_aplicar(&v, h->salida, n);
+        return n;
+    }
+
+    const Alfabeto *alf = e->alfabeto;
+    AlfLector lr;
+    alf_lector_init(&lr, alf);
+    size_t len = alf_leer(&lr, h->datos, n, h->idx);
+    len += alf_leer_fin(&lr, h->idx + len);
+
+    if (e->cifrado == PIPE_VIGENERE) {
+        VigenereCtx v = e->vig;
+        vigenere_ctx_indices(&v, h->idx, len);
+    } else if (e->cifrado == PIPE_AFIN) {
+        afin_ctx_aplicar(&e->afin, h->idx, len);
+    } else {
+        // último bloque: relleno con el índice 0 al cifrar, se ignora al descifrar
+        if (e->modo == CIPHER_AFIN)
+            while (len % BLOCK_SIZE) h->idx[len++] = 0;
+        else
+            len -= len % BLOCK_SIZE;
+        afin_mod_ctx_bloques(&e->mod, h->idx, len / BLOCK_SIZE);
+    }
+    return alf_escribir(alf, h->idx, len, h->salida);
+}
+
+static int responder(int fd, uint32_t estado, const void *datos, size_t n) {
+    ServRespuesta r = {estado, (uint32_t)n};
+    if (escribir_todo(fd, &r, sizeof(r)) < 0) return -1;
+    return n ? escribir_todo(fd, datos, n) : 0;
+}
+
+// Atiende peticiones por una conexión hasta que el cliente la cierre
+static void atender(Hilo *h, int fd) {
+    ServPeticion p;
+    while (leer_todo(fd, &p, sizeof(p)) == 0) {
+        if (p.magic != SERV_MAGIC || p.cifrado > PIPE_AFIN_MOD || p.alf > ALF_BYTES ||
+            (p.modo != CIPHER_AFIN && p.modo != DECIPHER_AFIN) || p.clave_len > SERV_MAX_CLAVE ||
+            p.datos_len > SERV_MAX_DATOS) {
+            responder(fd, SERV_ERR_FORMATO, NULL, 0);
+            return; // ya no se sabe dónde empieza la siguiente petición
+        }
+        if (leer_todo(fd, h->clave, p.clave_len) < 0) return;
+        h->clave[p.clave_len] = '\0';
+        if (reservar(h, p.datos_len) < 0) {
+            responder(fd, SERV_ERR_MEMORIA, NULL, 0);
+            return;
+        }
+        if (leer_todo(fd, h->datos, p.datos_len) < 0) return;
+
+        Entrada *e = buscar(h, &p);
+        int r = e ? responder(fd, SERV_OK, h->salida, aplicar(h, e, p.datos_len))
+                  : responder(fd, SERV_ERR_CLAVE, NULL, 0);
+        if (r < 0) return;
+    }
+}
+
+static void *hilo_servicio(void *arg) {
+    Hilo *h = arg;
+    for (;;) {
+        int fd = accept(h->escucha, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break; // socket cerrado: se acaba el servicio
+        }
+        atomic_store(&h->conexion, fd);
+        if (!atomic_load(h->parar)) atender(h, fd);
+        atomic_store(&h->conexion, -1);
+        close(fd);
+    }
+    return NULL;
+}
+
+static void hilo_liberar(Hilo *h) {
+    for (int i = 0; i < SERV_CACHE; ++i) entrada_liberar(&h->cache[i]);
+    free(h->datos);
+    free(h->idx);
+    free(h->salida);
+}
+
+int servicio_ejecutar(const char *ruta, int hilos) {
+    if (!ruta) ruta = SERV_SOCKET;
+    if (hilos <= 0) hilos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (hilos < 1) hilos = 1;
+
+    struct sockaddr_un dir;
+    memset(&dir, 0, sizeof(dir));
+    dir.sun_family = AF_UNIX;
+    if (strlen(ruta) >= sizeof(dir.sun_path)) {
+        fprintf(stderr, "Error: ruta de socket demasiado larga: %s\n", ruta);
+        return -1;
+    }
+    strcpy(dir.sun_path, ruta);
+
+    int s = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (s < 0) { perror("socket"); return -1; }
+    unlink(ruta);
+    if (bind(s, (struct sockaddr *)&dir, sizeof(dir)) < 0 || listen(s, 128) < 0) {
+        perror(ruta);
+        close(s);
+        return -1;
+    }
+
+    // Las señales de parada solo las recoge este hilo; un cliente que se va no mata el servicio
+    sigset_t paro;
+    sigemptyset(&paro);
+    sigaddset(&paro, SIGINT);
+    sigaddset(&paro, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &paro, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    atomic_int parar = 0;
+    Hilo *estado = calloc((size_t)hilos, sizeof(Hilo));
+    pthread_t *th = malloc((size_t)hilos * sizeof(pthread_t));
+    int lanzados = 0;
+    for (; estado && th && lanzados < hilos; ++lanzados) {
+        estado[lanzados].escucha = s;
+        estado[lanzados].parar = &parar;
+        atomic_init(&estado[lanzados].conexion, -1);
+        if (pthread_create(&th[lanzados], NULL, hilo_servicio, &estado[lanzados]) != 0) break;
+    }
+    if (lanzados == 0) {
+        fprintf(stderr, "Error: no se pudo arrancar ningún hilo\n");
+        close(s);
+        unlink(ruta);
+        free(estado);
+        free(th);
+        return -1;
+    }
+    fprintf(stderr, "Servicio en %s con %d hilos\n", ruta, lanzados);
+
+    int sig;
+    sigwait(&paro, &sig);
+    fprintf(stderr, "Señal %d: cerrando %s\n", sig, ruta);
+
+    // Los hilos parados en accept salen al cerrar el socket y los que atienden
+    // una conexión, al cortársela
+    atomic_store(&parar, 1);
+    shutdown(s, SHUT_RDWR);
+    for (int i = 0; i < lanzados; ++i) {
+        int c = atomic_load(&estado[i].conexion);
+        if (c >= 0) shutdown(c, SHUT_RDWR);
+    }
+    for (int i = 0; i < lanzados; ++i) {
+        pthread_join(th[i], NULL);
+        hilo_liberar(&estado[i]);
+    }
+    close(s);
+    unlink(ruta);
+    free(estado);
+    free(th);
+    return 0;
+}
+
+int servicio_conectar(const char *ruta) {
+    if (!ruta) ruta = SERV_SOCKET;
+    struct sockaddr_un dir;
+    memset(&dir, 0, sizeof(dir));
+    dir.sun_family = AF_UNIX;
+    if (strlen(ruta) >= sizeof(dir.sun_path)) return -1;
+    strcpy(dir.sun_path, ruta);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr *)&dir, sizeof(dir)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int servicio_pedir(int fd, const ServPeticion *p, const char *clave, const void *datos,
+                   unsigned char **resp, size_t *cap, size_t *resp_len) {
+    ServRespuesta r;
+    if (escribir_todo(fd, p, sizeof(*p)) < 0 || escribir_todo(fd, clave, p->clave_len) < 0 ||
+        escribir_todo(fd, datos, p->datos_len) < 0 || leer_todo(fd, &r, sizeof(r)) < 0)
+        return -1;
+    if (r.datos_len > *cap) {
+        unsigned char *n = realloc(*resp, r.datos_len);
+        if (!n) return -1;
+        *resp = n;
+        *cap = r.datos_len;
+    }
+    if (leer_todo(fd, *resp, r.datos_len) < 0) return -1;
+    *resp_len = r.datos_len;
+    return (int)r.estado;
+}
@@ -0,0 +1,291 @@
+#include "triaje.h"
+#include "afin_modificado.h"
+#include "alfabeto.h"
+#include "criptoAnalisisVigenere.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TRIAJE_CHUNK 65536
+#define TRIAJE_RAROS 0.05     // fracción de bytes que no son texto a partir de la cual es binario
+#define TRIAJE_FORMATO 0.05   // fracción de formato a partir de la cual se ha conservado
+#define TRIAJE_CHI2_CLARO 0.5 // χ² por letra por debajo del cual es texto en claro
+#define TRIAJE_BLOQUE_BYTES 1.5 // IC de la última columna frente al global en afin_mod de bytes
+#define TRIAJE_P_MIN 1e-4     // probabilidad mínima de una letra (evita dividir por 0)
+#define P_ENYE 0.0031         // frecuencia de la Ñ en español
+
+/* Byte -> 1 + índice en A-N, Ñ, O-Z (0 = no es letra ASCII) */
+static unsigned char LETRA[256];
+static pthread_once_t letra_once = PTHREAD_ONCE_INIT;
+
+static void letra_init(void) {
+    for (int c = 0; c < 26; ++c) {
+        unsigned char i = (unsigned char)(1 + c + (c >= 14)); // de la O en adelante, tras la Ñ
+        LETRA['A' + c] = LETRA['a' + c] = i;
+    }
+}
+
+const char *triaje_nombre(TriajeTipo tipo) {
+    switch (tipo) {
+    case TRIAJE_CORTO: return "corto";
+    case TRIAJE_CLARO: return "claro";
+    case TRIAJE_AFIN: return "afin";
+    case TRIAJE_VIGENERE: return "vigenere";
+    case TRIAJE_BLOQUES: return "afin_mod";
+    case TRIAJE_DESCONOCIDO: return "desconocido";
+    default: return "error";
+    }
+}
+
+/* Probabilidades del idioma en el alfabeto de m = 26 o 27 símbolos */
+static double probs_alfabeto(const char *lang, int m, double *P) {
+    double P26[26];
+    double ic = load_language_probs(lang, P26);
+    if (m == 26) {
+        memcpy(P, P26, sizeof(P26));
+        return ic;
+    }
+    for (int c = 0; c < 26; ++c) P[c + (c >= 14)] = P26[c] * (1.0 - P_ENYE);
+    P[14] = P_ENYE;
+    return ic;
+}
+
+static double ic_hist(const uint64_t *h, int m) {
+    double N = 0.0, num = 0.0;
+    for (int j = 0; j < m; ++j) {
+        N += (double)h[j];
+        num += (double)h[j] * ((double)h[j] - 1.0);
+    }
+    return N >= 2.0 ? num / (N * (N - 1.0)) : 0.0;
+}
+
+/* χ² por letra de h (descifrado por la permutación y = perm[x]) frente a P */
+static double chi2_perm(const uint64_t *h, int m, const double *P, const int *perm) {
+    double N = 0.0, chi2 = 0.0;
+    for (int j = 0; j < m; ++j) N += (double)h[j];
+    if (N <= 0.0) return 0.0;
+    for (int x = 0; x < m; ++x) {
+        double E = N * (P[x] > TRIAJE_P_MIN ? P[x] : TRIAJE_P_MIN);
+        double d = (double)h[perm[x]] - E;
+        chi2 += d * d / E;
+    }
+    return chi2 / N;
+}
+
+/* IC medio de las n columnas de seq (índices de TRIAJE_SIMBOLOS) */
+static double ic_columnas(const unsigned char *seq, size_t len, int n, uint64_t (*col)[TRIAJE_SIMBOLOS]) {
+    memset(col, 0, (size_t)n * sizeof(*col));
+    for (size_t i = 0, c = 0; i < len; ++i) {
+        col[c][seq[i]]++;
+        if (++c == (size_t)n) c = 0;
+    }
+    double s = 0.0;
+    for (int c = 0; c < n; ++c) s += ic_hist(col[c], TRIAJE_SIMBOLOS);
+    return s / n;
+}
+
+/* IC de la última columna con periodo BLOCK_SIZE. afin_mod lee cada bloque como
+ * un número (el primer símbolo es el dígito más alto) y su dígito más bajo solo
+ * sufre y0 = a0·x0 + b0 mod m: esa columna conserva el IC del idioma aunque el
+ * resto del bloque quede plano. En un monoalfabético vale lo mismo que el IC
+ * global y en un Vigenère cuyo periodo no divide BLOCK_SIZE queda plana. */
+static double ic_ultima_columna(const unsigned char *seq, size_t len, int m) {
+    uint64_t h[256] = {0};
+    for (size_t i = BLOCK_SIZE - 1; i < len; i += BLOCK_SIZE) h[seq[i]]++;
+    return ic_hist(h, m);
+}
+
+/* Clasificación de un fichero binario (alfabeto bytes) */
+static void triaje_bytes(Triaje *t, const uint64_t *hb, const unsigned char *seq, size_t len) {
+    int distintos = 0;
+    for (int b = 0; b < 256; ++b) distintos += hb[b] != 0;
+    t->alf = ALF_BYTES;
+    t->simbolos = t->bytes;
+    t->ic = ic_hist(hb, 256);
+    t->ic_bloque = ic_ultima_columna(seq, len, 256);
+    t->cobertura = distintos / 256.0;
+    // Una sustitución de bytes conserva el IC del texto en todas las columnas
+    if (len >= TRIAJE_MIN_LETRAS && t->ic_bloque > TRIAJE_BLOQUE_BYTES * t->ic) t->tipo = TRIAJE_BLOQUES;
+    else if (t->ic > 3.0 / 256.0) t->tipo = TRIAJE_AFIN;
+    else t->tipo = TRIAJE_DESCONOCIDO;
+}
+
+int triaje_fichero(const char *ruta, const char *lang, Triaje *t) {
+    pthread_once(&letra_once, letra_init);
+    memset(t, 0, sizeof(*t));
+    t->tipo = TRIAJE_ERROR;
+    int fd = open(ruta, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && (uint64_t)st.st_size > TRIAJE_MAX_BYTES) t->truncado = 1;
+
+    // 1) Una pasada: bytes, símbolos, formato y las primeras letras en orden
+    unsigned char buf[TRIAJE_CHUNK], seq[TRIAJE_LETRAS], bseq[TRIAJE_LETRAS];
+    uint64_t hb[256] = {0}, hs[TRIAJE_SIMBOLOS] = {0};
+    uint64_t raros = 0, formato = 0;
+    size_t nseq = 0;
+    int prev = 0; // byte anterior si era el inicio de una secuencia UTF-8 de dos bytes
+    ssize_t got = 0;
+    while (t->bytes < TRIAJE_MAX_BYTES &&
+           (got = read(fd, buf, TRIAJE_MAX_BYTES - t->bytes < sizeof(buf) ? TRIAJE_MAX_BYTES - t->bytes
+                                                                            : sizeof(buf))) > 0) {
+        if (t->bytes < TRIAJE_LETRAS)
+            memcpy(bseq + t->bytes, buf, TRIAJE_LETRAS - t->bytes < (uint64_t)got ? TRIAJE_LETRAS - t->bytes
+                                                                                  : (size_t)got);
+        t->bytes += (uint64_t)got;
+        for (ssize_t i = 0; i < got; ++i) {
+            unsigned char b = buf[i];
+            hb[b]++;
+            int s = LETRA[b];
+            if (prev) {
+                int p = prev;
+                prev = 0;
+                if (b >= 0x80 && b < 0xC0) {
+                    if (p == 0xC3 && (b == 0x91 || b == 0xB1)) {
+                        s = 15; // Ñ / ñ
+                    } else {
+                        formato += 2; // letras acentuadas y demás texto UTF-8
+                        continue;
+                    }
+                } else {
+                    raros++; // inicio sin continuación: b se trata solo
+                }
+            }
+            if (!s && b >= 0xC2 && b <= 0xDF) {
+                prev = b;
+                continue;
+            }
+            if (s) {
+                hs[s - 1]++;
+                if (nseq < TRIAJE_LETRAS) seq[nseq++] = (unsigned char)(s - 1);
+            } else if (b >= 0x80 || b == 0x7F || (b < 0x20 && b != '\n' && b != '\r' && b != '\t')) {
+                raros++;
+            } else {
+                formato++;
+            }
+        }
+    }
+    close(fd);
+    if (got < 0) return -1;
+    if (prev) raros++;
+
+    t->formato = t->bytes ? (double)formato / (double)t->bytes : 0.0;
+    if (t->bytes && (double)raros > TRIAJE_RAROS * (double)t->bytes) {
+        triaje_bytes(t, hb, bseq, t->bytes < TRIAJE_LETRAS ? (size_t)t->bytes : TRIAJE_LETRAS);
+        return 0;
+    }
+
+    // 2) Alfabeto: es27 si aparece la Ñ; el histograma queda en sus índices
+    int m = hs[14] ? 27 : 26;
+    t->alf = m == 27 ? ALF_ES27 : ALF_LATIN26;
+    for (int j = 0, k = 0; j < TRIAJE_SIMBOLOS; ++j) {
+        if (m == 26 && j == 14) continue;
+        t->hist[k++] = hs[j];
+        t->simbolos += hs[j];
+        t->cobertura += hs[j] != 0;
+    }
+    t->cobertura /= m;
+    if (t->simbolos < TRIAJE_MIN_LETRAS) {
+        t->tipo = TRIAJE_CORTO;
+        return 0;
+    }
+
+    double P[TRIAJE_SIMBOLOS];
+    double ic_lang = probs_alfabeto(lang, m, P);
+    int id[TRIAJE_SIMBOLOS];
+    for (int x = 0; x < m; ++x) id[x] = x;
+    t->ic = ic_hist(t->hist, m);
+    t->chi2 = chi2_perm(t->hist, m, P, id);
+    t->ic_bloque = ic_ultima_columna(seq, nseq, TRIAJE_SIMBOLOS);
+    double umbral = (ic_lang + 1.0 / m) / 2.0;
+
+    // 3) Monoalfabético: claro, afín o (si conserva el formato) Vigenère de periodo 1
+    if (t->ic >= umbral) {
+        t->ic_periodo = t->ic;
+        if (t->chi2 < TRIAJE_CHI2_CLARO) t->tipo = TRIAJE_CLARO;
+        else if (t->formato > TRIAJE_FORMATO) t->tipo = TRIAJE_VIGENERE, t->periodo = 1;
+        else t->tipo = TRIAJE_AFIN;
+        return 0;
+    }
+
+    // 4) IC plano: el primer n cuyas columnas recuperan el IC del idioma es el periodo
+    uint64_t col[TRIAJE_MAX_N][TRIAJE_SIMBOLOS];
+    for (int n = 2; n <= TRIAJE_MAX_N && (size_t)n * 2 <= nseq; ++n) {
+        double icn = ic_columnas(seq, nseq, n, col);
+        if (icn > t->ic_periodo) t->ic_periodo = icn;
+        if (icn >= umbral) {
+            t->ic_periodo = icn;
+            t->tipo = TRIAJE_VIGENERE;
+            t->periodo = n;
+            return 0;
+        }
+    }
+    // 5) Sin periodo: afin_mod deja el dígito bajo de cada bloque sin mezclar
+    if (t->formato > TRIAJE_FORMATO) t->tipo = TRIAJE_VIGENERE; // clave más larga que TRIAJE_MAX_N
+    else if (t->ic_bloque >= umbral) t->tipo = TRIAJE_BLOQUES;
+    else t->tipo = TRIAJE_DESCONOCIDO;
+    return 0;
+}
+
+typedef struct {
+    char *const *rutas;
+    int n;
+    const char *lang;
+    Triaje *res;
+    atomic_int siguiente;
+} TriajeTrabajo;
+
+static void *triaje_hilo(void *arg) {
+    TriajeTrabajo *w = arg;
+    int i;
+    while ((i = atomic_fetch_add(&w->siguiente, 1)) < w->n) triaje_fichero(w->rutas[i], w->lang, &w->res[i]);
+    return NULL;
+}
+
+void triaje_ficheros(char *const *rutas, int n, const char *lang, int hilos, Triaje *res) {
+    if (hilos <= 0) hilos = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (hilos < 1) hilos = 1;
+    if (hilos > n) hilos = n > 0 ? n : 1;
+    TriajeTrabajo w = { rutas, n, lang, res, 0 };
+    pthread_t *th = calloc((size_t)hilos, sizeof(pthread_t));
+    int lanzados = 0;
+    for (; th && lanzados < hilos - 1; ++lanzados)
+        if (pthread_create(&th[lanzados], NULL, triaje_hilo, &w) != 0) break;
+    triaje_hilo(&w); // este hilo también trabaja
+    for (int i = 0; i < lanzados; ++i) pthread_join(th[i], NULL);
+    free(th);
+}
+
+static int mcd_int(int a, int b) {
+    while (b) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+double afin_mono_ataque(const uint64_t *hist, int m, const char *lang, int *a, int *b) {
+    double P[TRIAJE_SIMBOLOS];
+    probs_alfabeto(lang, m, P);
+    double mejor = -1.0;
+    int perm[TRIAJE_SIMBOLOS];
+    for (int ka = 1; ka < m; ++ka) {
+        if (mcd_int(ka, m) != 1) continue;
+        for (int kb = 0; kb < m; ++kb) {
+            for (int x = 0; x < m; ++x) perm[x] = (ka * x + kb) % m; // letra x del claro cifrada
+            double c = chi2_perm(hist, m, P, perm);
+            if (mejor < 0.0 || c < mejor) {
+                mejor = c;
+                *a = ka;
+                *b = kb;
+            }
+        }
+    }
+    return mejor;
+}
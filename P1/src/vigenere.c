@@ -1,74 +1,128 @@
+#include "vigenere.h"
+#include "normalizar.h"
+#include "instr.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 
 #define ALPHABET_SIZE 26
 #define A 'A'
 
-void vigenere(char *text, const char *key, int encrypt) {
-    int klen = strlen(key);
-    int j = 0;
-    for (int i = 0; text[i] != '\0'; i++) {
-        char c = toupper((unsigned char)text[i]);
-        if (c >= 'A' && c <= 'Z') {
-            int pi = c - A;
-            int ki = toupper((unsigned char)key[j % klen]) - A;
-            int ci;
-            if (encrypt) {
-                ci = (pi + ki) % ALPHABET_SIZE;
-            } else {
-                ci = (pi - ki + ALPHABET_SIZE) % ALPHABET_SIZE;
-            }
+/*
+ * Núcleos sobre índices, uno por tamaño de alfabeto. El bucle interior
+ * recorre un tramo de la clave sin calcular j mod klen, así que se
+ * vectoriza; con M = 256 la resta desaparece (aritmética de un byte).
+ */
+#define DEFINIR_VIGENERE(sufijo, M)                                             \
+    static void vigenere_##sufijo(unsigned char *x, size_t n,                  \
+                                  const unsigned char *shift, int klen, int *pos) { \
+        size_t j = (size_t)*pos;                                                \
+        while (n > 0) {                                                         \
+            size_t tramo = (size_t)klen - j;                                    \
+            if (tramo > n) tramo = n;                                           \
+            const unsigned char *s = shift + j;                                 \
+            for (size_t i = 0; i < tramo; ++i) {                                \
+                unsigned v = (unsigned)x[i] + s[i];                             \
+                x[i] = (unsigned char)(v >= (M) ? v - (M) : v);                 \
+            }                                                                   \
+            x += tramo;                                                         \
+            n -= tramo;                                                         \
+            j += tramo;                                                         \
+            if (j == (size_t)klen) j = 0;                                       \
+        }                                                                       \
+        *pos = (int)j;                                                          \
+    }
+
+DEFINIR_VIGENERE(latin26, 26)
+DEFINIR_VIGENERE(es27, 27)
+DEFINIR_VIGENERE(bytes, 256)
+
+int vigenere_ctx_init(VigenereCtx *ctx, const char *key, int encrypt) {
+    ctx->klen = (int)strlen(key);
+    ctx->pos = 0;
+    ctx->shift = NULL;
+    ctx->alf = alfabeto_por_m(ALPHABET_SIZE);
+    ctx->nucleo = vigenere_latin26;
+    if (ctx->klen == 0) return -1;
+
+    // Desplazamientos de la clave precalculados (descifrar = sumar 26 - k)
+    ctx->shift = malloc(ctx->klen);
+    if (!ctx->shift) return -1;
+    for (int t = 0; t < ctx->klen; t++) {
+        int ki = TABLA_ASCII[(unsigned char)key[t]] - A;
+        if (ki < 0) ki = 0; // caracteres de la clave que no son letras: sin desplazamiento
+        ctx->shift[t] = (unsigned char)(encrypt ? ki : (ALPHABET_SIZE - ki) % ALPHABET_SIZE);
+    }
+    return 0;
+}
+
+void vigenere_ctx_aplicar(VigenereCtx *ctx, char *text, size_t len) {
+    INSTR_INICIO(t_vig);
+    long long letras = 0;
+    const unsigned char *shift = ctx->shift;
+    int j = ctx->pos, klen = ctx->klen;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = TABLA_ASCII[(unsigned char)text[i]];
+        if (c) {
+            int ci = (c - A) + shift[j];
+            if (ci >= ALPHABET_SIZE) ci -= ALPHABET_SIZE;
             text[i] = (char)(ci + A);
-            j++;
+            if (++j == klen) j = 0;
+            letras++;
         }
     }
+    ctx->pos = j;
+    INSTR_FIN(ETAPA_VIGENERE, t_vig, letras);
+    (void)letras;
 }
 
-int main(int argc, char *argv[]) {
-    int encrypt = -1;
-    char *key = NULL, *fin = NULL, *fout = NULL;
+void vigenere_ctx_saltar(VigenereCtx *ctx, uint64_t letras) {
+    ctx->pos = (int)(letras % (uint64_t)ctx->klen);
+}
 
-    for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "-C") == 0) {
-            encrypt = 1;
-        } else if (strcmp(argv[i], "-D") == 0) {
-            encrypt = 0;
-        } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
-            key = argv[++i];
-        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
-            fin = argv[++i];
-        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
-            fout = argv[++i];
-        } else {
-            fprintf(stderr, "Uso: %s {-C|-D} -k clave -i filein -o fileout\n", argv[0]);
-            return EXIT_FAILURE;
-        }
+/**
+ * @brief Prepara un Vigenère sobre índices del alfabeto alf.
+ *
+ * La clave se escribe en el propio alfabeto (con Ñ en es27, bytes
+ * cualesquiera en bytes); lo que no pertenece al alfabeto se ignora.
+ *
+ * @return 0 si la clave tiene algún símbolo válido, -1 si no.
+ */
+int vigenere_ctx_init_alf(VigenereCtx *ctx, const Alfabeto *alf, const char *key, int encrypt) {
+    ctx->pos = 0;
+    ctx->alf = alf;
+    ctx->shift = malloc(strlen(key) + 1);
+    if (!ctx->shift) return -1;
+    ctx->klen = (int)alf_indices_clave(alf, key, ctx->shift);
+    if (ctx->klen == 0) {
+        vigenere_ctx_free(ctx);
+        return -1;
     }
+    for (int t = 0; t < ctx->klen && !encrypt; t++)
+        ctx->shift[t] = (unsigned char)((alf->m - ctx->shift[t]) % alf->m);
 
-    if (encrypt == -1 || key == NULL) {
-        fprintf(stderr, "Debes indicar {-C|-D} y la clave con -k\n");
-        return EXIT_FAILURE;
+    switch (alf->id) {
+    case ALF_LATIN26: ctx->nucleo = vigenere_latin26; break;
+    case ALF_ES27:    ctx->nucleo = vigenere_es27;    break;
+    default:          ctx->nucleo = vigenere_bytes;   break;
     }
+    return 0;
+}
 
-    FILE *in = stdin, *out = stdout;
-    if (fin) {
-        in = fopen(fin, "r");
-        if (!in) { perror("Error abriendo input"); return EXIT_FAILURE; }
-    }
-    if (fout) {
-        out = fopen(fout, "w");
-        if (!out) { perror("Error abriendo output"); return EXIT_FAILURE; }
-    }
+void vigenere_ctx_indices(VigenereCtx *ctx, unsigned char *idx, size_t n) {
+    INSTR_INICIO(t_vig);
+    ctx->nucleo(idx, n, ctx->shift, ctx->klen, &ctx->pos);
+    INSTR_FIN(ETAPA_VIGENERE, t_vig, (long long)n);
+}
 
-    char buffer[4096];
-    while (fgets(buffer, sizeof(buffer), in)) {
-        vigenere(buffer, key, encrypt);
-        fputs(buffer, out);
-    }
+void vigenere_ctx_free(VigenereCtx *ctx) {
+    free(ctx->shift);
+    ctx->shift = NULL;
+}
 
-    if (in != stdin) fclose(in);
-    if (out != stdout) fclose(out);
-    return 0;
+void vigenere(char *text, const char *key, int encrypt) {
+    VigenereCtx ctx;
+    if (vigenere_ctx_init(&ctx, key, encrypt) < 0) return;
+    vigenere_ctx_aplicar(&ctx, text, strlen(text));
+    vigenere_ctx_free(&ctx);
 }